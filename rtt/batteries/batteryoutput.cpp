@@ -3,22 +3,129 @@
 namespace rtt {
 namespace batteries {
 
+const int BatteryOutput::DEFAULT_SPILL_KIB = 16 * 1024;
+
+BatteryOutput::BatteryOutput()
+    : scanner(OutputScanner::getDefault())
+{}
+
+BatteryOutput::BatteryOutput(std::shared_ptr<const OutputScanner> scanner)
+    : scanner(std::move(scanner))
+{}
+
+BatteryOutput::SpilledText::~SpilledText() {
+    if(mapped)
+        munmap(const_cast<char *>(mapped), mappedLength);
+    if(fd >= 0)
+        close(fd);
+}
+
+void BatteryOutput::setSpill(const std::string & dir, std::uint64_t threshold) {
+    spillDir = dir;
+    spillThreshold = threshold;
+}
+
+BatteryOutput BatteryOutput::getEmpty() const {
+    BatteryOutput empty (scanner);
+    empty.setSpill(spillDir, spillThreshold);
+    return empty;
+}
+
 void BatteryOutput::appendStdOut(const std::string & stdOut) {
-    detectionDone = false;
+    appendStdOut(stdOut.data(), stdOut.length());
+}
 
-    this->stdOut.append(stdOut);
+void BatteryOutput::appendStdOut(const char * data, size_t length) {
+    if(length == 0)
+        return;
+    if(!spilledStdOut && spillThreshold > 0 && getStdOutLength() + length > spillThreshold)
+        spillStdOut();
+
+    /* Only the appended data are scanned, detection doesn't
+     * need another pass over the whole output later */
+    if(spilledStdOut) {
+        appendSpilled(data, length);
+        scanTail.append(data, length);
+        scanner->scan(scanTail, scanState, errors, warnings);
+        /* Terminated lines were scanned, they are not needed anymore */
+        scanTail.erase(0, scanState.lineStart);
+        scanState.scanned -= scanState.lineStart;
+        scanState.lineStart = 0;
+    } else {
+        append(stdOut, data, length);
+        scanner->scan(*stdOut, scanState, errors, warnings);
+    }
 }
 
 void BatteryOutput::appendStdErr(const std::string & stdErr) {
-    this->stdErr.append(stdErr);
+    appendStdErr(stdErr.data(), stdErr.length());
+}
+
+void BatteryOutput::appendStdErr(const char * data, size_t length) {
+    append(stdErr, data, length);
+}
+
+void BatteryOutput::releaseStdOut() {
+    stdOut.reset();
+    spilledStdOut.reset();
+    scanTail.clear();
+    scanState = OutputScanner::State();
+}
+
+void BatteryOutput::setWallTime(double seconds) {
+    wallTime = seconds;
+}
+
+double BatteryOutput::getWallTime() const {
+    return wallTime;
+}
+
+void BatteryOutput::setResourceUsage(const ResourceUsage & usage) {
+    resourceUsage = usage;
+}
+
+ResourceUsage BatteryOutput::getResourceUsage() const {
+    return resourceUsage;
 }
 
-std::string BatteryOutput::getStdOut() const {
-    return stdOut;
+void BatteryOutput::setExitCode(int exitCode) {
+    this->exitCode = exitCode;
 }
 
-std::string BatteryOutput::getStdErr() const {
-    return stdErr;
+int BatteryOutput::getExitCode() const {
+    return exitCode;
+}
+
+const char * BatteryOutput::getStdOutData() const {
+    if(!spilledStdOut)
+        return stdOut ? stdOut->data() : "";
+
+    std::lock_guard<std::mutex> l (spilledStdOut->mapped_mux);
+    if(!spilledStdOut->mapped) {
+        void * mapped = mmap(nullptr, spilledStdOut->length, PROT_READ, MAP_SHARED,
+                             spilledStdOut->fd, 0);
+        if(mapped == MAP_FAILED)
+            throw std::runtime_error("can't map spilled standard output: " +
+                                     std::string(strerror(errno)));
+        spilledStdOut->mapped = static_cast<const char *>(mapped);
+        spilledStdOut->mappedLength = spilledStdOut->length;
+    }
+    return spilledStdOut->mapped;
+}
+
+size_t BatteryOutput::getStdOutLength() const {
+    if(spilledStdOut)
+        return spilledStdOut->length;
+    return stdOut ? stdOut->length() : 0;
+}
+
+bool BatteryOutput::isStdOutSpilled() const {
+    return spilledStdOut != nullptr;
+}
+
+const std::string & BatteryOutput::getStdErr() const {
+    static const std::string empty;
+    return stdErr ? *stdErr : empty;
 }
 
 std::vector<std::string> BatteryOutput::getErrors() const {
@@ -29,38 +136,94 @@ std::vector<std::string> BatteryOutput::getWarnings() const {
     return warnings;
 }
 
-void BatteryOutput::doDetection() {
-    detectErrsWarnsInStdOut();
+const std::shared_ptr<const OutputScanner> & BatteryOutput::getScanner() const {
+    return scanner;
 }
 
-void BatteryOutput::detectErrsWarnsInStdOut() {
-    if(detectionDone)
+void BatteryOutput::append(std::shared_ptr<std::string> & text,
+                           const char * data, size_t length) {
+    if(length == 0)
         return;
+    if(!text)
+        text = std::make_shared<std::string>();
+    else if(text.use_count() > 1)
+        text = std::make_shared<std::string>(*text);
+    text->append(data, length);
+}
 
-    /* Detect warnings and errors here.
-     * Detection happens only in stdOut variable. */
-    static const std::regex RE_ERR ("\\s*(.*?error.*?)\\n", std::regex::icase);
-    static const std::regex RE_WARN ("\\s*(.*?warning.*?)\\n", std::regex::icase);
-
-    std::smatch match;
-    auto end =       std::sregex_iterator();
-    auto errBegin =  std::sregex_iterator(stdOut.begin() , stdOut.end(), RE_ERR);
-    auto warnBegin = std::sregex_iterator(stdOut.begin() , stdOut.end(), RE_WARN);
-
-    errors.clear();
-    warnings.clear();
-
-    for( ; errBegin != end ; ++errBegin) {
-        match = *errBegin;
-        errors.push_back(match[1].str());
+void BatteryOutput::spillStdOut() {
+    int fd = createSpillFile();
+    if(fd < 0 || (stdOut && !writeAll(fd, stdOut->data(), stdOut->length()))) {
+        warnings.push_back("standard output is kept in memory, it can't be written into " +
+                           spillDir + ": " + strerror(errno));
+        if(fd >= 0)
+            close(fd);
+        spillThreshold = 0;
+        return;
+    }
+    spilledStdOut = std::make_shared<SpilledText>();
+    spilledStdOut->fd = fd;
+    if(stdOut) {
+        spilledStdOut->length = stdOut->length();
+        /* Scan continues from the unterminated line */
+        scanTail = stdOut->substr(scanState.lineStart);
+        scanState.scanned -= scanState.lineStart;
+        scanState.lineStart = 0;
     }
+    stdOut.reset();
+}
 
-    for( ; warnBegin != end ; ++ warnBegin) {
-        match = *warnBegin;
-        warnings.push_back(match[1].str());
+void BatteryOutput::appendSpilled(const char * data, size_t length) {
+    if(spilledStdOut.use_count() > 1) {
+        auto copy = std::make_shared<SpilledText>();
+        copy->fd = createSpillFile();
+        if(copy->fd >= 0 && writeAll(copy->fd, getStdOutData(), spilledStdOut->length)) {
+            copy->length = spilledStdOut->length;
+            copy->complete = spilledStdOut->complete;
+        } else {
+            errors.push_back("standard output is lost, it can't be copied into " +
+                             spillDir + ": " + strerror(errno));
+            copy->complete = false;
+        }
+        spilledStdOut = std::move(copy);
+    }
+    SpilledText & text = *spilledStdOut;
+    if(text.mapped) {
+        munmap(const_cast<char *>(text.mapped), text.mappedLength);
+        text.mapped = nullptr;
+    }
+    if(!text.complete)
+        return;
+    if(!writeAll(text.fd, data, length)) {
+        /* Parsers get the output written so far, result of the test is incomplete */
+        errors.push_back("standard output is truncated, it can't be written into " +
+                         spillDir + ": " + strerror(errno));
+        text.complete = false;
+        return;
     }
+    text.length += length;
+}
 
-    detectionDone = true;
+int BatteryOutput::createSpillFile() const {
+    std::string path = spillDir + "rtt-output-XXXXXX";
+    int fd = mkostemp(&path[0], O_CLOEXEC);
+    /* File is removed at once, it exists only while the output holds it */
+    if(fd >= 0)
+        unlink(path.c_str());
+    return fd;
+}
+
+bool BatteryOutput::writeAll(int fd, const char * data, size_t length) {
+    while(length > 0) {
+        ssize_t written = write(fd, data, length);
+        if(written < 0 && errno == EINTR)
+            continue;
+        if(written <= 0)
+            return false;
+        data += written;
+        length -= written;
+    }
+    return true;
 }
 
 } // namespace batteries
@@ -1,22 +1,80 @@
 #ifndef RTT_BATTERIES_BATTERYOUTPUT_H
 #define RTT_BATTERIES_BATTERYOUTPUT_H
 
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <string>
 #include <vector>
-#include <regex>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#include "rtt/batteries/outputscanner-batt.h"
 
 namespace rtt {
 namespace batteries {
 
+/**
+ * @brief The ResourceUsage struct Resources consumed by the battery process
+ * and its children, as reported by the kernel when the process is reaped.
+ */
+struct ResourceUsage {
+    /* False if the output wasn't produced by executed process (e.g. it was cached) */
+    bool measured = false;
+    /* CPU time in seconds */
+    double userTime = 0;
+    double systemTime = 0;
+    /* Maximum resident set size in KiB */
+    long maxRss = 0;
+    /* Bytes passed through read and write calls, zero if not available */
+    std::uint64_t readBytes = 0;
+    std::uint64_t writtenBytes = 0;
+};
+
 /**
  * @brief The BatteryOutput class Class for storing output from executed battery.
- * After calling get functions on errors and warnings, string stdOut is checked for
- * lines containing "error" or "warning" (case insensitive) and if any lines are found,
- * they are also stored in variables errors and warnings respectively.
+ * Standard output is scanned for lines containing "error" or "warning" (case
+ * insensitive) or other patterns of its scanner as it is appended, such lines
+ * are stored in variables errors and warnings respectively.
+ * Copies of the output share the text of standard and error output, text is
+ * copied only when shared output is appended to.
+ * Standard output that grows over the spill threshold is moved into unlinked
+ * file in the spill directory and appended there, only its last unterminated
+ * line is kept in memory for the scanner. Spilled output is mapped from the
+ * file when it is read, its pages are then reclaimable page cache.
  */
 class BatteryOutput {
 public:
-    BatteryOutput() {}
+    /* Spill threshold in KiB, when not set */
+    static const int DEFAULT_SPILL_KIB;
+
+    /**
+     * @brief BatteryOutput Creates empty output scanned by the default scanner
+     */
+    BatteryOutput();
+
+    /**
+     * @brief BatteryOutput Creates empty output
+     * @param scanner Scanner of errors and warnings in standard output
+     */
+    explicit BatteryOutput(std::shared_ptr<const OutputScanner> scanner);
+
+    /**
+     * @brief setSpill Sets where large standard output is moved. Must be called
+     * before anything is appended.
+     * @param dir Directory of the spill files
+     * @param threshold Standard output larger than this (in bytes) is moved
+     * into file, it is never moved if 0
+     */
+    void setSpill(const std::string & dir, std::uint64_t threshold);
+
+    /**
+     * @brief getEmpty
+     * @return Empty output with the same scanner and spill settings
+     */
+    BatteryOutput getEmpty() const;
 
     /**
      * @brief appendStdOut Add string to standard output
@@ -24,23 +82,93 @@ public:
      */
     void appendStdOut(const std::string & stdOut);
 
+    /**
+     * @brief appendStdOut Add data to standard output
+     * @param data
+     * @param length Length of the data in bytes
+     */
+    void appendStdOut(const char * data, size_t length);
+
     /**
      * @brief appendStdErr Add string to error output
      * @param stdErr
      */
     void appendStdErr(const std::string & stdErr);
 
+    /**
+     * @brief appendStdErr Add data to error output
+     * @param data
+     * @param length Length of the data in bytes
+     */
+    void appendStdErr(const char * data, size_t length);
+
+    /**
+     * @brief releaseStdOut Drops the raw standard output once it isn't needed,
+     * errors and warnings detected in it are kept.
+     */
+    void releaseStdOut();
+
+    /**
+     * @brief setWallTime Set wall clock time of the execution
+     * @param seconds
+     */
+    void setWallTime(double seconds);
+
+    /**
+     * @brief getWallTime
+     * @return Wall clock time of the execution in seconds
+     */
+    double getWallTime() const;
+
+    /**
+     * @brief setResourceUsage Set resources consumed by the process
+     * @param usage
+     */
+    void setResourceUsage(const ResourceUsage & usage);
+
+    /**
+     * @brief getResourceUsage
+     * @return Resources consumed by the process
+     */
+    ResourceUsage getResourceUsage() const;
+
+    /**
+     * @brief setExitCode Set exit status of the process
+     * @param exitCode Status as returned by wait
+     */
+    void setExitCode(int exitCode);
+
+    /**
+     * @brief getExitCode
+     * @return Exit status of the process as returned by wait,
+     * -1 if the process wasn't executed
+     */
+    int getExitCode() const;
+
     /**
      * @brief getStdErr
      * @return Raw error output
      */
-    std::string getStdErr() const;
+    const std::string & getStdErr() const;
+
+    /**
+     * @brief getStdOutData Spilled output is mapped from its file by the first call.
+     * Data are valid until the output is appended to, released or destroyed.
+     * @return Raw standard output, not terminated by zero
+     */
+    const char * getStdOutData() const;
+
+    /**
+     * @brief getStdOutLength
+     * @return Length of raw standard output in bytes
+     */
+    size_t getStdOutLength() const;
 
     /**
-     * @brief getStdOut
-     * @return Raw standard output
+     * @brief isStdOutSpilled
+     * @return True if standard output was moved into file
      */
-    std::string getStdOut() const;
+    bool isStdOutSpilled() const;
 
     /**
      * @brief getErrors
@@ -55,20 +183,56 @@ public:
     std::vector<std::string> getWarnings() const;
 
     /**
-     * @brief doDetection This will force detection. Detection is time heavy
-     * operation and should be done inside test threads
-     * instead of running it via getter later.
+     * @brief getScanner
+     * @return Scanner of errors and warnings in standard output
      */
-    void doDetection();
+    const std::shared_ptr<const OutputScanner> & getScanner() const;
 
 private:
-    bool detectionDone = false;
-    std::string stdOut;
-    std::string stdErr;
+    /* Standard output moved into unlinked file */
+    struct SpilledText {
+        int fd = -1;
+        size_t length = 0;
+        /* False after failed write, rest of the output is dropped */
+        bool complete = true;
+        /* Mapping of the file, created when the text is read */
+        const char * mapped = nullptr;
+        size_t mappedLength = 0;
+        std::mutex mapped_mux;
+
+        ~SpilledText();
+    };
+
+    double wallTime = 0;
+    int exitCode = -1;
+    ResourceUsage resourceUsage;
+    /* Shared by copies of the output, null if empty */
+    std::shared_ptr<std::string> stdOut;
+    std::shared_ptr<std::string> stdErr;
+    std::shared_ptr<SpilledText> spilledStdOut;
+    std::string spillDir;
+    std::uint64_t spillThreshold = 0;
+    /* Unterminated last line of spilled standard output, scanner continues from it */
+    std::string scanTail;
     std::vector<std::string> errors;
     std::vector<std::string> warnings;
+    std::shared_ptr<const OutputScanner> scanner;
+    OutputScanner::State scanState;
+
+    /* Appends to the text, text shared with other copies is copied first */
+    static void append(std::shared_ptr<std::string> & text, const char * data, size_t length);
+
+    /* Moves standard output into new spill file, keeps it in memory on failure */
+    void spillStdOut();
+
+    /* Appends to the spill file, file shared with other copies is copied first */
+    void appendSpilled(const char * data, size_t length);
+
+    /* Creates unlinked file in the spill directory, returns -1 on failure */
+    int createSpillFile() const;
 
-    void detectErrsWarnsInStdOut();
+    /* Writes whole data into the file, returns false on failure */
+    static bool writeAll(int fd, const char * data, size_t length);
 };
 
 } // namespace batteries
@@ -28,6 +28,7 @@ const std::string Configuration::TAGNAME_BIT_R              = "bit-r";
 const std::string Configuration::TAGNAME_BIT_S              = "bit-s";
 const std::string Configuration::TAGNAME_BIT_W              = "bit-w";
 const std::string Configuration::TAGNAME_PARAMS             = "parameters";
+const std::string Configuration::TAGNAME_TIMEOUT            = "timeout-seconds";
 
 const std::string Configuration::objectInfo = "Battery Configuration";
 
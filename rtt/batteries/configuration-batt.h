@@ -54,6 +54,7 @@ public:
     static const std::string TAGNAME_BIT_S;
     static const std::string TAGNAME_BIT_W;
     static const std::string TAGNAME_PARAMS;
+    static const std::string TAGNAME_TIMEOUT;
 
     /* Constant set to integer values that weren't set */
     static const int VALUE_INT_NOT_SET = -1;
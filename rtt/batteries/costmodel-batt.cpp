@@ -0,0 +1,255 @@
+#include "costmodel-batt.h"
+
+namespace rtt {
+namespace batteries {
+
+const std::string CostModel::JSON_ENTRIES       = "runtime-history";
+const std::string CostModel::JSON_BATTERY       = "battery";
+const std::string CostModel::JSON_SECONDS       = "seconds";
+const std::string CostModel::JSON_COST          = "cost-estimate";
+const std::string CostModel::JSON_RUNS          = "runs";
+const std::string CostModel::JSON_MAX_RSS       = "max-rss-kib";
+const std::string CostModel::JSON_READ_BYTES    = "read-bytes";
+const double      CostModel::NEW_RUNTIME_WEIGHT = 0.5;
+
+const std::string CostModel::objectInfo = "Cost model";
+
+std::mutex CostModel::save_mux;
+
+std::unique_ptr<CostModel> CostModel::getInstance(Logger * logger,
+                                                  const std::string & historyFile) {
+    std::unique_ptr<CostModel> cm (new CostModel());
+    cm->logger = logger;
+    cm->historyFile = historyFile;
+    {
+        std::lock_guard<std::mutex> l (save_mux);
+        cm->history = loadHistory(logger, historyFile);
+    }
+    cm->computeBatteryTotals();
+    return cm;
+}
+
+double CostModel::predictRuntime(const IVariant * variant) const {
+    const auto & entries = history.at(JSON_ENTRIES);
+    auto entry = entries.find(getHistoryKey(variant));
+    if(entry != entries.end() && entry->count(JSON_SECONDS) == 1)
+        return entry->at(JSON_SECONDS).get<double>();
+
+    /* No history for the variant, static estimate is converted by the rate of its
+     * battery. Estimates of different batteries are in different units, so there
+     * is no prediction without the rate. */
+    return variant->getCostEstimate() * getBatteryRate(variant->getBattery().getShortName());
+}
+
+bool CostModel::isRuntimeMeasured(const IVariant * variant) const {
+    if(hasRuntimeHistory(variant))
+        return true;
+
+    return getBatteryRate(variant->getBattery().getShortName()) > 0;
+}
+
+bool CostModel::hasRuntimeHistory(const IVariant * variant) const {
+    const auto & entries = history.at(JSON_ENTRIES);
+    auto entry = entries.find(getHistoryKey(variant));
+    return entry != entries.end() && entry->count(JSON_SECONDS) == 1;
+}
+
+void CostModel::orderLongestFirst(std::vector<IVariant *> & variants) const {
+    /* Static estimates of battery without history are comparable only with each
+     * other, they are scaled by the largest estimate of the battery. */
+    std::map<std::string, double> largestEstimates;
+    for(const IVariant * v : variants) {
+        if(isRuntimeMeasured(v))
+            continue;
+        double & largest = largestEstimates[v->getBattery().getShortName()];
+        largest = std::max(largest, v->getCostEstimate());
+    }
+    /* Unmeasured variants first, then longest first within each group */
+    std::map<const IVariant *, std::pair<bool, double>> predictions;
+    for(const IVariant * v : variants) {
+        if(isRuntimeMeasured(v)) {
+            predictions[v] = { true, predictRuntime(v) };
+        } else {
+            double largest = largestEstimates.at(v->getBattery().getShortName());
+            predictions[v] = { false, largest > 0 ? v->getCostEstimate() / largest : 0 };
+        }
+    }
+
+    std::stable_sort(variants.begin(), variants.end(),
+                     [&](const IVariant * lhs, const IVariant * rhs) {
+        const auto & l = predictions.at(lhs);
+        const auto & r = predictions.at(rhs);
+        if(l.first != r.first)
+            return r.first;
+        return l.second > r.second;
+    });
+}
+
+double CostModel::predictMakespan(const std::vector<IVariant *> & variants,
+                                  int maxThreads) const {
+    /* Times when slots become free, smallest on top */
+    std::priority_queue<double, std::vector<double>, std::greater<double>> slots;
+    for(int i = 0 ; i < std::max(maxThreads, 1) ; ++i)
+        slots.push(0);
+
+    double makespan = 0;
+    for(const IVariant * v : variants) {
+        double finish = slots.top() + predictRuntime(v);
+        slots.pop();
+        slots.push(finish);
+        makespan = std::max(makespan, finish);
+    }
+    return makespan;
+}
+
+void CostModel::recordRuntime(const IVariant * variant, double seconds) {
+    auto batteryShort = variant->getBattery().getShortName();
+    auto & totals = batteryTotals[batteryShort];
+    auto key = getHistoryKey(variant);
+    recordedKeys.insert(key);
+    auto & entry = history[JSON_ENTRIES][key];
+    if(entry.count(JSON_SECONDS) == 0) {
+        entry[JSON_BATTERY] = batteryShort;
+        entry[JSON_SECONDS] = seconds;
+        entry[JSON_RUNS] = 1;
+    } else {
+        totals.first -= entry[JSON_SECONDS].get<double>();
+        totals.second -= entry[JSON_COST].get<double>();
+        entry[JSON_SECONDS] = NEW_RUNTIME_WEIGHT * seconds +
+                              (1 - NEW_RUNTIME_WEIGHT) * entry[JSON_SECONDS].get<double>();
+        entry[JSON_RUNS] = entry[JSON_RUNS].get<int>() + 1;
+    }
+    entry[JSON_COST] = variant->getCostEstimate();
+    totals.first += entry[JSON_SECONDS].get<double>();
+    totals.second += entry[JSON_COST].get<double>();
+}
+
+long CostModel::predictPeakMemory(const IVariant * variant) const {
+    const auto & entries = history.at(JSON_ENTRIES);
+    auto entry = entries.find(getHistoryKey(variant));
+    if(entry != entries.end() && entry->count(JSON_MAX_RSS) == 1)
+        return entry->at(JSON_MAX_RSS).get<long>();
+
+    /* Other settings or input size of the same test, largest is used */
+    long peak = 0;
+    std::string prefix = getTestKeyPrefix(variant);
+    for(auto it = entries.begin() ; it != entries.end() ; ++it) {
+        if(it.key().compare(0, prefix.length(), prefix) == 0 && it->count(JSON_MAX_RSS) == 1)
+            peak = std::max(peak, it->at(JSON_MAX_RSS).get<long>());
+    }
+    return peak;
+}
+
+void CostModel::recordPeakMemory(const IVariant * variant, long maxRss) {
+    auto key = getHistoryKey(variant);
+    recordedKeys.insert(key);
+    auto & entry = history[JSON_ENTRIES][key];
+    if(entry.count(JSON_MAX_RSS) == 0 || entry[JSON_MAX_RSS].get<long>() < maxRss)
+        entry[JSON_MAX_RSS] = maxRss;
+}
+
+std::uint64_t CostModel::predictInputDemand(const IVariant * variant) const {
+    if(variant->getInputDemand() > 0)
+        return variant->getInputDemand();
+
+    /* Measured amount includes everything the process read, not only the input */
+    const auto & entries = history.at(JSON_ENTRIES);
+    auto entry = entries.find(getHistoryKey(variant));
+    if(entry != entries.end() && entry->count(JSON_READ_BYTES) == 1)
+        return entry->at(JSON_READ_BYTES).get<std::uint64_t>();
+
+    return 0;
+}
+
+void CostModel::recordInputDemand(const IVariant * variant, std::uint64_t readBytes) {
+    auto key = getHistoryKey(variant);
+    recordedKeys.insert(key);
+    auto & entry = history[JSON_ENTRIES][key];
+    if(entry.count(JSON_READ_BYTES) == 0 ||
+       entry[JSON_READ_BYTES].get<std::uint64_t>() < readBytes)
+        entry[JSON_READ_BYTES] = readBytes;
+}
+
+void CostModel::save() const {
+    if(historyFile.empty() || recordedKeys.empty())
+        return;
+
+    std::lock_guard<std::mutex> l (save_mux);
+    try {
+        /* Other execution of the process could save since the history was loaded,
+         * recorded entries replace the ones in the file. Other instances of the
+         * toolkit running at the same time can still overwrite each other. */
+        auto merged = loadHistory(logger, historyFile);
+        for(const auto & key : recordedKeys)
+            merged[JSON_ENTRIES][key] = history.at(JSON_ENTRIES).at(key);
+
+        /* Written under temporary name first, so that concurrently
+         * running instance won't read half written file. */
+        std::string tmpFile = historyFile + ".tmp" + Utils::itostr(getpid());
+        Utils::saveStringToFile(tmpFile, merged.dump(4));
+        if(rename(tmpFile.c_str(), historyFile.c_str()) != 0)
+            throw std::runtime_error("can't rename " + tmpFile);
+    } catch(std::exception & ex) {
+        logger->warn(objectInfo + ": can't write runtime history file " +
+                     historyFile + ": " + ex.what());
+    }
+}
+
+nlohmann::json CostModel::loadHistory(Logger * logger, const std::string & historyFile) {
+    nlohmann::json history = nlohmann::json::object();
+    history[JSON_ENTRIES] = nlohmann::json::object();
+    if(historyFile.empty() || !Utils::fileExist(historyFile))
+        return history;
+
+    try {
+        auto loaded = nlohmann::json::parse(Utils::readFileToString(historyFile));
+        if(loaded.count(JSON_ENTRIES) == 1 && loaded.at(JSON_ENTRIES).is_object())
+            history = loaded;
+    } catch(std::exception & ex) {
+        /* Broken history only disables the predictions */
+        logger->warn(objectInfo + ": can't read runtime history file " +
+                     historyFile + ": " + ex.what());
+    }
+    return history;
+}
+
+std::string CostModel::getHistoryKey(const IVariant * variant) {
+    std::stringstream key;
+    key << getTestKeyPrefix(variant);
+    for(const auto & setting : variant->getUserSettings())
+        key << setting.first << "=" << setting.second << ";";
+    key << "|";
+    try {
+        key << Utils::getFileSize(variant->getBinaryDataPath());
+    } catch(std::runtime_error &) {
+        /* Size stays unknown, variant will get its own history entry */
+    }
+    return key.str();
+}
+
+std::string CostModel::getTestKeyPrefix(const IVariant * variant) {
+    return variant->getBattery().getShortName() + "|" +
+           Utils::itostr(variant->getTestId()) + "|";
+}
+
+double CostModel::getBatteryRate(const std::string & batteryShort) const {
+    auto totals = batteryTotals.find(batteryShort);
+    if(totals == batteryTotals.end() || totals->second.second <= 0)
+        return 0;
+    return totals->second.first / totals->second.second;
+}
+
+void CostModel::computeBatteryTotals() {
+    batteryTotals.clear();
+    for(const auto & entry : history.at(JSON_ENTRIES)) {
+        if(entry.count(JSON_BATTERY) != 1 || entry.count(JSON_SECONDS) != 1 ||
+           entry.count(JSON_COST) != 1)
+            continue;
+        auto & totals = batteryTotals[entry.at(JSON_BATTERY).get<std::string>()];
+        totals.first += entry.at(JSON_SECONDS).get<double>();
+        totals.second += entry.at(JSON_COST).get<double>();
+    }
+}
+
+} // namespace batteries
+} // namespace rtt
@@ -0,0 +1,167 @@
+#ifndef RTT_BATTERIES_COSTMODEL_H
+#define RTT_BATTERIES_COSTMODEL_H
+
+#include <queue>
+#include <set>
+#include <mutex>
+
+#include "rtt/batteries/ivariant-batt.h"
+
+#include "libs/moderncppjson/json.hpp"
+
+namespace rtt {
+namespace batteries {
+
+/**
+ * @brief The CostModel class Predicts runtime of the variants. Keeps persistent history
+ * of runtimes per battery, test, variant settings and input size. When no history
+ * for a variant exists, static estimate of the variant is used, converted
+ * to seconds by ratio observed in history of the same battery.
+ */
+class CostModel {
+public:
+    /**
+     * @brief getInstance Creates model and loads runtime history.
+     * @param logger Logger pointer
+     * @param historyFile Path to history file, if empty, history is not persisted.
+     * @return Model
+     */
+    static std::unique_ptr<CostModel> getInstance(Logger * logger,
+                                                  const std::string & historyFile);
+
+    /**
+     * @brief predictRuntime
+     * @param variant
+     * @return Predicted runtime of the variant in seconds, 0 if neither
+     * the variant nor its battery has runtime history
+     */
+    double predictRuntime(const IVariant * variant) const;
+
+    /**
+     * @brief isRuntimeMeasured
+     * @param variant
+     * @return True if the predicted runtime is in seconds, i.e. the variant
+     * or other variants of its battery have runtime history
+     */
+    bool isRuntimeMeasured(const IVariant * variant) const;
+
+    /**
+     * @brief hasRuntimeHistory
+     * @param variant
+     * @return True if runtime of the variant itself was measured on input
+     * of the same size. Predictions of other variants are extrapolated from
+     * static estimates, they are fit for ordering only.
+     */
+    bool hasRuntimeHistory(const IVariant * variant) const;
+
+    /**
+     * @brief orderLongestFirst Sorts the variants by their predicted
+     * runtime, longest first. Variants without prediction are placed before
+     * the others, so that they aren't left running alone at the end, each
+     * battery's share is ordered by static estimates scaled to its largest one.
+     * Order of variants with equal prediction is kept.
+     * @param variants
+     */
+    void orderLongestFirst(std::vector<IVariant *> & variants) const;
+
+    /**
+     * @brief predictMakespan Simulates dispatching of the variants in given order
+     * into parallel slots, each variant goes to the slot that becomes free first.
+     * @param variants Variants in order of dispatch
+     * @param maxThreads Number of parallel slots
+     * @return Predicted time in seconds until all variants are finished
+     */
+    double predictMakespan(const std::vector<IVariant *> & variants,
+                           int maxThreads) const;
+
+    /**
+     * @brief recordRuntime Adds measured runtime of the variant into history
+     * @param variant
+     * @param seconds
+     */
+    void recordRuntime(const IVariant * variant, double seconds);
+
+    /**
+     * @brief predictPeakMemory Predicts peak memory of the variant. When no history
+     * for a variant exists, largest peak of the same test of the battery is used.
+     * @param variant
+     * @return Predicted maximum resident set size in KiB, 0 if unknown
+     */
+    long predictPeakMemory(const IVariant * variant) const;
+
+    /**
+     * @brief recordPeakMemory Adds measured peak memory of the variant into history.
+     * The largest measured value is kept.
+     * @param variant
+     * @param maxRss Maximum resident set size in KiB
+     */
+    void recordPeakMemory(const IVariant * variant, long maxRss);
+
+    /**
+     * @brief predictInputDemand Predicts amount of data read by the variant. Demand
+     * derived from the settings of the variant is used, otherwise largest
+     * amount read in history of the variant.
+     * @param variant
+     * @return Predicted bytes read by the variant, 0 if unknown
+     */
+    std::uint64_t predictInputDemand(const IVariant * variant) const;
+
+    /**
+     * @brief recordInputDemand Adds measured amount of data read by the variant
+     * into history. The largest measured value is kept.
+     * @param variant
+     * @param readBytes Bytes read by the process of the variant
+     */
+    void recordInputDemand(const IVariant * variant, std::uint64_t readBytes);
+
+    /**
+     * @brief save Writes the history into history file. Nothing is done
+     * if the model was created without one. Entries recorded by this model
+     * are merged into the current content of the file, so that models of
+     * executions running at the same time don't overwrite each other.
+     */
+    void save() const;
+
+private:
+    static const std::string JSON_ENTRIES;
+    static const std::string JSON_BATTERY;
+    static const std::string JSON_SECONDS;
+    static const std::string JSON_COST;
+    static const std::string JSON_RUNS;
+    static const std::string JSON_MAX_RSS;
+    static const std::string JSON_READ_BYTES;
+    /* Weight of the newest measurement in the stored average */
+    static const double NEW_RUNTIME_WEIGHT;
+
+    static const std::string objectInfo;
+
+    Logger * logger;
+    std::string historyFile;
+    nlohmann::json history;
+    /* Keys of entries recorded by this model, only these are saved */
+    std::set<std::string> recordedKeys;
+    /* Saves of all models in the process are serialized */
+    static std::mutex save_mux;
+    /* Sums of seconds and static estimates in history of each battery */
+    std::map<std::string, std::pair<double, double>> batteryTotals;
+
+    CostModel() {}
+
+    static nlohmann::json loadHistory(Logger * logger, const std::string & historyFile);
+
+    static std::string getHistoryKey(const IVariant * variant);
+
+    /* Prefix of history keys of all variants of the same test */
+    static std::string getTestKeyPrefix(const IVariant * variant);
+
+    /* Seconds per unit of static estimate of given battery,
+     * zero if battery has no history. */
+    double getBatteryRate(const std::string & batteryShort) const;
+
+    void computeBatteryTotals();
+};
+
+} // namespace batteries
+} // namespace rtt
+
+#endif // RTT_BATTERIES_COSTMODEL_H
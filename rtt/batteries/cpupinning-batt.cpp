@@ -0,0 +1,204 @@
+#include "cpupinning-batt.h"
+
+#include <algorithm>
+
+/* Memory policies of set_mempolicy/mbind, numaif.h is not required */
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+
+namespace rtt {
+namespace batteries {
+
+const std::string CpuPinning::POLICY_NONE    = "none";
+const std::string CpuPinning::POLICY_COMPACT = "compact";
+const std::string CpuPinning::POLICY_SCATTER = "scatter";
+const std::string CpuPinning::POLICY_NODE    = "node";
+const std::string CpuPinning::objectInfo     = "CPU pinning";
+
+std::unique_ptr<CpuPinning> CpuPinning::getInstance(Logger * logger,
+                                                    const std::string & policy) {
+    if(!isValidPolicy(policy))
+        raiseBugException("invalid CPU pinning policy: " + policy);
+
+    std::unique_ptr<CpuPinning> cp (new CpuPinning());
+    cp->logger = logger;
+    if(policy == POLICY_NONE)
+        return cp;
+
+    /* CPUs outside of the affinity of the toolkit (e.g. in container) are not used */
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool allowedKnown = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    auto nodes = getNumaNodes();
+    std::map<int, int> cpuNodes;
+    for(auto & node : nodes) {
+        auto & cpus = node.second;
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&](int cpu) {
+            return cpu >= CPU_SETSIZE || (allowedKnown && !CPU_ISSET(cpu, &allowed));
+        }), cpus.end());
+        for(int cpu : cpus)
+            cpuNodes[cpu] = node.first;
+    }
+    cp->nodeCount = nodes.size();
+
+    auto addSlot = [&](std::vector<int> cpus, int node) {
+        Slot slot;
+        slot.cpus = std::move(cpus);
+        slot.node = node;
+        cp->slots.push_back(std::move(slot));
+    };
+    if(policy == POLICY_COMPACT) {
+        for(const auto & node : nodes) {
+            for(int cpu : node.second)
+                addSlot({cpu}, node.first);
+        }
+    } else if(policy == POLICY_SCATTER) {
+        for(size_t i = 0 ; cp->slots.size() < cpuNodes.size() ; ++i) {
+            for(const auto & node : nodes) {
+                if(i < node.second.size())
+                    addSlot({node.second.at(i)}, node.first);
+            }
+        }
+    } else if(policy == POLICY_NODE) {
+        for(const auto & node : nodes) {
+            if(!node.second.empty())
+                addSlot(node.second, node.first);
+        }
+    } else {
+        for(int cpu : parseCpuList(policy)) {
+            if(cpuNodes.count(cpu) == 0)
+                logger->warn(objectInfo + ": CPU " + Utils::itostr(cpu) +
+                             " is not available, it won't be used");
+            else
+                addSlot({cpu}, cpuNodes.at(cpu));
+        }
+    }
+
+    if(cp->slots.empty())
+        logger->warn(objectInfo + ": no usable CPU was found, processes won't be pinned");
+    else
+        logger->info(objectInfo + ": processes are pinned by policy " + policy + " to " +
+                     Utils::itostr(cp->slots.size()) + " slots on " +
+                     Utils::itostr(cp->nodeCount) + " NUMA nodes");
+    return cp;
+}
+
+bool CpuPinning::isValidPolicy(const std::string & policy) {
+    if(policy == POLICY_NONE || policy == POLICY_COMPACT ||
+       policy == POLICY_SCATTER || policy == POLICY_NODE)
+        return true;
+    try {
+        return !parseCpuList(policy).empty();
+    } catch(std::runtime_error &) {
+        return false;
+    }
+}
+
+std::map<int, std::vector<int>> CpuPinning::getNumaNodes() {
+    const std::string nodeDir = "/sys/devices/system/node/";
+    std::map<int, std::vector<int>> nodes;
+    try {
+        for(int node : parseCpuList(Utils::readFileToString(nodeDir + "online"))) {
+            nodes[node] = parseCpuList(Utils::readFileToString(
+                              nodeDir + "node" + Utils::itostr(node) + "/cpulist"));
+        }
+    } catch(std::runtime_error &) {
+        nodes.clear();
+    }
+    if(!nodes.empty())
+        return nodes;
+
+    /* Kernel without NUMA support */
+    try {
+        nodes[0] = parseCpuList(Utils::readFileToString("/sys/devices/system/cpu/online"));
+    } catch(std::runtime_error &) {
+        for(long cpu = 0 ; cpu < sysconf(_SC_NPROCESSORS_ONLN) ; ++cpu)
+            nodes[0].push_back(cpu);
+    }
+    return nodes;
+}
+
+bool CpuPinning::isEnabled() const {
+    return !slots.empty();
+}
+
+int CpuPinning::bindThread(std::string & info) {
+    if(slots.empty())
+        return -1;
+
+    int slot = 0;
+    {
+        std::lock_guard<std::mutex> l (slots_mux);
+        /* First of the least used slots, slots are shared
+         * only when there are more processes than slots. */
+        slot = std::min_element(slots.begin(), slots.end(),
+                                [](const Slot & a, const Slot & b) {
+            return a.users < b.users;
+        }) - slots.begin();
+        ++slots.at(slot).users;
+    }
+
+    const Slot & s = slots.at(slot);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : s.cpus)
+        CPU_SET(cpu, &set);
+    /* Only calling thread is bound, not whole toolkit */
+    if(sched_setaffinity(0, sizeof(set), &set) != 0) {
+        logger->warn(objectInfo + ": can't bind thread to CPUs: " + strerror(errno));
+        releaseSlot(slot);
+        return -1;
+    }
+    if(nodeCount > 1 && !setPreferredNode(s.node))
+        logger->warn(objectInfo + ": can't set memory policy of thread: " + strerror(errno));
+
+    info = (s.cpus.size() == 1 ? "CPU " + Utils::itostr(s.cpus.front())
+                               : "CPUs of node " + Utils::itostr(s.node)) +
+           " (NUMA node " + Utils::itostr(s.node) + ")";
+    return slot;
+}
+
+void CpuPinning::releaseSlot(int slot) {
+    if(slot < 0)
+        return;
+
+    std::lock_guard<std::mutex> l (slots_mux);
+    --slots.at(slot).users;
+}
+
+bool CpuPinning::interleaveMemory(void * addr, size_t length) {
+    auto nodes = getNumaNodes();
+    if(nodes.size() < 2)
+        return false;
+
+    const size_t bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(nodes.rbegin()->first / bits + 1, 0);
+    for(const auto & node : nodes)
+        mask.at(node.first / bits) |= 1UL << (node.first % bits);
+    return syscall(SYS_mbind, addr, length, MPOL_INTERLEAVE,
+                   mask.data(), mask.size() * bits + 1, 0) == 0;
+}
+
+std::vector<int> CpuPinning::parseCpuList(const std::string & list) {
+    std::string ranges = list;
+    std::replace(ranges.begin(), ranges.end(), ',', ' ');
+    std::replace(ranges.begin(), ranges.end(), '\n', ' ');
+    std::vector<int> cpus = Utils::parseStringWithIntRanges(ranges);
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+bool CpuPinning::setPreferredNode(int node) {
+    const size_t bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(node / bits + 1, 0);
+    mask.at(node / bits) |= 1UL << (node % bits);
+    return syscall(SYS_set_mempolicy, MPOL_PREFERRED,
+                   mask.data(), mask.size() * bits + 1) == 0;
+}
+
+} // namespace batteries
+} // namespace rtt
@@ -0,0 +1,119 @@
+#ifndef RTT_BATTERIES_CPUPINNING_H
+#define RTT_BATTERIES_CPUPINNING_H
+
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "rtt/logger.h"
+#include "rtt/utils.h"
+#include "rtt/bugexception.h"
+
+namespace rtt {
+namespace batteries {
+
+/**
+ * @brief The CpuPinning class Binds battery processes to CPUs. Processes are spawned
+ * from the worker thread, so the worker binds itself to the chosen CPUs and to
+ * the NUMA node of these CPUs before spawning and the process inherits both.
+ * Memory allocated by the process is then preferably placed on the local node.
+ * Policy is one of:
+ *  compact - process is bound to single CPU, CPUs of one node are used first
+ *  scatter - process is bound to single CPU, consecutive processes alternate nodes
+ *  node    - process is bound to all CPUs of the least used node
+ *  list of CPUs (e.g. "0-7,16-23") - process is bound to single CPU from the list
+ */
+class CpuPinning {
+public:
+    static const std::string POLICY_NONE;
+    static const std::string POLICY_COMPACT;
+    static const std::string POLICY_SCATTER;
+    static const std::string POLICY_NODE;
+
+    /**
+     * @brief getInstance Creates pinning according to the policy and topology
+     * of the machine. Only CPUs that the toolkit is allowed to run on are used.
+     * @param logger Logger pointer
+     * @param policy One of POLICY_* or list of CPUs
+     * @return Pinning, disabled if policy is POLICY_NONE or no usable CPU was found
+     */
+    static std::unique_ptr<CpuPinning> getInstance(Logger * logger,
+                                                   const std::string & policy);
+
+    /**
+     * @brief isValidPolicy
+     * @param policy Policy from the settings
+     * @return True if policy is one of POLICY_* or valid list of CPUs
+     */
+    static bool isValidPolicy(const std::string & policy);
+
+    /**
+     * @brief getNumaNodes Reads CPUs of each NUMA node from sysfs. If the
+     * system doesn't provide topology, all CPUs belong to node 0.
+     * @return CPUs of each node
+     */
+    static std::map<int, std::vector<int>> getNumaNodes();
+
+    /**
+     * @brief isEnabled
+     * @return True if processes are pinned
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief bindThread Binds calling thread to the least used slot (CPU or node),
+     * processes spawned by the thread then run on the same CPUs.
+     * Slot must be released after the process ends.
+     * @param info Description of the slot will be stored here, for logging
+     * @return Slot index, -1 if pinning is disabled or the thread can't be bound
+     */
+    int bindThread(std::string & info);
+
+    /**
+     * @brief releaseSlot Frees slot returned by bindThread
+     * @param slot Slot index, -1 is ignored
+     */
+    void releaseSlot(int slot);
+
+    /**
+     * @brief interleaveMemory Spreads pages of the mapping evenly over all
+     * NUMA nodes, used for data that are read by processes on every node.
+     * Must be called before the pages are touched.
+     * @param addr Start of the mapping
+     * @param length Length of the mapping
+     * @return True if the policy was set, false on single node system or on error
+     */
+    static bool interleaveMemory(void * addr, size_t length);
+
+private:
+    static const std::string objectInfo;
+
+    /* CPUs assigned to one process at a time */
+    struct Slot {
+        std::vector<int> cpus;
+        int node = 0;
+        int users = 0;
+    };
+
+    Logger * logger;
+    /* Slots in order of preference */
+    std::vector<Slot> slots;
+    std::mutex slots_mux;
+    int nodeCount = 1;
+
+    CpuPinning() {}
+
+    /* Parses CPU list in format of sysfs, e.g. "0-3,8" */
+    static std::vector<int> parseCpuList(const std::string & list);
+
+    /* Sets preferred NUMA node of the memory allocated by the calling thread */
+    static bool setPreferredNode(int node);
+};
+
+} // namespace batteries
+} // namespace rtt
+
+#endif // RTT_BATTERIES_CPUPINNING_H
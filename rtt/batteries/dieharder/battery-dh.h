@@ -9,7 +9,9 @@ namespace dieharder {
 
 class Battery : public IBattery {
 public:
-    static std::unique_ptr<Battery> getInstance(const GlobalContainer & container);
+    static std::unique_ptr<Battery> getInstance(const GlobalContainer & container,
+                                               const BatteryArg & battery,
+                                               const std::string & binaryDataPath);
 
     std::vector<std::unique_ptr<ITestResult>> getTestResults() const;
 
@@ -20,8 +22,9 @@ private:
     ===============
     */
     /* So initialization in getInstance can't be avoided */
-    Battery(const GlobalContainer & container)
-        : IBattery(container) {}
+    Battery(const GlobalContainer & container, const BatteryArg & battery,
+            const std::string & binaryDataPath)
+        : IBattery(container, battery, binaryDataPath) {}
 };
 
 } // namespace dieharder
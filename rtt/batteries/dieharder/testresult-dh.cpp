@@ -1,5 +1,8 @@
 #include "testresult-dh.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace rtt {
 namespace batteries {
 namespace dieharder {
@@ -13,80 +16,96 @@ std::unique_ptr<TestResult> TestResult::getInstance(
                                        tests.at(0)->getLogger(),
                                        tests.at(0)->getLogicName()));
 
-    static const std::regex RE_PVALUE {
-        "\\+\\+\\+\\+([01]\\.[0-9]+?)\\+\\+\\+\\+\\n"
-    };
-    auto endIt = std::sregex_iterator();
+    /* Single test object processing */
+    for(const ITest * test : tests) {
+        /* Variants are usually parsed already, right after their execution.
+         * Cancelled variants have no output, results are partial. */
+        for(IVariant * variant : test->getVariants()) {
+            if(variant->isCancelled())
+                continue;
+            r->objectInfo = variant->getObjectInfo();
+            r->varRes.push_back(ITestResult::getVariantResult(variant));
+        }
+    }
+
+    return r;
+}
+
+result::VariantResult TestResult::parseVariant(const IVariant * variant) {
+    TestResult r (variant->getLogger(), "");
+    r.objectInfo = variant->getObjectInfo();
 
     std::vector<result::SubTestResult> tmpSubTestResults;
     std::vector<result::Statistic> tmpStatistics;
     std::vector<double> tmpPVals;
 
-    /* Single test object processing */
-    for(const ITest * test : tests) {
+    const BatteryOutput & variantOutput = variant->getBatteryOutput();
+    const char * outputBegin = variantOutput.getStdOutData();
+    const char * outputEnd = outputBegin + variantOutput.getStdOutLength();
 
-        /* Single variant processing */
-        for(const IVariant * variant : test->getVariants()) {
-            r->objectInfo = variant->getObjectInfo();
-            std::string variantOutput =
-                    variant->getBatteryOutput().getStdOut();
-
-            auto subTests = splitIntoSubTests(variantOutput);
-
-            if(subTests.empty())
-                r->logger->warn(r->objectInfo + ": no subtests extracted");
-
-            /* Single subtest processing! */
-            for(const std::string & subTest : subTests) {
-                auto pValIt = std::sregex_iterator(
-                                  subTest.begin(), subTest.end(),
-                                  RE_PVALUE);
-                if(std::distance(pValIt, endIt) == 0) {
-                    r->logger->warn(r->objectInfo +
-                                    ": no p-values extracted in subtests");
-                    continue;
-                }
+    /* Subtests are scanned in place, each starts with the separator
+     * and ends before the next one */
+    const char * subTest = findSubTest(outputBegin, outputEnd);
+    if(subTest == outputEnd)
+        r.logger->warn(r.objectInfo + ": no subtests extracted");
 
-                /* Single pvalue processing */
-                for( ; pValIt != endIt ; ++pValIt) {
-                    std::smatch pvalMatch = *pValIt;
-                    tmpPVals.push_back(Utils::strtod(pvalMatch[1].str()));
-                }
-                tmpStatistics.push_back(result::Statistic::getInstance(
-                                            "Kolmogorov-Smirnov",
-                                            r->kstest(tmpPVals)));
-                tmpSubTestResults.push_back(result::SubTestResult::getInstance(
-                                                tmpStatistics, tmpPVals));
-                tmpPVals.clear();
-                tmpStatistics.clear();
-            }
-            r->varRes.push_back(result::VariantResult::getInstance(
-                                    tmpSubTestResults,
-                                    variant->getUserSettings(),
-                                    variant->getBatteryOutput()));
-            tmpSubTestResults.clear();
+    /* Single subtest processing! */
+    while(subTest != outputEnd) {
+        const char * subTestEnd = findSubTest(subTest + 1, outputEnd);
+        extractPValues(subTest, subTestEnd, tmpPVals);
+        subTest = subTestEnd;
+        if(tmpPVals.empty()) {
+            r.logger->warn(r.objectInfo +
+                           ": no p-values extracted in subtests");
+            continue;
         }
-    }
 
-    return r;
+        tmpStatistics.push_back(result::Statistic::getInstance(
+                                    "Kolmogorov-Smirnov",
+                                    r.kstest(tmpPVals)));
+        tmpSubTestResults.push_back(result::SubTestResult::getInstance(
+                                        std::move(tmpStatistics), std::move(tmpPVals)));
+        tmpPVals.clear();
+        tmpStatistics.clear();
+    }
+    return result::VariantResult::getInstance(tmpSubTestResults,
+                                              variant->getUserSettings(),
+                                              variant->getBatteryOutput());
 }
 
-std::vector<std::string> TestResult::splitIntoSubTests(const std::string & str) {
-    std::vector<std::string> rval;
+const char * TestResult::findSubTest(const char * begin, const char * end) {
     static const std::string separator {
         "#                          Values of test p-values                            #"
     };
-    size_t start = 0;
-    size_t end = 0;
-    for( ; end != std::string::npos ; ) {
-        start = str.find(separator, end);
-        end = str.find(separator, start + 1);
-        if(start == std::string::npos)
-            return rval;
-
-        rval.push_back(str.substr(start, end - start));
+    return std::search(begin, end, separator.begin(), separator.end());
+}
+
+void TestResult::extractPValues(const char * begin, const char * end,
+                                std::vector<double> & pvalues) {
+    /* P-values are printed as "++++0.12345678++++\n", markers are looked
+     * up by memchr. Matches are the same as of "\+{4}([01]\.[0-9]+?)\+{4}\n". */
+    static const char MARKER[] = "++++";
+    static const size_t MARKER_LENGTH = sizeof(MARKER) - 1;
+
+    for(const char * it = begin ;
+        (it = static_cast<const char *>(std::memchr(it, '+', end - it))) ; ++it) {
+        if(static_cast<size_t>(end - it) < 2 * MARKER_LENGTH + 4 || std::memcmp(it, MARKER, MARKER_LENGTH) != 0)
+            continue;
+        const char * value = it + MARKER_LENGTH;
+        if((value[0] != '0' && value[0] != '1') || value[1] != '.' ||
+           !std::isdigit(static_cast<unsigned char>(value[2])))
+            continue;
+        const char * valueEnd = std::find_if_not(value + 2, end, [](char c) {
+            return c >= '0' && c <= '9';
+        });
+        if(static_cast<size_t>(end - valueEnd) < MARKER_LENGTH + 1 ||
+           std::memcmp(valueEnd, MARKER, MARKER_LENGTH) != 0 ||
+           valueEnd[MARKER_LENGTH] != '\n')
+            continue;
+
+        pvalues.push_back(Utils::strtod(value, valueEnd));
+        it = valueEnd + MARKER_LENGTH;
     }
-    return rval;
 }
 
 /* Following code is taken from DIEHARDER battery. */
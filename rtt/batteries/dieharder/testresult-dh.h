@@ -15,12 +15,24 @@ public:
     static std::unique_ptr<TestResult> getInstance(
             const std::vector<ITest *> & tests);
 
+    /**
+     * @brief parseVariant Extracts results from output of single executed variant
+     * @param variant Executed variant
+     * @return Result of the variant
+     */
+    static result::VariantResult parseVariant(const IVariant * variant);
+
 private:
     TestResult(Logger * logger , std::string testName)
         : ITestResult(logger , testName)
     {}
 
-    static std::vector<std::string> splitIntoSubTests(const std::string & str);
+    /* Returns start of the next subtest in the output, or end of the output */
+    static const char * findSubTest(const char * begin, const char * end);
+
+    /* Appends p-values printed in the subtest */
+    static void extractPValues(const char * begin, const char * end,
+                               std::vector<double> & pvalues);
 
     /* Math functions used to calculate resulting KS statistic */
     double kstest(const std::vector<double> & pvalue);
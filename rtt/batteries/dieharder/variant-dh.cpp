@@ -8,8 +8,10 @@ const int Variant::OPTION_HEADER_FLAG      = 66047;
 const int Variant::OPTION_FILE_GENERATOR   = 201;
 
 std::unique_ptr<Variant> Variant::getInstance(int testId, std::string testObjInf,
-                                              uint variantIdx, const GlobalContainer & cont) {
-    std::unique_ptr<Variant> v (new Variant(testId, testObjInf, variantIdx, cont));
+                                              uint variantIdx, const BatteryArg & battery,
+                                              const std::string & binaryDataPath,
+                                              const GlobalContainer & cont) {
+    std::unique_ptr<Variant> v (new Variant(testId, testObjInf, variantIdx, battery, binaryDataPath, cont));
     auto battConf = cont.getBatteryConfiguration();
 
     v->pSampleCount = battConf->getTestVariantParamInt(
@@ -38,6 +40,16 @@ std::unique_ptr<Variant> Variant::getInstance(int testId, std::string testObjInf
     return v;
 }
 
+double Variant::getCostEstimate() const {
+    /* Each p-sample is one run of the test */
+    return pSampleCount;
+}
+
+std::uint64_t Variant::getInputDemand() const {
+    /* Numbers drawn by each test are given by the test itself */
+    return 0;
+}
+
 void Variant::buildStrings() {
     /* Building cli arguments */
     std::stringstream arguments;
@@ -60,7 +72,7 @@ void Variant::buildStrings() {
     /* Specify binary file generator */
     arguments << "-g " << OPTION_FILE_GENERATOR << " ";
     /* Specify binary input file */
-    arguments << "-f " << binaryDataPath;
+    arguments << "-f " << processDataPath;
     cliArguments = arguments.str();
 
     /* Building standard input */
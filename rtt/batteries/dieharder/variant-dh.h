@@ -11,7 +11,13 @@ namespace dieharder {
 class Variant : public IVariant {
 public:
     static std::unique_ptr<Variant> getInstance(int testId, std::string testObjInf,
-                                                uint variantIdx, const GlobalContainer & cont);
+                                                uint variantIdx, const BatteryArg & battery,
+                                                const std::string & binaryDataPath,
+                                                const GlobalContainer & cont);
+
+    double getCostEstimate() const;
+
+    std::uint64_t getInputDemand() const;
 private:
     /* Test info constants */
     static const int OPTION_HEADER_FLAG;
@@ -23,8 +29,10 @@ private:
 
     /* Methods */
     Variant(int testId, std::string testObjInf,
-            uint variantIdx, const GlobalContainer & cont)
-        : IVariant(testId, testObjInf, variantIdx, cont)
+            uint variantIdx, const BatteryArg & battery,
+            const std::string & binaryDataPath,
+            const GlobalContainer & cont)
+        : IVariant(testId, testObjInf, variantIdx, battery, binaryDataPath, cont)
     {}
 
     void buildStrings();
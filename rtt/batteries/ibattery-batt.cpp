@@ -1,65 +1,422 @@
 #include "ibattery-batt.h"
 
+#include <cmath>
+#include <limits>
+#include <iomanip>
+
 #include "rtt/batteries/dieharder/battery-dh.h"
 #include "rtt/batteries/niststs/battery-sts.h"
 #include "rtt/batteries/testu01/battery-tu01.h"
 
 #include "rtt/batteries/testrunner-batt.h"
+#include "rtt/batteries/costmodel-batt.h"
+#include "rtt/batteries/cpupinning-batt.h"
 
 namespace rtt {
 namespace batteries {
 
-std::unique_ptr<IBattery> IBattery::getInstance(const GlobalContainer & cont) {
+/* Timeout in battery configuration takes precedence. Variants with runtime history
+ * get multiple of their measured runtime when adaptive timeouts are enabled,
+ * so hung processes are killed early and long ones are not killed prematurely.
+ * Runtime extrapolated from the battery history ignores size of the input,
+ * variants without their own history (e.g. on new input size) get the default. */
+static int getTestTimeout(const IVariant * variant, const CostModel & costModel,
+                          const ToolkitSettings * toolkitSettings) {
+    if(variant->getConfiguredTimeout() != Configuration::VALUE_INT_NOT_SET)
+        return variant->getConfiguredTimeout();
+    int adaptiveFactor = toolkitSettings->getExecAdaptiveTimeoutFactor();
+    if(adaptiveFactor == 0 || !costModel.hasRuntimeHistory(variant))
+        return toolkitSettings->getExecTestTimeout();
+
+    double seconds = std::ceil(adaptiveFactor * costModel.predictRuntime(variant));
+    return static_cast<int>(std::min<double>(
+               std::max<double>(seconds, toolkitSettings->getExecAdaptiveTimeoutMinimum()),
+               std::numeric_limits<int>::max()));
+}
+
+static std::string formatBytes(std::uint64_t bytes) {
+    std::stringstream rval;
+    rval << bytes << " B";
+    if(bytes >= 1024 * 1024)
+        rval << " (" << std::fixed << std::setprecision(1)
+             << bytes / (1024.0 * 1024.0) << " MiB)";
+    return rval.str();
+}
+
+std::unique_ptr<IBattery> IBattery::getInstance(const GlobalContainer & cont,
+                                                const clinterface::BatteryArg & battery,
+                                                const std::string & binaryDataPath) {
     /* Pick correct derived class */
-    switch(cont.getRttCliOptions()->getBatteryId()) {
+    switch(battery.getBatteryId()) {
         case Constants::BatteryID::DIEHARDER:
-            return dieharder::Battery::getInstance(cont);
+            return dieharder::Battery::getInstance(cont, battery, binaryDataPath);
         case Constants::BatteryID::NIST_STS:
-            return niststs::Battery::getInstance(cont);
+            return niststs::Battery::getInstance(cont, battery, binaryDataPath);
         case Constants::BatteryID::TU01_SMALLCRUSH:
         case Constants::BatteryID::TU01_CRUSH:
         case Constants::BatteryID::TU01_BIGCRUSH:
         case Constants::BatteryID::TU01_RABBIT:
         case Constants::BatteryID::TU01_ALPHABIT:
         case Constants::BatteryID::TU01_BLOCK_ALPHABIT:
-            return testu01::Battery::getInstance(cont);
+            return testu01::Battery::getInstance(cont, battery, binaryDataPath);
         default:
             raiseBugException(Strings::ERR_INVALID_BATTERY);
     }
 }
 
 void IBattery::runTests() {
-    if(executed)
-        throw RTTException(objectInfo , Strings::BATT_ERR_ALREADY_EXECUTED);
+    runTests({this});
+}
+
+void IBattery::runTests(const std::vector<IBattery *> & batteries,
+                        const std::function<void(IBattery *)> & onBatteryFinished) {
+    if(batteries.empty())
+        raiseBugException("no batteries to execute");
 
-    logger->info(objectInfo + ": Test execution started!");
-    /* Tests will create output file in output directory */
-    Utils::createDirectory(toolkitSettings->getLoggerBatteryDir(battery));
+    /* Settings are global, any battery can provide them */
+    Logger * logger = batteries.front()->logger;
+    ToolkitSettings * toolkitSettings = batteries.front()->toolkitSettings;
+    SharedInput * sharedInput = batteries.front()->sharedInput;
+    std::string objectInfo;
+    std::string batteryShortNames;
 
-    /* Get all variations from tests and execute them parallely. */
+    /* Get all variations from tests of all batteries and execute them parallely. */
     std::vector<IVariant *> variants;
-    for(const auto & test : tests) {
-        auto testVars = test->getVariants();
-        variants.insert(variants.end(), testVars.begin(), testVars.end());
+    /* Battery of each variant and count of its variants that are not finished yet */
+    std::map<const IVariant *, IBattery *> variantOwners;
+    std::map<IBattery *, size_t> unfinishedVariants;
+    std::mutex unfinishedVariants_mux;
+    /* With fail-fast, each test is evaluated as soon as all its variants are finished.
+     * Batteries of different jobs (server mode) can have different limits. */
+    std::map<const IVariant *, ITest *> variantTests;
+    std::map<const ITest *, size_t> unfinishedTestVariants;
+    std::map<IBattery *, int> failedTests;
+    for(IBattery * batt : batteries) {
+        if(batt->executed)
+            throw RTTException(batt->objectInfo , Strings::BATT_ERR_ALREADY_EXECUTED);
+
+        logger->info(batt->objectInfo + ": Test execution started!");
+        /* Tests will create output file in output directory */
+        Utils::createDirectory(toolkitSettings->getLoggerBatteryDir(batt->battery));
+
+        for(const auto & test : batt->tests) {
+            auto testVars = test->getVariants();
+            variants.insert(variants.end(), testVars.begin(), testVars.end());
+            for(const IVariant * v : testVars) {
+                variantOwners[v] = batt;
+                variantTests[v] = test.get();
+            }
+            unfinishedVariants[batt] += testVars.size();
+            unfinishedTestVariants[test.get()] = testVars.size();
+        }
+        /* Same battery can be present multiple times, once for each input file */
+        if(objectInfo.find(batt->battery.getName()) == std::string::npos) {
+            objectInfo += (objectInfo.empty() ? "" : "+") + batt->battery.getName();
+            batteryShortNames += (batteryShortNames.empty() ? "" : "+") +
+                                 batt->battery.getShortName();
+        }
     }
+    /* Longest variants are dispatched first, so that
+     * no long variant is left running alone at the end. */
+    auto costModel = CostModel::getInstance(logger,
+                                            toolkitSettings->getExecRuntimeHistoryFile());
+    costModel->orderLongestFirst(variants);
+    /* Makespan is predicted only from runtimes measured on the same
+     * variants, extrapolated runtimes are fit for ordering only. */
+    bool makespanPredicted = std::all_of(variants.begin(), variants.end(),
+                                         [&](const IVariant * v) {
+        return costModel->hasRuntimeHistory(v);
+    });
+    double predictedMakespan = makespanPredicted ?
+                                   costModel->predictMakespan(
+                                       variants, toolkitSettings->getExecMaximumThreads()) : 0;
+
+    /* Battery is stopped when enough of its tests failed, the verdict won't change.
+     * Remaining variants are cancelled, but they are still finished as usual. */
+    auto checkFailFast = [&](IBattery * batt, ITest * test) {
+        int failFastCount = batt->rttCliOptions->getFailFastCount();
+        {
+            std::lock_guard<std::mutex> l (unfinishedVariants_mux);
+            if(--unfinishedTestVariants.at(test) > 0 || batt->stoppedEarly)
+                return;
+        }
+        auto result = ITestResult::getInstance({test});
+        if(!result->getOptionalPassed().second || result->getOptionalPassed().first)
+            return;
+        {
+            std::lock_guard<std::mutex> l (unfinishedVariants_mux);
+            /* Nothing is left to cancel when this is the last variant of the battery */
+            if(batt->stoppedEarly || ++failedTests[batt] < failFastCount ||
+               unfinishedVariants.at(batt) == 1)
+                return;
+            batt->stoppedEarly = true;
+        }
+        logger->warn(batt->objectInfo + ": " + Utils::itostr(failFastCount) +
+                     " tests failed, remaining tests are cancelled (fail-fast)."
+                     " Results are partial.");
+        /* Tests with all variants finished are left out, runner
+         * doesn't cancel variants that already finished either */
+        std::vector<const IVariant *> cancelled;
+        {
+            std::lock_guard<std::mutex> l (unfinishedVariants_mux);
+            for(const auto & battTest : batt->tests) {
+                if(unfinishedTestVariants.at(battTest.get()) == 0)
+                    continue;
+                for(const IVariant * v : battTest->getVariants())
+                    cancelled.push_back(v);
+            }
+        }
+        TestRunner::cancelVariants(cancelled);
+    };
+
+    /* Battery is finished when the last of its variants is finished,
+     * other batteries can still be running at that time. */
+    auto onVariantFinished = [&](IVariant * variant) {
+        IBattery * batt = variantOwners.at(variant);
+        /* Battery with cancelled variant (fail-fast or stopped execution) has partial results */
+        if(variant->isCancelled()) {
+            bool stopped = false;
+            {
+                std::lock_guard<std::mutex> l (unfinishedVariants_mux);
+                stopped = !batt->stoppedEarly;
+                batt->stoppedEarly = true;
+            }
+            if(stopped)
+                logger->warn(batt->objectInfo + ": execution was stopped, remaining tests"
+                                                " are cancelled. Results are partial.");
+        }
+        /* Output is parsed in the worker while other variants still run,
+         * only the parsed results are collected when the battery is stored.
+         * Variant delegated to another instance of sharded run has no output. */
+        auto parseStart = std::chrono::steady_clock::now();
+        try {
+            if(!variant->isDelegated() && !variant->isCancelled()) {
+                ITestResult::getVariantResult(variant);
+                if(batt->rttCliOptions->getFailFastCount() > 0)
+                    checkFailFast(batt, variantTests.at(variant));
+            }
+        } catch(std::exception &) {
+            /* Output is parsed again when the battery is stored, error is reported there */
+        }
+        TestRunner::tracePhase("parse", parseStart);
+
+        {
+            std::lock_guard<std::mutex> l (unfinishedVariants_mux);
+            if(--unfinishedVariants.at(batt) > 0)
+                return;
+        }
+        logger->info(batt->objectInfo + ": Test execution finished!");
+        batt->executed = true;
+        if(onBatteryFinished)
+            onBatteryFinished(batt);
+    };
+
+    /* Variants are admitted by their peak memory from history,
+     * tests without history by the default peak */
+    MemoryLimits memoryLimits;
+    memoryLimits.budget = toolkitSettings->getExecMemoryBudget() * 1024ULL;
+    std::uint64_t defaultPeak = toolkitSettings->getExecDefaultPeakMemory() * 1024ULL;
+    memoryLimits.predictPeak = [&, defaultPeak](const IVariant * variant) {
+        long peak = costModel->predictPeakMemory(variant);
+        return peak > 0 ? static_cast<std::uint64_t>(peak) : defaultPeak;
+    };
+    /* Input files kept in memory are taken from the same budget */
+    memoryLimits.heldMemory = [sharedInput]() {
+        return sharedInput->getMemoryUsage() / 1024;
+    };
+    memoryLimits.childLimit = toolkitSettings->getExecChildMemoryLimit();
+    memoryLimits.cgroupDir = toolkitSettings->getExecCgroupDir();
+    if(memoryLimits.budget > 0)
+        logger->info(objectInfo + ": memory budget of running tests is " +
+                     Utils::itostr(toolkitSettings->getExecMemoryBudget()) + " MiB");
+
+    auto testTimeout = [&](const IVariant * variant) {
+        return getTestTimeout(variant, *costModel, toolkitSettings);
+    };
+
+    auto cpuPinning = CpuPinning::getInstance(logger, toolkitSettings->getExecCpuPinning());
+
+    /* Each execution has its own trace, server executes many */
+    std::string tracePath;
+    if(!toolkitSettings->getExecTraceDir().empty())
+        tracePath = toolkitSettings->getExecTraceDir() +
+                    Utils::formatRawTime(Utils::getRawTime(), "%Y%m%d%H%M%S") + "-" +
+                    Utils::itostr(getpid()) + "-" + batteryShortNames + "-trace.json";
+    auto trace = ScheduleTrace::getInstance(logger, tracePath);
+
+    auto start = std::chrono::steady_clock::now();
     TestRunner::executeTests(logger, variants,
-                             toolkitSettings->getExecMaximumThreads(),
-                             toolkitSettings->getExecTestTimeout());
+                             toolkitSettings->getExecMaximumThreads(), testTimeout,
+                             onVariantFinished, memoryLimits, cpuPinning.get(),
+                             trace.get());
+    trace->save();
+    double actualMakespan = std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - start).count();
+
+    for(const IVariant * v : variants) {
+        /* Variants that failed to start have no runtime */
+        double wallTime = v->getBatteryOutput().getWallTime();
+        if(wallTime > 0)
+            costModel->recordRuntime(v, wallTime);
+        auto usage = v->getBatteryOutput().getResourceUsage();
+        if(usage.measured)
+            costModel->recordPeakMemory(v, usage.maxRss);
+        if(usage.measured && usage.readBytes > 0)
+            costModel->recordInputDemand(v, usage.readBytes);
+    }
+    costModel->save();
+
+    if(makespanPredicted)
+        logger->info(objectInfo + ": predicted makespan " +
+                     Utils::formatSeconds(predictedMakespan) + ", actual makespan " +
+                     Utils::formatSeconds(actualMakespan));
+    else
+        logger->info(objectInfo + ": actual makespan " + Utils::formatSeconds(actualMakespan) +
+                     ", not predicted, some tests have no runtime history");
+}
+
+std::string IBattery::planTests(const std::vector<IBattery *> & batteries) {
+    if(batteries.empty())
+        raiseBugException("no batteries to plan");
+
+    ToolkitSettings * toolkitSettings = batteries.front()->toolkitSettings;
+    int maxThreads = toolkitSettings->getExecMaximumThreads();
+    std::stringstream plan;
+
+    /* Variants are ordered the same way as in runTests */
+    std::vector<IVariant *> variants;
+    std::map<std::string, std::uint64_t> inputSizes;
+    for(IBattery * batt : batteries) {
+        for(const auto & test : batt->tests) {
+            auto testVars = test->getVariants();
+            variants.insert(variants.end(), testVars.begin(), testVars.end());
+        }
+        try {
+            inputSizes[batt->binaryDataPath] = Utils::getFileSize(batt->binaryDataPath);
+        } catch(std::runtime_error &) {
+            /* Generator output doesn't exist before the run */
+        }
+    }
+    auto costModel = CostModel::getInstance(batteries.front()->logger,
+                                            toolkitSettings->getExecRuntimeHistoryFile());
+    costModel->orderLongestFirst(variants);
+
+    plan << "Input files" << std::endl;
+    for(IBattery * batt : batteries) {
+        if(inputSizes.count(batt->binaryDataPath) == 1)
+            plan << "    " << batt->objectInfo << ": " << batt->binaryDataPath << ", "
+                 << formatBytes(inputSizes.at(batt->binaryDataPath)) << std::endl;
+        else
+            plan << "    " << batt->objectInfo << ": " << batt->binaryDataPath
+                 << ", size unknown" << std::endl;
+    }
+    plan << std::endl;
+
+    plan << "Tests in order of dispatch" << std::endl;
+    /* Variants without runtime history have only static estimate in battery specific
+     * units, they are left out of the totals instead of skewing them */
+    std::vector<IVariant *> measuredVariants;
+    double coreSeconds = 0;
+    size_t unknownDemand = 0;
+    size_t exceedingDemand = 0;
+    for(size_t i = 0 ; i < variants.size() ; ++i) {
+        const IVariant * v = variants.at(i);
+        std::string stdInput = v->getStdInput();
+        std::replace(stdInput.begin(), stdInput.end(), '\n', ' ');
+        plan << "[" << i + 1 << "] " << v->getObjectInfo() << std::endl;
+        plan << "    executable: " << v->getExecutablePath() << std::endl;
+        plan << "    arguments:  " << v->getCliArguments() << std::endl;
+        if(!stdInput.empty())
+            plan << "    input:      " << stdInput << std::endl;
+
+        std::uint64_t demand = costModel->predictInputDemand(v);
+        plan << "    reads:      ";
+        if(demand == 0) {
+            ++unknownDemand;
+            plan << "unknown";
+        } else {
+            plan << formatBytes(demand)
+                 << (v->getInputDemand() > 0 ? "" : " (measured)");
+            auto size = inputSizes.find(v->getBinaryDataPath());
+            if(size != inputSizes.end() && demand > size->second) {
+                ++exceedingDemand;
+                plan << ", more than the input file, data will be read again"
+                        " from the start or the test will fail";
+            }
+        }
+        plan << std::endl;
+
+        plan << "    runtime:    ";
+        if(costModel->isRuntimeMeasured(v)) {
+            measuredVariants.push_back(variants.at(i));
+            coreSeconds += costModel->predictRuntime(v);
+            plan << Utils::formatSeconds(costModel->predictRuntime(v));
+        } else {
+            plan << "unknown";
+        }
+        plan << ", timeout " << getTestTimeout(v, *costModel, toolkitSettings) << " s" << std::endl;
+    }
+    plan << std::endl;
+
+    plan << "Summary" << std::endl;
+    plan << "    tests:                  " << variants.size() << std::endl;
+    plan << "    unknown input demand:   " << unknownDemand << " tests" << std::endl;
+    plan << "    reading past the input: " << exceedingDemand << " tests" << std::endl;
+    plan << "    predicted core-hours:   " << std::fixed << std::setprecision(2)
+         << coreSeconds / 3600 << std::endl;
+    plan << "    predicted makespan:     "
+         << Utils::formatSeconds(costModel->predictMakespan(measuredVariants, maxThreads))
+         << " with " << maxThreads << " parallel tests" << std::endl;
+    if(measuredVariants.size() < variants.size())
+        plan << "    runtime of " << variants.size() - measuredVariants.size()
+             << " tests without runtime history is not included" << std::endl;
+    return plan.str();
+}
+
+bool IBattery::isStoppedEarly() const {
+    return stoppedEarly;
+}
+
+const clinterface::BatteryArg & IBattery::getBattery() const {
+    return battery;
+}
+
+std::string IBattery::getBinaryDataPath() const {
+    return binaryDataPath;
+}
+
+std::string IBattery::getObjectInfo() const {
+    return objectInfo;
+}
 
-    logger->info(objectInfo + ": Test execution finished!");
-    executed = true;
+std::string IBattery::getObjectInfo(const clinterface::BatteryArg & battery,
+                                    const std::string & binaryDataPath,
+                                    bool batchMode, int jobId) {
+    std::string rval = battery.getName();
+    /* In batch mode, same battery is created for each input file */
+    if(batchMode)
+        rval += " (" + Utils::getLastItemInPath(binaryDataPath) + ")";
+    /* Jobs of the server can run the same battery at the same time,
+     * their messages are told apart by the job */
+    if(jobId > 0)
+        rval += " [job " + Utils::itostr(jobId) + "]";
+    return rval;
 }
 
-IBattery::IBattery(const GlobalContainer & cont) {
+IBattery::IBattery(const GlobalContainer & cont, const clinterface::BatteryArg & battery,
+                   const std::string & binaryDataPath) {
     rttCliOptions        = cont.getRttCliOptions();
     batteryConfiguration = cont.getBatteryConfiguration();
     toolkitSettings      = cont.getToolkitSettings();
+    sharedInput          = cont.getSharedInput();
     logger               = cont.getLogger();
 
-    creationTime = cont.getCreationTime();
-    battery      = rttCliOptions->getBatteryArg();
-    objectInfo   = battery.getName();
-    logger->info(objectInfo + Strings::BATT_INFO_PROCESSING_FILE + rttCliOptions->getInputDataPath());
+    creationTime         = cont.getCreationTime();
+    this->battery        = battery;
+    this->binaryDataPath = binaryDataPath;
+    objectInfo           = getObjectInfo(battery, binaryDataPath,
+                                         rttCliOptions->isBatchMode(), cont.getJobId());
+    logger->info(objectInfo + Strings::BATT_INFO_PROCESSING_FILE + binaryDataPath);
 
     std::vector<int> testIndices = rttCliOptions->getTestConsts();
     if(testIndices.empty())
@@ -68,7 +425,7 @@ IBattery::IBattery(const GlobalContainer & cont) {
         throw RTTException(objectInfo , Strings::BATT_ERR_NO_TESTS);
 
     for(const int & i : testIndices) {
-        tests.push_back(ITest::getInstance(objectInfo, i, cont));
+        tests.push_back(ITest::getInstance(objectInfo, i, battery, binaryDataPath, cont));
     }
 }
 
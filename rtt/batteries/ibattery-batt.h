@@ -1,6 +1,8 @@
 #ifndef RTT_IBATTERY_H
 #define RTT_IBATTERY_H
 
+#include <functional>
+
 #include "rtt/batteries/itest-batt.h"
 #include "rtt/batteries/itestresult-batt.h"
 
@@ -15,15 +17,81 @@ public:
     /**
      * @brief getInstance Creates an initialized object
      * @param cont Global settings
+     * @param battery Battery that will be created
+     * @param binaryDataPath Path to file with data that will be analysed
      * @return
      */
-    static std::unique_ptr<IBattery> getInstance(const GlobalContainer & cont);
+    static std::unique_ptr<IBattery> getInstance(const GlobalContainer & cont,
+                                                 const clinterface::BatteryArg & battery,
+                                                 const std::string & binaryDataPath);
 
     /**
      * @brief runTests Executes all tests in the battery
      */
     void runTests();
 
+    /**
+     * @brief runTests Executes all tests of given batteries. Variants of all
+     * batteries share single pool of worker threads, so the pool is not drained
+     * between batteries.
+     * @param batteries Batteries that will be executed, all must be
+     * created with the same global settings.
+     * @param onBatteryFinished (optional) called as soon as all tests of a battery
+     * are executed, while other batteries may be still running. Calls can run
+     * concurrently from worker threads.
+     */
+    static void runTests(const std::vector<IBattery *> & batteries,
+                         const std::function<void(IBattery *)> & onBatteryFinished = nullptr);
+
+    /**
+     * @brief planTests Plans execution of all tests of given batteries without
+     * executing anything. Variants are listed in order of dispatch with their
+     * command lines, amount of read input, predicted runtime and timeout.
+     * Plan ends with total predicted core-hours and makespan.
+     * @param batteries Batteries that would be executed, all must be
+     * created with the same global settings.
+     * @return Plan in human readable form
+     */
+    static std::string planTests(const std::vector<IBattery *> & batteries);
+
+    /**
+     * @brief getBattery
+     * @return Battery argument of this battery
+     */
+    const clinterface::BatteryArg & getBattery() const;
+
+    /**
+     * @brief getBinaryDataPath
+     * @return Path to file analysed by this battery
+     */
+    std::string getBinaryDataPath() const;
+
+    /**
+     * @brief getObjectInfo
+     * @return Info about the battery used in logging, messages
+     * logged by the battery and its tests start with it
+     */
+    std::string getObjectInfo() const;
+
+    /**
+     * @brief getObjectInfo
+     * @param battery
+     * @param binaryDataPath
+     * @param batchMode True if multiple files are analysed at once
+     * @param jobId Identifier of the server job, 0 outside of server
+     * @return Info about the battery with given settings, used in logging
+     */
+    static std::string getObjectInfo(const clinterface::BatteryArg & battery,
+                                     const std::string & binaryDataPath,
+                                     bool batchMode, int jobId);
+
+    /**
+     * @brief isStoppedEarly
+     * @return True if remaining tests were cancelled after the number
+     * of failed tests reached fail-fast limit, results are then partial.
+     */
+    bool isStoppedEarly() const;
+
     /**
      * @brief ~IBattery Destructor.
      */
@@ -37,7 +105,8 @@ public:
     virtual std::vector<std::unique_ptr<ITestResult>> getTestResults() const = 0;
 
 protected:
-    IBattery(const GlobalContainer & cont);
+    IBattery(const GlobalContainer & cont, const clinterface::BatteryArg & battery,
+             const std::string & binaryDataPath);
 
     /* Variables common for all batteries. Set in getInstance().
      * Used by batteries in later stages. */
@@ -46,16 +115,20 @@ protected:
     clinterface::RTTCliOptions * rttCliOptions;
     Configuration * batteryConfiguration;
     ToolkitSettings * toolkitSettings;
+    SharedInput * sharedInput;
     Logger * logger;
     /* Variables initialized in getInstance() */
     time_t creationTime;
     clinterface::BatteryArg battery;
+    std::string binaryDataPath;
     std::string objectInfo;
     /* Battery is keeping track of tests set to execution.
      * Test objects keep track of their settings and execution results. */
     std::vector<std::unique_ptr<ITest>> tests;
     /* Set to true after execution */
     bool executed = false;
+    /* Set to true when tests were cancelled by fail-fast */
+    bool stoppedEarly = false;
 };
 
 } // namespace batteries
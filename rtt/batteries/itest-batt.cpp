@@ -8,19 +8,21 @@ namespace rtt {
 namespace batteries {
 
 std::unique_ptr<ITest> ITest::getInstance(std::string battObjInf, int testId,
+                                          const BatteryArg & battery,
+                                          const std::string & binaryDataPath,
                                           const GlobalContainer & cont) {
-    switch(cont.getRttCliOptions()->getBatteryId()) {
+    switch(battery.getBatteryId()) {
         case Constants::BatteryID::DIEHARDER:
-            return dieharder::Test::getInstance(battObjInf, testId, cont);
+            return dieharder::Test::getInstance(battObjInf, testId, battery, binaryDataPath, cont);
         case Constants::BatteryID::NIST_STS:
-            return niststs::Test::getInstance(battObjInf, testId , cont);
+            return niststs::Test::getInstance(battObjInf, testId, battery, binaryDataPath, cont);
         case Constants::BatteryID::TU01_SMALLCRUSH:
         case Constants::BatteryID::TU01_CRUSH:
         case Constants::BatteryID::TU01_BIGCRUSH:
         case Constants::BatteryID::TU01_RABBIT:
         case Constants::BatteryID::TU01_ALPHABIT:
         case Constants::BatteryID::TU01_BLOCK_ALPHABIT:
-            return testu01::Test::getInstance(battObjInf, testId , cont);
+            return testu01::Test::getInstance(battObjInf, testId, battery, binaryDataPath, cont);
         default:
             raiseBugException(Strings::ERR_INVALID_BATTERY);
     }
@@ -38,13 +40,15 @@ std::vector<IVariant *> ITest::getVariants() const {
     return Utils::getRawPtrs(variants);
 }
 
-ITest::ITest(std::string battObjInf, int testId, const GlobalContainer & cont) {
+ITest::ITest(std::string battObjInf, int testId, const BatteryArg & battery,
+             const std::string & binaryDataPath,
+             const GlobalContainer & cont) {
     rttCliOptions        = cont.getRttCliOptions();
     toolkitSettings      = cont.getToolkitSettings();
     batteryConfiguration = cont.getBatteryConfiguration();
     logger               = cont.getLogger();
     this->testId         = testId;
-    battery              = rttCliOptions->getBatteryArg();
+    this->battery        = battery;
     logicName            = TestConstants::getTestLogicName(battery, testId);
     objectInfo           =
             battObjInf + " - " + logicName +
@@ -52,10 +56,12 @@ ITest::ITest(std::string battObjInf, int testId, const GlobalContainer & cont) {
 
     uint varCount = batteryConfiguration->getTestVariantsCount(battery, testId);
     if(varCount == 0) {
-        variants.push_back(IVariant::getInstance(testId, objectInfo, 0, cont));
+        variants.push_back(IVariant::getInstance(testId, objectInfo, 0,
+                                                 battery, binaryDataPath, cont));
     } else {
         for(uint varIdx = 0; varIdx < varCount; ++varIdx)
-            variants.push_back(IVariant::getInstance(testId, objectInfo, varIdx, cont));
+            variants.push_back(IVariant::getInstance(testId, objectInfo, varIdx,
+                                                     battery, binaryDataPath, cont));
     }
 }
 
@@ -19,10 +19,14 @@ public:
      * @brief getInstance Creates initialized object
      * @param battObjInf Information about parent object used for logging
      * @param testId ID of the test
+     * @param battery Battery of the test
+     * @param binaryDataPath Path to file with data that will be analysed
      * @param cont Global settings
      * @return
      */
     static std::unique_ptr<ITest> getInstance(std::string battObjInf, int testId,
+                                              const BatteryArg & battery,
+                                              const std::string & binaryDataPath,
                                               const GlobalContainer & cont);
 
     /**
@@ -67,7 +71,9 @@ public:
     Logger * getLogger() const;
 
 protected:
-    ITest(std::string battObjInf, int testId , const GlobalContainer & cont);
+    ITest(std::string battObjInf, int testId , const BatteryArg & battery,
+          const std::string & binaryDataPath,
+          const GlobalContainer & cont);
 
     /* These fields will be set in the constructor */
     /* Pointers to global configurations */
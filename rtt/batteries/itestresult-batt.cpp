@@ -36,6 +36,31 @@ std::unique_ptr<ITestResult> ITestResult::getInstance(
     return rval;
 }
 
+result::VariantResult ITestResult::getVariantResult(IVariant * variant) {
+    if(variant->getVariantResult())
+        return *variant->getVariantResult();
+
+    switch(variant->getBattery().getBatteryId()) {
+        case Constants::BatteryID::NIST_STS:
+            variant->setVariantResult(niststs::TestResult::parseVariant(variant));
+            break;
+        case Constants::BatteryID::DIEHARDER:
+            variant->setVariantResult(dieharder::TestResult::parseVariant(variant));
+            break;
+        case Constants::BatteryID::TU01_SMALLCRUSH:
+        case Constants::BatteryID::TU01_CRUSH:
+        case Constants::BatteryID::TU01_BIGCRUSH:
+        case Constants::BatteryID::TU01_RABBIT:
+        case Constants::BatteryID::TU01_ALPHABIT:
+        case Constants::BatteryID::TU01_BLOCK_ALPHABIT:
+            variant->setVariantResult(testu01::TestResult::parseVariant(variant));
+            break;
+        default:
+            raiseBugException(Strings::ERR_INVALID_BATTERY);
+    }
+    return *variant->getVariantResult();
+}
+
 std::vector<result::VariantResult> ITestResult::getVariantResults() const {
     return varRes;
 }
@@ -22,6 +22,16 @@ public:
     static std::unique_ptr<ITestResult> getInstance(
             const std::vector<ITest *> & tests);
 
+    /**
+     * @brief getVariantResult Returns result of single executed variant. Output
+     * of the variant is parsed only on the first call, result is then kept
+     * in the variant. First call must not run concurrently with other calls
+     * for the same variant.
+     * @param variant Executed variant
+     * @return Result of the variant
+     */
+    static result::VariantResult getVariantResult(IVariant * variant);
+
     /**
      * @brief getVariantResults
      * @return Results of all underlying variants that were contained in the tests
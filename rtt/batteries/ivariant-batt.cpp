@@ -12,15 +12,17 @@ namespace rtt {
 namespace batteries {
 
 std::unique_ptr<IVariant> IVariant::getInstance(int testId, std::string testObjInf,
-                                                uint variantIdx, const rtt::GlobalContainer &cont) {
+                                                uint variantIdx, const BatteryArg & battery,
+                                                const std::string & binaryDataPath,
+                                                const rtt::GlobalContainer &cont) {
     std::unique_ptr<IVariant> rval;
 
-    switch(cont.getRttCliOptions()->getBatteryId()) {
+    switch(battery.getBatteryId()) {
         case Constants::BatteryID::NIST_STS:
-            rval = niststs::Variant::getInstance(testId , testObjInf , variantIdx, cont);
+            rval = niststs::Variant::getInstance(testId , testObjInf , variantIdx, battery, binaryDataPath, cont);
             break;
         case Constants::BatteryID::DIEHARDER:
-            rval = dieharder::Variant::getInstance(testId , testObjInf , variantIdx, cont);
+            rval = dieharder::Variant::getInstance(testId , testObjInf , variantIdx, battery, binaryDataPath, cont);
             break;
         case Constants::BatteryID::TU01_SMALLCRUSH:
         case Constants::BatteryID::TU01_CRUSH:
@@ -28,7 +30,7 @@ std::unique_ptr<IVariant> IVariant::getInstance(int testId, std::string testObjI
         case Constants::BatteryID::TU01_RABBIT:
         case Constants::BatteryID::TU01_ALPHABIT:
         case Constants::BatteryID::TU01_BLOCK_ALPHABIT:
-            rval = testu01::Variant::getInstance(testId , testObjInf , variantIdx , cont);
+            rval = testu01::Variant::getInstance(testId , testObjInf , variantIdx, battery, binaryDataPath, cont);
             break;
         default:
             raiseBugException(Strings::ERR_INVALID_BATTERY);
@@ -42,8 +44,37 @@ void IVariant::execute() {
      * Will deadlock if run without main thread. */
     uint expExitCode = BatteryArg::getExpectedExitCode(battery.getBatteryId());
 
-    batteryOutput = TestRunner::executeBinary(logger, objectInfo, executablePath,
-                                              expExitCode, cliArguments, stdInput);
+    /* Variant cancelled before it was taken (e.g. by fail-fast)
+     * doesn't wait for its input nor hash it for the cache */
+    if(TestRunner::isCancelled(this)) {
+        logger->info(objectInfo + ": test was cancelled, it won't be executed.");
+        cancelled = true;
+        executed = true;
+        return;
+    }
+
+    /* Variant already executed on the same data is not executed again,
+     * input is acquired first so that the cache hashes the shared data. */
+    auto lookupStart = std::chrono::steady_clock::now();
+    sharedInput->acquire(binaryDataPath);
+    std::string cacheKey = resultCache->getKey(binaryDataPath, processDataPath,
+                                               executablePath, cliArguments, stdInput);
+    std::vector<std::string> cachedAttachments;
+    OutputSource source = loadOutput(cacheKey, cachedAttachments);
+    TestRunner::tracePhase("input and cache lookup", lookupStart);
+    if(source == OutputSource::OTHER_INSTANCE) {
+        /* Postponed variant is executed again, delegated one has no output */
+        executed = delegated;
+        return;
+    }
+    if(source == OutputSource::EXECUTION) {
+        batteryOutput = TestRunner::executeBinary(logger, objectInfo, executablePath,
+                                                  expExitCode, cliArguments, stdInput,
+                                                  batteryOutput.getEmpty());
+        /* Runner doesn't execute cancelled variant or discards its output */
+        cancelled = batteryOutput.getExitCode() == -1 && TestRunner::isCancelled(this);
+        storeOutput(cacheKey, batteryOutput.getExitCode() == static_cast<int>(expExitCode));
+    }
     analyzeAndStoreBattOut();
 
     executed = true;
@@ -53,18 +84,39 @@ std::string IVariant::getCliArguments() const {
     return cliArguments;
 }
 
+std::string IVariant::getExecutablePath() const {
+    return executablePath;
+}
+
 std::string IVariant::getStdInput() const {
     return stdInput;
 }
 
 
-BatteryOutput IVariant::getBatteryOutput() const {
+const BatteryOutput & IVariant::getBatteryOutput() const {
     if(executed)
         return batteryOutput;
 
     throw RTTException(objectInfo, Strings::TEST_ERR_NO_EXEC_RES);
 }
 
+void IVariant::setVariantResult(const result::VariantResult & result) {
+    variantResult.reset(new result::VariantResult(result));
+    batteryOutput.releaseStdOut();
+}
+
+const result::VariantResult * IVariant::getVariantResult() const {
+    return variantResult.get();
+}
+
+bool IVariant::isDelegated() const {
+    return delegated;
+}
+
+bool IVariant::isCancelled() const {
+    return cancelled;
+}
+
 int IVariant::getTestId() const {
     return testId;
 }
@@ -73,26 +125,55 @@ std::string IVariant::getObjectInfo() const {
     return objectInfo;
 }
 
+Logger * IVariant::getLogger() const {
+    return logger;
+}
+
 std::vector<std::pair<std::string, std::string> > IVariant::getUserSettings() const {
     return userSettings;
 }
 
+clinterface::BatteryArg IVariant::getBattery() const {
+    return battery;
+}
+
+std::string IVariant::getBinaryDataPath() const {
+    return binaryDataPath;
+}
+
+int IVariant::getConfiguredTimeout() const {
+    return configuredTimeout;
+}
+
 IVariant::IVariant(int testId, std::string testObjInf, uint variantIdx,
+                   const BatteryArg & battery, const std::string & binaryDataPath,
                    const GlobalContainer & cont) {
-    this->testId        = testId;
-    this->variantIdx    = variantIdx;
-    logger              = cont.getLogger();
-    battery             = cont.getRttCliOptions()->getBatteryArg();
-    binaryDataPath      = cont.getRttCliOptions()->getInputDataPath();
-    executablePath      = cont.getToolkitSettings()->getBinaryBattery(battery);
-    logFilePath         =
+    this->testId         = testId;
+    this->variantIdx     = variantIdx;
+    logger               = cont.getLogger();
+    resultCache          = cont.getResultCache();
+    sharedInput          = cont.getSharedInput();
+    shardQueue           = cont.getShardQueue();
+    this->battery        = battery;
+    this->binaryDataPath = binaryDataPath;
+    batteryOutput        = BatteryOutput(cont.getToolkitSettings()->getOutputScanner(battery));
+    batteryOutput.setSpill(cont.getToolkitSettings()->getExecScratchDir(),
+                           cont.getToolkitSettings()->getExecOutputSpill() * 1024ULL);
+    processDataPath      = sharedInput->getProcessPath(binaryDataPath);
+    executablePath       = cont.getToolkitSettings()->getBinaryBattery(battery);
+    logFilePath          =
             Utils::getLogFilePath(
                 cont.getCreationTime(),
                 cont.getToolkitSettings()->getLoggerBatteryDir(battery),
                 binaryDataPath);
-    objectInfo          =
+    objectInfo           =
             testObjInf +
             " - variant " + Utils::itostr(variantIdx + 1);
+    configuredTimeout    =
+            cont.getBatteryConfiguration()->getTestVariantParamInt(
+                battery, testId, variantIdx, Configuration::TAGNAME_TIMEOUT);
+    if(configuredTimeout != Configuration::VALUE_INT_NOT_SET && configuredTimeout <= 0)
+        throw RTTException(objectInfo, Configuration::TAGNAME_TIMEOUT + " must be positive");
 
     if(binaryDataPath.empty())
         raiseBugException(Strings::TEST_ERR_NO_BINARY_DATA);
@@ -101,9 +182,41 @@ IVariant::IVariant(int testId, std::string testObjInf, uint variantIdx,
         raiseBugException(Strings::TEST_ERR_NO_EXECUTABLE);
 }
 
+IVariant::OutputSource IVariant::loadOutput(const std::string & cacheKey,
+                                            std::vector<std::string> & attachments) {
+    if(resultCache->load(cacheKey, batteryOutput, attachments)) {
+        logger->info(objectInfo + ": output loaded from result cache");
+        return OutputSource::CACHE;
+    }
+    /* Cancelled variant is passed to the runner, which doesn't execute it */
+    if(cacheKey.empty() || TestRunner::isCancelled(this) || shardQueue->claim(cacheKey))
+        return OutputSource::EXECUTION;
+
+    if(shardQueue->isCoordinator()) {
+        /* Coordinator needs all outputs, it checks the variant again later */
+        if(!awaitingOutput)
+            logger->info(objectInfo + ": test is executed by another instance, "
+                                      "waiting for its output");
+        awaitingOutput = true;
+        TestRunner::postponeVariant(ShardQueue::POLL_INTERVAL_SECONDS);
+    } else {
+        logger->info(objectInfo + ": test is executed by another instance");
+        delegated = true;
+    }
+    return OutputSource::OTHER_INSTANCE;
+}
+
+void IVariant::storeOutput(const std::string & cacheKey, bool succeeded,
+                           const std::vector<std::string> & attachments) {
+    /* Only outputs of successful executions are cached */
+    if(succeeded)
+        resultCache->store(cacheKey, batteryOutput, attachments);
+    shardQueue->release(cacheKey, succeeded);
+}
+
 void IVariant::analyzeAndStoreBattOut() {
-    /* Detect errors and warnings in output */
-    batteryOutput.doDetection();
+    auto analysisStart = std::chrono::steady_clock::now();
+    /* Errors and warnings were detected as the output was appended */
     if(!batteryOutput.getStdErr().empty())
         logger->warn(objectInfo + ": execution of test produced error output.");
     if(!batteryOutput.getErrors().empty())
@@ -120,10 +233,11 @@ void IVariant::analyzeAndStoreBattOut() {
         stdoutStr << "=== Standard output of thread " << std::this_thread::get_id() << " ===" << std::endl;
         stderrStr << "=== Error output of thread " << std::this_thread::get_id() << " ===" << std::endl;
 
-        if(!batteryOutput.getStdOut().empty()) {
+        if(batteryOutput.getStdOutLength() > 0) {
             Utils::appendStringToFile(logFilePath, filler);
             Utils::appendStringToFile(logFilePath, stdoutStr.str());
-            Utils::appendStringToFile(logFilePath, batteryOutput.getStdOut());
+            Utils::appendDataToFile(logFilePath, batteryOutput.getStdOutData(),
+                                    batteryOutput.getStdOutLength());
         } else {
             logger->warn(objectInfo + ": standard output of test is empty.");
         }
@@ -134,6 +248,7 @@ void IVariant::analyzeAndStoreBattOut() {
             Utils::appendStringToFile(logFilePath, batteryOutput.getStdErr());
         }
     }
+    TestRunner::tracePhase("output analysis", analysisStart);
 }
 
 
@@ -5,6 +5,7 @@
 #include "rtt/clinterface/batteryarg.h"
 #include "rtt/batteries/testconstants.h"
 #include "rtt/batteries/batteryoutput.h"
+#include "rtt/batteries/result/variantresult-res.h"
 
 namespace rtt {
 namespace batteries {
@@ -19,11 +20,15 @@ public:
      * @param testId Id of the test
      * @param testObjInf Info about parent object, used for logging
      * @param variantIdx Index of the new variant
+     * @param battery Battery of the variant
+     * @param binaryDataPath Path to file with data that will be analysed
      * @param cont Global settings
      * @return Obejct
      */
     static std::unique_ptr<IVariant> getInstance(int testId, std::string testObjInf,
-                                                 uint variantIdx, const GlobalContainer & cont);
+                                                 uint variantIdx, const BatteryArg & battery,
+                                                 const std::string & binaryDataPath,
+                                                 const GlobalContainer & cont);
 
     /**
      * @brief ~IVariant Desctructor.
@@ -42,6 +47,12 @@ public:
      */
     std::string getCliArguments() const;
 
+    /**
+     * @brief getExecutablePath
+     * @return Path to the binary of the battery
+     */
+    std::string getExecutablePath() const;
+
     /**
      * @brief getStdInput
      * @return Standard input that will be sent to the binary
@@ -52,7 +63,34 @@ public:
      * @brief getBatteryOutput
      * @return Output of the execution
      */
-    BatteryOutput getBatteryOutput() const;
+    const BatteryOutput & getBatteryOutput() const;
+
+    /**
+     * @brief setVariantResult Keeps result parsed from the output of the variant.
+     * Raw standard output of the variant is released, it isn't needed anymore.
+     * @param result Result of the variant
+     */
+    void setVariantResult(const result::VariantResult & result);
+
+    /**
+     * @brief getVariantResult
+     * @return Parsed result of the variant, nullptr if the output wasn't parsed yet
+     */
+    const result::VariantResult * getVariantResult() const;
+
+    /**
+     * @brief isDelegated
+     * @return True if the variant is executed by another instance of sharded
+     * run, it has no output in this instance then.
+     */
+    bool isDelegated() const;
+
+    /**
+     * @brief isCancelled
+     * @return True if the variant was cancelled before its output was
+     * obtained, it has no output then.
+     */
+    bool isCancelled() const;
 
     /**
      * @brief getTestId
@@ -66,36 +104,105 @@ public:
      */
     std::string getObjectInfo() const;
 
+    /**
+     * @brief getLogger
+     * @return Logger used by the variant
+     */
+    Logger * getLogger() const;
+
     /**
      * @brief getUserSettings
      * @return Settings set by user in battery configuration
      */
     std::vector<std::pair<std::string, std::string> > getUserSettings() const;
 
+    /**
+     * @brief getBattery
+     * @return Battery of the variant
+     */
+    clinterface::BatteryArg getBattery() const;
+
+    /**
+     * @brief getBinaryDataPath
+     * @return Path to the analyzed binary data
+     */
+    std::string getBinaryDataPath() const;
+
+    /**
+     * @brief getCostEstimate Static estimate of the amount of work done by the variant,
+     * derived from its settings. Units are specific for each battery.
+     * @return Estimated cost
+     */
+    virtual double getCostEstimate() const = 0;
+
+    /**
+     * @brief getInputDemand Amount of analysed data read by the variant,
+     * derived from its settings.
+     * @return Bytes read from the input, 0 if it isn't determined by the settings
+     */
+    virtual std::uint64_t getInputDemand() const = 0;
+
+    /**
+     * @brief getConfiguredTimeout Timeout set for the variant, its test
+     * or its battery in battery configuration, the most specific is used.
+     * @return Timeout in seconds, Configuration::VALUE_INT_NOT_SET if not set
+     */
+    int getConfiguredTimeout() const;
+
 protected:
+    /* Where the output of the variant comes from */
+    enum class OutputSource {
+        CACHE,          /* Loaded from result cache */
+        EXECUTION,      /* Variant must be executed by this instance */
+        OTHER_INSTANCE  /* Executed by another instance of sharded run */
+    };
+
     /* Set in constructor */
     Logger * logger;
+    ResultCache * resultCache;
+    SharedInput * sharedInput;
+    ShardQueue * shardQueue;
     std::string objectInfo;
     int testId;
     uint variantIdx;
     clinterface::BatteryArg battery;
     std::string binaryDataPath;
+    /* Path to analysed file that is passed to battery process */
+    std::string processDataPath;
     std::string logFilePath;
     std::string executablePath;
     std::string cliArguments;
     std::string stdInput;
     std::vector<std::pair<std::string, std::string>> userSettings;
+    int configuredTimeout;
 
     /* Set after execution */
     BatteryOutput batteryOutput;
     bool executed = false;
+    bool delegated = false;
+    bool cancelled = false;
+    bool awaitingOutput = false;
+    std::unique_ptr<result::VariantResult> variantResult;
 
     IVariant(int testId, std::string testObjInf,
-             uint variantIdx, const GlobalContainer & cont);
+             uint variantIdx, const BatteryArg & battery,
+             const std::string & binaryDataPath,
+             const GlobalContainer & cont);
 
     virtual void buildStrings() = 0;
 
     void analyzeAndStoreBattOut();
+
+    /* Loads output from result cache or claims the variant in sharded run. Variant
+     * executed by another instance is delegated to it, coordinator postpones it
+     * until its output is stored. */
+    OutputSource loadOutput(const std::string & cacheKey,
+                            std::vector<std::string> & attachments);
+
+    /* Stores output of the executed variant, output is stored only when the execution
+     * succeeded. Claim of failed variant is released, other instance can execute it. */
+    void storeOutput(const std::string & cacheKey, bool succeeded,
+                     const std::vector<std::string> & attachments = {});
 };
 
 } // namespace batteries
@@ -6,8 +6,10 @@ namespace rtt {
 namespace batteries {
 namespace niststs {
 
-std::unique_ptr<Battery> Battery::getInstance(const GlobalContainer & container) {
-    std::unique_ptr<Battery> b (new Battery(container));
+std::unique_ptr<Battery> Battery::getInstance(const GlobalContainer & container,
+                                              const BatteryArg & battery,
+                                              const std::string & binaryDataPath) {
+    std::unique_ptr<Battery> b (new Battery(container, battery, binaryDataPath));
     return b;
 }
 
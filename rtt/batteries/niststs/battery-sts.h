@@ -12,7 +12,9 @@ namespace niststs {
 
 class Battery : public IBattery {
 public:
-    static std::unique_ptr<Battery> getInstance(const GlobalContainer & container);
+    static std::unique_ptr<Battery> getInstance(const GlobalContainer & container,
+                                               const BatteryArg & battery,
+                                               const std::string & binaryDataPath);
 
     std::vector<std::unique_ptr<ITestResult>> getTestResults() const;
 private:
@@ -21,8 +23,9 @@ private:
     *** Methods ***
     ===============
     */
-    Battery(const GlobalContainer & container)
-        : IBattery(container) {}
+    Battery(const GlobalContainer & container, const BatteryArg & battery,
+            const std::string & binaryDataPath)
+        : IBattery(container, battery, binaryDataPath) {}
 };
 
 } // namespace niststs
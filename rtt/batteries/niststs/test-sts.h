@@ -6,7 +6,6 @@
 #include <vector>
 #include <sstream>
 #include <tuple>
-#include <mutex>
 
 #include "rtt/batteries/itest-batt.h"
 
@@ -17,16 +16,17 @@ namespace niststs {
 class Test : public ITest {
 public:
     static std::unique_ptr<Test> getInstance(std::string battObjInf, int testId ,
+                                             const BatteryArg & battery,
+                                             const std::string & binaryDataPath,
                                              const GlobalContainer & cont);
 
 private:
-    /* Variables */
-    std::unique_ptr<std::mutex> testDir_mux;
-
     /* Methods */
     Test(std::string battObjInf, int testIndex,
+         const BatteryArg & battery,
+         const std::string & binaryDataPath,
          const GlobalContainer & container)
-        : ITest(battObjInf, testIndex, container)
+        : ITest(battObjInf, testIndex, battery, binaryDataPath, container)
     {}
 };
 
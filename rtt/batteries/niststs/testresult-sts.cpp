@@ -1,5 +1,7 @@
 #include "testresult-sts.h"
 
+#include <algorithm>
+
 #include "libs/cephes/cephes.h"
 
 namespace rtt {
@@ -15,130 +17,154 @@ std::unique_ptr<TestResult> TestResult::getInstance(
                                        tests.at(0)->getLogger(),
                                        tests.at(0)->getLogicName()));
 
-    std::vector<result::SubTestResult> tmpSubTestResults;
-    std::vector<result::Statistic> tmpStatistics;
-
-
     /* Single test processing */
     for(const ITest * test : tests) {
-        /* Single variant processing */
+        /* Variants are usually parsed already, right after their execution.
+         * Cancelled variants have no output, results are partial. */
         for(IVariant * variant : test->getVariants()) {
-            Variant * stsVar =
-                    dynamic_cast<Variant *>(variant);
-            r->objectInfo = stsVar->getObjectInfo();
-            auto variantPVals = getVariantPValues(stsVar);
-
-            /* Single subtest processing */
-            for(const std::vector<double> & subTestPVals : variantPVals) {
-                if(subTestPVals.empty()) {
-                    r->logger->warn(r->objectInfo + 
-                                    ": no p-values extracted in subtest");
-                    continue;
-                }
-                tmpStatistics.push_back(result::Statistic::getInstance(
-                                            "Chi-Square",
-                                            chi2_stat(subTestPVals)));
-                tmpSubTestResults.push_back(result::SubTestResult::getInstance(
-                                                tmpStatistics, subTestPVals));
-                tmpStatistics.clear();
-            }
-            r->varRes.push_back(result::VariantResult::getInstance(
-                                    tmpSubTestResults,
-                                    stsVar->getUserSettings(),
-                                    stsVar->getBatteryOutput()));
-            tmpSubTestResults.clear();
+            if(variant->isCancelled())
+                continue;
+            r->objectInfo = variant->getObjectInfo();
+            r->varRes.push_back(ITestResult::getVariantResult(variant));
         }
     }
     r->evaluateSetPassed();
     return r;
 }
 
+result::VariantResult TestResult::parseVariant(const IVariant * variant) {
+    const Variant * stsVar =
+            dynamic_cast<const Variant *>(variant);
+    if(!stsVar)
+        raiseBugException("variant is not NIST STS variant");
+
+    std::vector<result::SubTestResult> tmpSubTestResults;
+    std::vector<result::Statistic> tmpStatistics;
+    auto variantPVals = getVariantPValues(stsVar);
+
+    /* Single subtest processing */
+    for(const std::vector<double> & subTestPVals : variantPVals) {
+        if(subTestPVals.empty()) {
+            stsVar->getLogger()->warn(stsVar->getObjectInfo() +
+                                      ": no p-values extracted in subtest");
+            continue;
+        }
+        tmpStatistics.push_back(result::Statistic::getInstance(
+                                    "Chi-Square",
+                                    chi2_stat(subTestPVals)));
+        tmpSubTestResults.push_back(result::SubTestResult::getInstance(
+                                        tmpStatistics, subTestPVals));
+        tmpStatistics.clear();
+    }
+    return result::VariantResult::getInstance(tmpSubTestResults,
+                                              stsVar->getUserSettings(),
+                                              stsVar->getBatteryOutput());
+}
+
 std::vector<std::vector<double>> TestResult::getVariantPValues(
-        Variant * variant) {
+        const Variant * variant) {
     if(variant->getTestId() == 12) {
-        /* Random excursion test */
-        uint subTestCount = 8; // THIS IS IMPORTANT!!!
-
-        static const std::regex RE_RND_EXC_PVALUES {
-            ".*x = -4.*p_value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*x = -3.*p_value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*x = -2.*p_value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*x = -1.*p_value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*x =  1.*p_value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*x =  2.*p_value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*x =  3.*p_value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*x =  4.*p_value = ([0|1]?\\.[0-9]+?)\\n"
+        /* Random excursion test, one subtest for each state */
+        static const std::vector<std::string> STATES {
+            "x = -4", "x = -3", "x = -2", "x = -1",
+            "x =  1", "x =  2", "x =  3", "x =  4"
         };
-        std::vector<std::vector<double>> rval(subTestCount);
-        auto testLog = variant->getBatteryOutput().getStdOut();
-        auto subTestIt = std::sregex_iterator(
-                             testLog.begin(), testLog.end(),
-                             RE_RND_EXC_PVALUES);
-        auto endIt = std::sregex_iterator();
-
-        for(; subTestIt != endIt ; ++subTestIt) {
-            std::smatch match = *subTestIt;
-            for(uint i = 1 ; i <= subTestCount ; ++i)
-                rval.at(i - 1).push_back(Utils::strtod(match[i].str()));
-        }
-        return rval;
+        return getExcursionPValues(variant->getBatteryOutput(),
+                                   STATES, "p_value = ");
     } else if(variant->getTestId() == 13) {
         /* Random excursion variant */
-        uint subTestCount = 18; // THIS IS ALSO IMPORTANT!!!
-
-        static const std::regex RE_RND_EXC_VAR_PVALUES {
-            ".*\\(x = -9\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x = -8\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x = -7\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x = -6\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x = -5\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x = -4\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x = -3\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x = -2\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x = -1\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x =  1\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x =  2\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x =  3\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x =  4\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x =  5\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x =  6\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x =  7\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x =  8\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
-            ".*\\(x =  9\\).*p-value = ([0|1]?\\.[0-9]+?)\\n"
+        static const std::vector<std::string> STATES {
+            "(x = -9)", "(x = -8)", "(x = -7)", "(x = -6)", "(x = -5)", "(x = -4)",
+            "(x = -3)", "(x = -2)", "(x = -1)", "(x =  1)", "(x =  2)", "(x =  3)",
+            "(x =  4)", "(x =  5)", "(x =  6)", "(x =  7)", "(x =  8)", "(x =  9)"
         };
-        std::vector<std::vector<double>> rval(subTestCount);
-        auto testLog = variant->getBatteryOutput().getStdOut();
-        auto subTestIt = std::sregex_iterator(
-                             testLog.begin(), testLog.end(),
-                             RE_RND_EXC_VAR_PVALUES);
-        auto endIt = std::sregex_iterator();
-
-        for(; subTestIt != endIt ; ++subTestIt) {
-            std::smatch match = *subTestIt;
-            for(uint i = 1 ; i <= subTestCount ; ++i) {
-                rval.at(i - 1).push_back(Utils::strtod(match[i].str()));
-            }
-        }
-        return rval;
+        return getExcursionPValues(variant->getBatteryOutput(),
+                                   STATES, "p-value = ");
     } else {
-        /* The rest of tests */
+        /* The rest of tests, single p-value on each line of the files */
         std::vector<std::vector<double>> rval;
-        std::vector<double> pValVec;
-        std::vector<std::string> pValVecStr;
-
         for(const std::string & pValFile : variant->getPValueFiles()) {
-            pValVecStr = Utils::split(pValFile, '\n');
-
-            for(const std::string & pVal : pValVecStr)
-                pValVec.push_back(Utils::strtod(pVal));
-
-            rval.push_back(std::move(pValVec));
-            pValVec.clear();
+            rval.emplace_back();
+            Utils::strtodLines(pValFile.data(), pValFile.data() + pValFile.size(),
+                               rval.back());
         }
         return rval;
     }
 }
 
+std::vector<std::vector<double>> TestResult::getExcursionPValues(
+        const BatteryOutput & testLog, const std::vector<std::string> & states,
+        const std::string & pValuePrefix) {
+    /* Each stream prints block of lines, one line for each state in the given
+     * order. Line ends with p-value of the state, "<state>...<prefix>(0?.[0-9]+)".
+     * Blocks are found line by line, so that the time is linear in stream count. */
+    std::vector<std::vector<double>> rval(states.size());
+    std::vector<const char *> lines;
+    const char * line = testLog.getStdOutData();
+    const char * end = line + testLog.getStdOutLength();
+    for(const char * lineEnd ; (lineEnd = std::find(line, end, '\n')) != end ; ) {
+        lines.push_back(line);
+        line = lineEnd + 1;
+    }
+    /* Start of the unterminated last line, which is never matched */
+    lines.push_back(line);
+
+    std::vector<std::string> blockValues(states.size());
+    for(size_t block = 0 ; block + states.size() < lines.size() ; ) {
+        size_t state = 0;
+        for( ; state < states.size() ; ++state) {
+            if(!matchExcursionLine(lines.at(block + state), lines.at(block + state + 1) - 1,
+                                   state == 0, states.at(state), pValuePrefix,
+                                   blockValues.at(state)))
+                break;
+        }
+        if(state != states.size()) {
+            ++block;
+            continue;
+        }
+        for(state = 0 ; state < states.size() ; ++state)
+            rval.at(state).push_back(Utils::strtod(blockValues.at(state)));
+        block += states.size();
+    }
+    return rval;
+}
+
+bool TestResult::matchExcursionLine(const char * line, const char * lineEnd,
+                                    bool firstLine, const std::string & state,
+                                    const std::string & pValuePrefix,
+                                    std::string & pValue) {
+    /* Carriage return ends the line as well, only the first line of the block
+     * can start after it, the others would not follow the previous one */
+    const char * carriageReturn = std::find(std::reverse_iterator<const char *>(lineEnd),
+                                            std::reverse_iterator<const char *>(line),
+                                            '\r').base();
+    if(carriageReturn != line) {
+        if(!firstLine)
+            return false;
+        line = carriageReturn;
+    }
+
+    /* P-value at the end of the line, "[0|1]?\.[0-9]+" */
+    const char * valueBegin = lineEnd;
+    while(valueBegin != line && std::isdigit(static_cast<unsigned char>(valueBegin[-1])))
+        --valueBegin;
+    if(valueBegin == lineEnd || valueBegin == line || *--valueBegin != '.')
+        return false;
+    if(valueBegin != line && (valueBegin[-1] == '0' || valueBegin[-1] == '1' ||
+                              valueBegin[-1] == '|'))
+        --valueBegin;
+
+    /* Prefix of the p-value is preceded by the state */
+    const char * prefixBegin = valueBegin - std::min<size_t>(valueBegin - line,
+                                                             pValuePrefix.size());
+    if(!std::equal(prefixBegin, valueBegin, pValuePrefix.begin(), pValuePrefix.end()) ||
+       std::search(line, prefixBegin, state.begin(), state.end()) == prefixBegin)
+        return false;
+
+    pValue.assign(valueBegin, lineEnd);
+    return true;
+}
+
 /* Following code is taken from NIST STS source code */
 /* Used for calculation of Chi2 statistic */
 double TestResult::chi2_stat(std::vector<double> pvals) {
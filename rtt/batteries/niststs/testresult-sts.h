@@ -13,13 +13,33 @@ class TestResult : public ITestResult {
 public:
     static std::unique_ptr<TestResult> getInstance(
             const std::vector<ITest *> & tests);
+
+    /**
+     * @brief parseVariant Extracts results from output and p-value
+     * files of single executed variant
+     * @param variant Executed variant
+     * @return Result of the variant
+     */
+    static result::VariantResult parseVariant(const IVariant * variant);
+
 private:
     TestResult(Logger * logger , std::string testName)
         : ITestResult(logger , testName)
     {}
 
     static std::vector<std::vector<double>> getVariantPValues(
-            Variant * variant);
+            const Variant * variant);
+
+    /* P-values of random excursion tests, for each state in the stats file */
+    static std::vector<std::vector<double>> getExcursionPValues(
+            const BatteryOutput & testLog, const std::vector<std::string> & states,
+            const std::string & pValuePrefix);
+
+    /* Extracts p-value of the state, returns false if the line doesn't match */
+    static bool matchExcursionLine(const char * line, const char * lineEnd,
+                                   bool firstLine, const std::string & state,
+                                   const std::string & pValuePrefix,
+                                   std::string & pValue);
 
     static double chi2_stat(std::vector<double> pvals);
 };
@@ -8,8 +8,10 @@ namespace niststs {
 std::mutex outputFile_mux;
 
 std::unique_ptr<Variant> Variant::getInstance(int testId, std::string testObjInf,
-                                              uint variantIdx, const GlobalContainer & cont) {
-    std::unique_ptr<Variant> v (new Variant(testId, testObjInf, variantIdx, cont));
+                                              uint variantIdx, const BatteryArg & battery,
+                                              const std::string & binaryDataPath,
+                                              const GlobalContainer & cont) {
+    std::unique_ptr<Variant> v (new Variant(testId, testObjInf, variantIdx, battery, binaryDataPath, cont));
     auto battConf = cont.getBatteryConfiguration();
 
     v->streamSize = battConf->getTestVariantParamString(
@@ -25,6 +27,7 @@ std::unique_ptr<Variant> Variant::getInstance(int testId, std::string testObjInf
     v->blockLength = battConf->getTestVariantParamString(
                          v->battery, testId, variantIdx,
                          Configuration::TAGNAME_BLOCK_LENGTH);
+    v->scratchDir = cont.getToolkitSettings()->getMiscNiststsScratchDir();
     v->resultSubDir = std::get<1>(
                           TestConstants::getNistStsTestData(
                               v->battery , v->testId));
@@ -40,13 +43,45 @@ void Variant::execute() {
      * Will deadlock if run without main thread. */
     uint expExitCode = BatteryArg::getExpectedExitCode(battery.getBatteryId());
 
-    {
-        std::lock_guard<std::mutex> l (*testDir_mux);
-        /* Cleaning result directory */
-        Utils::rmDirFiles(resultSubDir);
-        batteryOutput = TestRunner::executeBinary(logger, objectInfo, executablePath,
-                                                  expExitCode, cliArguments, stdInput);
-        readNistStsOutFiles();
+    /* Variant cancelled before it was taken (e.g. by fail-fast)
+     * doesn't wait for its input nor hash it for the cache */
+    if(TestRunner::isCancelled(this)) {
+        logger->info(objectInfo + ": test was cancelled, it won't be executed.");
+        cancelled = true;
+        executed = true;
+        return;
+    }
+
+    /* Result files of the battery are cached together with its output */
+    auto lookupStart = std::chrono::steady_clock::now();
+    sharedInput->acquire(binaryDataPath);
+    std::string cacheKey = resultCache->getKey(binaryDataPath, processDataPath,
+                                               executablePath, cliArguments, stdInput);
+    OutputSource source = loadOutput(cacheKey, pValueFiles);
+    TestRunner::tracePhase("input and cache lookup", lookupStart);
+    if(source == OutputSource::OTHER_INSTANCE) {
+        /* Postponed variant is executed again, delegated one has no output */
+        executed = delegated;
+        return;
+    }
+    if(source == OutputSource::EXECUTION) {
+        /* Each variant runs in its own working directory, so that
+         * variants of the same test can be executed in parallel. */
+        std::string workingDir = createWorkingDir();
+        if(!workingDir.empty()) {
+            batteryOutput = TestRunner::executeBinary(logger, objectInfo,
+                                                      Utils::getAbsolutePath(executablePath),
+                                                      expExitCode, cliArguments, stdInput,
+                                                      batteryOutput.getEmpty(), workingDir);
+            auto readStart = std::chrono::steady_clock::now();
+            readNistStsOutFiles(workingDir + resultSubDir);
+            TestRunner::tracePhase("result files", readStart);
+            Utils::removeDirectory(workingDir);
+        }
+        /* Runner doesn't execute cancelled variant or discards its output */
+        cancelled = batteryOutput.getExitCode() == -1 && TestRunner::isCancelled(this);
+        storeOutput(cacheKey, batteryOutput.getExitCode() == static_cast<int>(expExitCode) &&
+                              !pValueFiles.empty(), pValueFiles);
     }
 
     analyzeAndStoreBattOut();
@@ -54,11 +89,27 @@ void Variant::execute() {
     executed = true;
 }
 
-void Variant::setTestDir_mux(std::mutex * value) {
-    testDir_mux = value;
+double Variant::getCostEstimate() const {
+    /* Number of processed bits, in millions */
+    try {
+        return Utils::lexical_cast<double>(streamSize) *
+               Utils::lexical_cast<double>(streamCount) / 1e6;
+    } catch(std::runtime_error &) {
+        return 1;
+    }
 }
 
-std::vector<std::string> Variant::getPValueFiles() const {
+std::uint64_t Variant::getInputDemand() const {
+    /* Each stream is read as a sequence of bits */
+    try {
+        return Utils::lexical_cast<std::uint64_t>(streamSize) *
+               Utils::lexical_cast<std::uint64_t>(streamCount) / 8;
+    } catch(std::runtime_error &) {
+        return 0;
+    }
+}
+
+const std::vector<std::string> & Variant::getPValueFiles() const {
     return pValueFiles;
 }
 
@@ -76,8 +127,8 @@ void Variant::buildStrings() {
     std::stringstream stdIn;
     /* Choosing input file generator */
     stdIn << "0 ";
-    /* Choosing file */
-    stdIn << binaryDataPath << " ";
+    /* Choosing file, process runs in different working directory */
+    stdIn << processDataPath << " ";
     /* Execute only one test */
     stdIn << "0 ";
     /* Specify which test will be executed */
@@ -113,16 +164,41 @@ void Variant::buildStrings() {
         userSettings.push_back({"Block length", blockLength});
 }
 
-void Variant::readNistStsOutFiles() {
+std::string Variant::createWorkingDir() const {
+    std::string dirTemplate = scratchDir + "rtt-sts-XXXXXX";
+    std::vector<char> dirName(dirTemplate.begin(), dirTemplate.end());
+    dirName.push_back('\0');
+    if(mkdtemp(dirName.data()) == NULL) {
+        logger->warn(objectInfo + ": can't create working directory in " + scratchDir +
+                     ". Test won't be executed.");
+        return "";
+    }
+    std::string workingDir = std::string(dirName.data()) + "/";
+
+    try {
+        Utils::createDirectory(workingDir + resultSubDir);
+    } catch (std::runtime_error & ex) {
+        logger->warn(objectInfo + ": " + ex.what() + ". Test won't be executed.");
+        Utils::removeDirectory(workingDir);
+        return "";
+    }
+    /* Templates of the template matching tests are read relative to working directory */
+    if(Utils::isDirectory("templates"))
+        symlink(Utils::getAbsolutePath("templates").c_str(), (workingDir + "templates").c_str());
+
+    return workingDir;
+}
+
+void Variant::readNistStsOutFiles(const std::string & resultDir) {
     try {
-        auto testLog = Utils::readFileToString(resultSubDir + "stats.txt");
+        auto testLog = Utils::readFileToString(resultDir + "stats.txt");
         batteryOutput.appendStdOut(testLog);
 
-        if(Utils::fileExist(resultSubDir + "data1.txt")) {
+        if(Utils::fileExist(resultDir + "data1.txt")) {
             /* Multiple data<n>.txt files with p values */
             std::string dataFileName;
             for(uint i = 1 ; ; ++i) {
-                dataFileName = resultSubDir + "data";
+                dataFileName = resultDir + "data";
                 dataFileName.append(Utils::itostr(i));
                 dataFileName.append(".txt");
                 if(Utils::fileExist(dataFileName)) {
@@ -139,7 +215,7 @@ void Variant::readNistStsOutFiles() {
             /* Only one result file with p values */
             pValueFiles.push_back(
                         Utils::readFileToString(
-                            resultSubDir + "results.txt"));
+                            resultDir + "results.txt"));
         }
     } catch (std::runtime_error ex) {
         logger->warn(objectInfo + Strings::TEST_ERR_EXCEPTION_DURING_THREAD + ex.what());
@@ -11,17 +11,21 @@ namespace niststs {
 class Variant : public IVariant {
 public:
     static std::unique_ptr<Variant> getInstance(int testId, std::string testObjInf,
-                                                uint variantIdx, const GlobalContainer & cont);
+                                                uint variantIdx, const BatteryArg & battery,
+                                                const std::string & binaryDataPath,
+                                                const GlobalContainer & cont);
 
     void execute();
 
-    void setTestDir_mux(std::mutex * value);
+    double getCostEstimate() const;
 
-    std::vector<std::string> getPValueFiles() const;
+    std::uint64_t getInputDemand() const;
+
+    const std::vector<std::string> & getPValueFiles() const;
 
 private:
     /* Variables */
-    std::mutex * testDir_mux;
+    std::string scratchDir;
     std::string resultSubDir;
     std::string streamSize;
     std::string streamCount;
@@ -33,13 +37,20 @@ private:
 
     /* Methods */
     Variant(int testId, std::string testObjInf,
-            uint variantIdx, const GlobalContainer & cont)
-        : IVariant(testId, testObjInf, variantIdx, cont)
+            uint variantIdx, const BatteryArg & battery,
+            const std::string & binaryDataPath,
+            const GlobalContainer & cont)
+        : IVariant(testId, testObjInf, variantIdx, battery, binaryDataPath, cont)
     {}
 
     void buildStrings();
 
-    void readNistStsOutFiles();
+    /* Creates private working directory of the process with
+     * result directory structure expected by NIST STS. Returns
+     * empty string on failure. */
+    std::string createWorkingDir() const;
+
+    void readNistStsOutFiles(const std::string & resultDir);
 };
 
 } // namespace niststs
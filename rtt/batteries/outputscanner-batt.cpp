@@ -0,0 +1,161 @@
+#include "outputscanner-batt.h"
+
+#include <deque>
+#include <cctype>
+#include <cstring>
+
+namespace rtt {
+namespace batteries {
+
+const std::string OutputScanner::objectInfo = "Output scanner";
+
+/* Marks missing edge of the trie before failures are resolved */
+static const std::uint32_t NO_TRANSITION = UINT32_MAX;
+
+static unsigned char foldCase(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+std::shared_ptr<const OutputScanner> OutputScanner::getInstance(
+        const std::vector<std::string> & errorPatterns,
+        const std::vector<std::string> & warningPatterns) {
+    std::shared_ptr<OutputScanner> s (new OutputScanner());
+    s->transitions.assign(ALPHABET_SIZE, NO_TRANSITION);
+    s->nodeFound.assign(1, 0);
+
+    s->addPattern("error", FOUND_ERROR);
+    s->addPattern("warning", FOUND_WARNING);
+    for(const std::string & pattern : errorPatterns)
+        s->addPattern(pattern, FOUND_ERROR);
+    for(const std::string & pattern : warningPatterns)
+        s->addPattern(pattern, FOUND_WARNING);
+    s->resolveFailures();
+
+    return s;
+}
+
+std::shared_ptr<const OutputScanner> OutputScanner::getDefault() {
+    static const std::shared_ptr<const OutputScanner> scanner = getInstance();
+    return scanner;
+}
+
+void OutputScanner::scan(const std::string & output, State & state,
+                         std::vector<std::string> & errors,
+                         std::vector<std::string> & warnings) const {
+    const char * data = output.data();
+    size_t pos = state.scanned;
+    while(pos < output.length()) {
+        auto newline = static_cast<const char *>(
+                           std::memchr(data + pos, '\n', output.length() - pos));
+        size_t lineEnd = newline ? newline - data : output.length();
+        advance(data + pos, data + lineEnd, state.node, state.found);
+        /* Unterminated line is continued by the next chunk */
+        if(!newline)
+            break;
+
+        if(state.found)
+            addLine(output, state.lineStart, lineEnd, state.found, errors, warnings);
+        state.node = 0;
+        state.found = 0;
+        state.lineStart = pos = lineEnd + 1;
+    }
+    state.scanned = output.length();
+}
+
+void OutputScanner::addPattern(const std::string & pattern, unsigned char kind) {
+    if(pattern.empty())
+        throw RTTException(objectInfo, "pattern can't be empty");
+    if(pattern.find_first_of("\r\n") != std::string::npos)
+        throw RTTException(objectInfo, "pattern can't contain line break: " + pattern);
+
+    std::uint32_t node = 0;
+    for(char c : pattern) {
+        std::uint32_t & next = transitions[node * ALPHABET_SIZE + foldCase(c)];
+        if(next == NO_TRANSITION) {
+            next = nodeFound.size();
+            transitions.resize(transitions.size() + ALPHABET_SIZE, NO_TRANSITION);
+            nodeFound.push_back(0);
+        }
+        /* Reference may be invalidated by resize */
+        node = transitions[node * ALPHABET_SIZE + foldCase(c)];
+    }
+    nodeFound[node] |= kind;
+}
+
+void OutputScanner::resolveFailures() {
+    /* Nodes are resolved breadth first, failure of each node
+     * is shallower and its transitions are complete already */
+    std::vector<std::uint32_t> failure (nodeFound.size(), 0);
+    std::deque<std::uint32_t> queue;
+    for(size_t c = 0 ; c < ALPHABET_SIZE ; ++c) {
+        std::uint32_t & next = transitions[c];
+        if(next == NO_TRANSITION)
+            next = 0;
+        else
+            queue.push_back(next);
+    }
+    while(!queue.empty()) {
+        std::uint32_t node = queue.front();
+        queue.pop_front();
+        for(size_t c = 0 ; c < ALPHABET_SIZE ; ++c) {
+            std::uint32_t & next = transitions[node * ALPHABET_SIZE + c];
+            std::uint32_t fallback = transitions[failure[node] * ALPHABET_SIZE + c];
+            if(next == NO_TRANSITION) {
+                next = fallback;
+            } else {
+                failure[next] = fallback;
+                nodeFound[next] |= nodeFound[fallback];
+                queue.push_back(next);
+            }
+        }
+    }
+    /* Patterns are folded, upper case letters continue as lower case ones */
+    for(size_t node = 0 ; node < nodeFound.size() ; ++node) {
+        for(unsigned char c = 'A' ; c <= 'Z' ; ++c)
+            transitions[node * ALPHABET_SIZE + c] =
+                    transitions[node * ALPHABET_SIZE + foldCase(c)];
+    }
+}
+
+void OutputScanner::advance(const char * begin, const char * end,
+                            std::uint32_t & node, unsigned char & found) const {
+    const std::uint32_t * table = transitions.data();
+    const unsigned char * nodes = nodeFound.data();
+    std::uint32_t current = node;
+    unsigned char currentFound = found;
+    for(auto it = reinterpret_cast<const unsigned char *>(begin) ;
+        it != reinterpret_cast<const unsigned char *>(end) ; ++it) {
+        current = table[current * ALPHABET_SIZE + *it];
+        currentFound |= nodes[current];
+    }
+    node = current;
+    found = currentFound;
+}
+
+void OutputScanner::addLine(const std::string & output, size_t lineStart, size_t lineEnd,
+                            unsigned char found, std::vector<std::string> & errors,
+                            std::vector<std::string> & warnings) const {
+    /* Line is searched only after its last carriage return, it is
+     * searched again in the rare case that it contains one */
+    auto carriageReturn = static_cast<const char *>(
+                              memrchr(output.data() + lineStart, '\r', lineEnd - lineStart));
+    if(carriageReturn) {
+        lineStart = carriageReturn - output.data() + 1;
+        std::uint32_t node = 0;
+        found = 0;
+        advance(output.data() + lineStart, output.data() + lineEnd, node, found);
+        if(!found)
+            return;
+    }
+    while(lineStart < lineEnd && std::isspace(static_cast<unsigned char>(output[lineStart])))
+        ++lineStart;
+
+    std::string line = output.substr(lineStart, lineEnd - lineStart);
+    if(found & FOUND_ERROR)
+        errors.push_back(line);
+    if(found & FOUND_WARNING)
+        warnings.push_back(std::move(line));
+}
+
+} // namespace batteries
+} // namespace rtt
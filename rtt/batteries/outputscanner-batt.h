@@ -0,0 +1,103 @@
+#ifndef RTT_BATTERIES_OUTPUTSCANNER_H
+#define RTT_BATTERIES_OUTPUTSCANNER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "rtt/rttexception.h"
+
+namespace rtt {
+namespace batteries {
+
+/**
+ * @brief The OutputScanner class Finds lines of battery output that contain
+ * any of the error or warning patterns. Patterns are plain strings compared
+ * case insensitively (ASCII), all of them are searched for in single pass
+ * by Aho-Corasick automaton. Output can be scanned in chunks as it is read,
+ * position of the scan is kept in State. Scanner is immutable once created,
+ * it can be shared by outputs scanned in different threads.
+ *
+ * Line is detected only when it is terminated by newline. Only the part of the
+ * line after its last carriage return is searched and its leading whitespace
+ * is not stored.
+ */
+class OutputScanner {
+public:
+    /**
+     * @brief The State struct Position of the scan in the output
+     */
+    struct State {
+        /* Length of the output that was already scanned */
+        size_t scanned = 0;
+        /* Start of the line that is not terminated yet */
+        size_t lineStart = 0;
+        /* Node of the automaton and patterns found in the line so far */
+        std::uint32_t node = 0;
+        unsigned char found = 0;
+    };
+
+    /**
+     * @brief getInstance Creates scanner that detects patterns "error"
+     * and "warning" along with the given patterns
+     * @param errorPatterns Lines with these are errors
+     * @param warningPatterns Lines with these are warnings
+     * @return Scanner
+     * @throws RTTException if some pattern is empty or contains line break
+     */
+    static std::shared_ptr<const OutputScanner> getInstance(
+            const std::vector<std::string> & errorPatterns = {},
+            const std::vector<std::string> & warningPatterns = {});
+
+    /**
+     * @brief getDefault
+     * @return Scanner that detects only patterns "error" and "warning",
+     * single instance is shared
+     */
+    static std::shared_ptr<const OutputScanner> getDefault();
+
+    /**
+     * @brief scan Scans output from the position kept in state to its end.
+     * Lines terminated in this part are added into errors and warnings,
+     * line that contains both kinds of patterns is added into both.
+     * @param output Whole output scanned so far, previously scanned part must not change
+     * @param state Position of the scan, updated
+     * @param errors Detected error lines
+     * @param warnings Detected warning lines
+     */
+    void scan(const std::string & output, State & state,
+              std::vector<std::string> & errors,
+              std::vector<std::string> & warnings) const;
+
+private:
+    static const std::string objectInfo;
+    static const size_t ALPHABET_SIZE = 256;
+    static const unsigned char FOUND_ERROR   = 1;
+    static const unsigned char FOUND_WARNING = 2;
+
+    /* Transitions of the automaton with failure links already resolved,
+     * ALPHABET_SIZE entries for each node, node 0 is the root */
+    std::vector<std::uint32_t> transitions;
+    /* Patterns that end in the node or in any of its suffixes */
+    std::vector<unsigned char> nodeFound;
+
+    OutputScanner() {}
+
+    void addPattern(const std::string & pattern, unsigned char kind);
+
+    void resolveFailures();
+
+    /* Runs the automaton over the text, patterns found are added into found */
+    void advance(const char * begin, const char * end,
+                 std::uint32_t & node, unsigned char & found) const;
+
+    void addLine(const std::string & output, size_t lineStart, size_t lineEnd,
+                 unsigned char found, std::vector<std::string> & errors,
+                 std::vector<std::string> & warnings) const;
+};
+
+} // namespace batteries
+} // namespace rtt
+
+#endif // RTT_BATTERIES_OUTPUTSCANNER_H
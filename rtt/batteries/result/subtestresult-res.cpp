@@ -20,6 +20,14 @@ SubTestResult SubTestResult::getInstance(const std::vector<Statistic> & statisti
     return SubTestResult(statistics, pvalues);
 }
 
+SubTestResult SubTestResult::getInstance(std::vector<Statistic> && statistics,
+                                         std::vector<double> && pvalues) {
+    if(statistics.empty())
+        raiseBugException("empty statistics");
+
+    return SubTestResult(std::move(statistics), std::move(pvalues));
+}
+
 std::vector<std::pair<std::string, std::string> > SubTestResult::getTestParameters() const {
     return testParameters;
 }
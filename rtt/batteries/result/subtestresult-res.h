@@ -31,6 +31,17 @@ public:
             const std::vector<Statistic> & statistics,
             const std::vector<double> & pvalues);
 
+    /**
+     * @brief getInstance Used for initializing subtest with p-values,
+     * sets are moved into the subtest without copying
+     * @param statistics Set of statistics of the subtest
+     * @param pvalues Set of p-values
+     * @return instance
+     */
+    static SubTestResult getInstance(
+            std::vector<Statistic> && statistics,
+            std::vector<double> && pvalues);
+
     /**
      * @brief getTestParameters
      * @return Parameters of the subtest
@@ -63,9 +74,9 @@ public:
     std::vector<Statistic> getStatistics() const;
 
 private:
-    SubTestResult(const std::vector<Statistic> & statistics,
-                  const std::vector<double> & pvalues)
-        : statistics(statistics), pvalues(pvalues)
+    SubTestResult(std::vector<Statistic> statistics,
+                  std::vector<double> pvalues)
+        : statistics(std::move(statistics)), pvalues(std::move(pvalues))
     {}
 
     std::vector<Statistic> statistics;
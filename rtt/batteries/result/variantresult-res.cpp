@@ -24,7 +24,7 @@ std::vector<SubTestResult> VariantResult::getSubResults() const {
     return subResults;
 }
 
-BatteryOutput VariantResult::getBatteryOutput() const {
+const BatteryOutput & VariantResult::getBatteryOutput() const {
     return battOut;
 }
 
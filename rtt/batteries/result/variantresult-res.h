@@ -39,9 +39,9 @@ public:
 
     /**
      * @brief getBatteryOutput
-     * @return Raw output of battery executable
+     * @return Output of battery executable, raw standard output is not kept
      */
-    BatteryOutput getBatteryOutput() const;
+    const BatteryOutput & getBatteryOutput() const;
 
     /**
      * @brief getUserSettings
@@ -55,7 +55,10 @@ private:
                   const BatteryOutput & battOut)
         : subResults(subResults), userSettings(userSettings),
           battOut(battOut)
-    {}
+    {
+        /* Everything needed was parsed from it */
+        this->battOut.releaseStdOut();
+    }
 
     std::vector<SubTestResult> subResults;
     std::vector<std::pair<std::string, std::string>> userSettings;
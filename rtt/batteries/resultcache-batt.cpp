@@ -0,0 +1,193 @@
+#include "resultcache-batt.h"
+
+#include <cstdio>
+#include <thread>
+#include <fstream>
+
+namespace rtt {
+namespace batteries {
+
+const std::string ResultCache::FILE_HEADER = "RTT result cache 1";
+const std::string ResultCache::objectInfo  = "Result cache";
+
+std::unique_ptr<ResultCache> ResultCache::getInstance(Logger * logger,
+                                                      const std::string & cacheDir,
+                                                      bool sharedByHosts) {
+    std::unique_ptr<ResultCache> rc (new ResultCache());
+    rc->logger = logger;
+    rc->cacheDir = cacheDir;
+    rc->sharedByHosts = sharedByHosts;
+    if(!rc->cacheDir.empty() && rc->cacheDir.back() != '/')
+        rc->cacheDir.append("/");
+    if(rc->isEnabled())
+        logger->info(objectInfo + ": outputs of tests are stored in " + rc->cacheDir +
+                     " and reused by later runs on the same data, remove the directory"
+                     " to execute the tests again");
+
+    return rc;
+}
+
+bool ResultCache::isEnabled() const {
+    return !cacheDir.empty();
+}
+
+std::string ResultCache::getKey(const std::string & binaryDataPath,
+                                const std::string & processDataPath,
+                                const std::string & executablePath,
+                                const std::string & arguments,
+                                const std::string & input) const {
+    if(!isEnabled())
+        return "";
+
+    std::string fileHash = getFileHash(binaryDataPath, processDataPath);
+    if(fileHash.empty())
+        return "";
+
+    /* Executable is identified by its path, size and modification time,
+     * rebuilt battery won't reuse old entries. */
+    struct stat st;
+    if(stat(executablePath.c_str(), &st) != 0)
+        return "";
+
+    /* Input file can be passed to the battery under any name */
+    auto replaceDataPath = [&](std::string str) {
+        const std::string placeholder = "<input-data>";
+        for(const std::string & path : {processDataPath,
+                                        Utils::getAbsolutePath(binaryDataPath),
+                                        binaryDataPath}) {
+            for(size_t pos = str.find(path); pos != std::string::npos;
+                pos = str.find(path, pos + placeholder.length()))
+                str.replace(pos, path.length(), placeholder);
+        }
+        return str;
+    };
+
+    std::stringstream keySource;
+    keySource << "data " << fileHash << "\n";
+    if(sharedByHosts)
+        keySource << "executable " << Utils::getLastItemInPath(executablePath) << " "
+                  << st.st_size << "\n";
+    else
+        keySource << "executable " << Utils::getAbsolutePath(executablePath) << " "
+                  << st.st_size << " " << st.st_mtime << "\n";
+    keySource << "arguments " << replaceDataPath(arguments) << "\n"
+              << "input " << replaceDataPath(input) << "\n";
+    return Utils::hashString(keySource.str());
+}
+
+bool ResultCache::load(const std::string & key, BatteryOutput & output,
+                       std::vector<std::string> & attachments) const {
+    if(key.empty() || !Utils::fileExist(getEntryPath(key)))
+        return false;
+
+    std::string entry;
+    try {
+        entry = Utils::readFileToString(getEntryPath(key));
+    } catch(std::runtime_error & ex) {
+        logger->warn(objectInfo + ": " + ex.what());
+        return false;
+    }
+
+    /* Entry consists of header line and sections "<name> <length>\n<data>" */
+    /* Cached output is scanned and spilled as the output it replaces */
+    BatteryOutput cached = output.getEmpty();
+    std::vector<std::string> cachedAttachments;
+    size_t pos = entry.find('\n');
+    if(pos == std::string::npos || entry.substr(0, pos) != FILE_HEADER) {
+        logger->warn(objectInfo + ": invalid entry " + getEntryPath(key));
+        return false;
+    }
+    for(++pos; pos < entry.length(); ) {
+        size_t lineEnd = entry.find('\n', pos);
+        auto header = Utils::split(entry.substr(pos, lineEnd - pos), ' ');
+        size_t length = 0;
+        try {
+            if(lineEnd == std::string::npos || header.size() != 2)
+                throw std::runtime_error("invalid section");
+            length = Utils::lexical_cast<size_t>(header.at(1));
+            if(lineEnd + 1 + length > entry.length())
+                throw std::runtime_error("truncated section");
+        } catch(std::runtime_error &) {
+            logger->warn(objectInfo + ": invalid entry " + getEntryPath(key));
+            return false;
+        }
+        const char * data = entry.data() + lineEnd + 1;
+        if(header.at(0) == "stdout")
+            cached.appendStdOut(data, length);
+        else if(header.at(0) == "stderr")
+            cached.appendStdErr(data, length);
+        else if(header.at(0) == "attachment")
+            cachedAttachments.emplace_back(data, length);
+        pos = lineEnd + 1 + length;
+    }
+
+    output = std::move(cached);
+    attachments = std::move(cachedAttachments);
+    return true;
+}
+
+void ResultCache::store(const std::string & key, const BatteryOutput & output,
+                        const std::vector<std::string> & attachments) const {
+    if(key.empty())
+        return;
+
+    /* Same entry can be stored concurrently by another thread or process */
+    std::string entryPath = getEntryPath(key);
+    std::stringstream tmpPath;
+    tmpPath << entryPath << ".tmp" << getpid() << "-" << std::this_thread::get_id();
+    try {
+        Utils::createDirectory(Utils::getPathWithoutLastItem(entryPath));
+        /* Output is written directly, it isn't copied into the entry first */
+        std::ofstream entry (tmpPath.str(), std::ios::out | std::ios::binary);
+        entry << FILE_HEADER << "\n";
+        entry << "stdout " << output.getStdOutLength() << "\n";
+        entry.write(output.getStdOutData(), output.getStdOutLength());
+        entry << "stderr " << output.getStdErr().length() << "\n" << output.getStdErr();
+        for(const std::string & attachment : attachments)
+            entry << "attachment " << attachment.length() << "\n" << attachment;
+        entry.close();
+        if(!entry)
+            throw std::runtime_error("can't write entry " + tmpPath.str());
+        if(rename(tmpPath.str().c_str(), entryPath.c_str()) != 0)
+            throw std::runtime_error("can't create entry " + entryPath);
+    } catch(std::runtime_error & ex) {
+        /* Cache is optional, failure only means the variant will be executed again */
+        logger->warn(objectInfo + ": " + ex.what());
+        remove(tmpPath.str().c_str());
+    }
+}
+
+std::string ResultCache::getEntryPath(const std::string & key) const {
+    /* Entries are spread into subdirectories by first two characters */
+    return cacheDir + key.substr(0, 2) + "/" + key;
+}
+
+void ResultCache::release(const std::string & binaryDataPath) {
+    std::lock_guard<std::mutex> l (fileHashes_mux);
+    fileHashes.erase(binaryDataPath);
+}
+
+std::string ResultCache::getFileHash(const std::string & binaryDataPath,
+                                     const std::string & processDataPath) const {
+    std::shared_future<std::string> hash;
+    {
+        std::lock_guard<std::mutex> l (fileHashes_mux);
+        auto it = fileHashes.find(binaryDataPath);
+        if(it == fileHashes.end()) {
+            /* Deferred, computed once by the first thread that waits for it */
+            it = fileHashes.emplace(binaryDataPath, std::async(std::launch::deferred,
+                                                               [processDataPath]() {
+                try {
+                    return Utils::hashFile(processDataPath);
+                } catch(std::runtime_error &) {
+                    return std::string();
+                }
+            }).share()).first;
+        }
+        hash = it->second;
+    }
+    return hash.get();
+}
+
+} // namespace batteries
+} // namespace rtt
@@ -0,0 +1,116 @@
+#ifndef RTT_BATTERIES_RESULTCACHE_H
+#define RTT_BATTERIES_RESULTCACHE_H
+
+#include <map>
+#include <mutex>
+#include <future>
+
+#include "rtt/logger.h"
+#include "rtt/utils.h"
+#include "rtt/batteries/batteryoutput.h"
+
+namespace rtt {
+namespace batteries {
+
+/**
+ * @brief The ResultCache class Persistent content addressed cache of outputs of
+ * executed variants. Entry is identified by hash of the input data, identity of the
+ * battery executable and arguments and standard input of the process. Interrupted
+ * or repeated runs then execute only variants that are not in the cache.
+ * Outputs of the processes are cached, results are parsed from them again.
+ * Entries never expire and their total size is not limited, e.g. TestU01 Crush
+ * outputs take hundreds of MB. Removing the directory forces execution.
+ */
+class ResultCache {
+public:
+    /**
+     * @brief getInstance Creates cache
+     * @param logger Logger pointer
+     * @param cacheDir Directory with cache entries, if empty, cache is disabled
+     * and nothing is ever loaded or stored.
+     * @param sharedByHosts (optional) Cache is used by toolkits on different hosts,
+     * executable is then identified by its name and size only, the same battery
+     * installed on each host has different path or modification time.
+     * @return Cache
+     */
+    static std::unique_ptr<ResultCache> getInstance(Logger * logger,
+                                                    const std::string & cacheDir,
+                                                    bool sharedByHosts = false);
+
+    /**
+     * @brief isEnabled
+     * @return True if the cache directory was set
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief getKey Computes key of the variant execution. Hash of the input file is
+     * computed only once for each file, data must be available under processDataPath. Path of the input file is not part of the key,
+     * so the same data under different name share entries.
+     * @param binaryDataPath Path to analysed file
+     * @param processDataPath Path to analysed file as passed to the process
+     * @param executablePath Path to battery executable
+     * @param arguments Arguments of the process
+     * @param input Standard input of the process
+     * @return Key of the entry, empty if cache is disabled or key can't be computed
+     */
+    std::string getKey(const std::string & binaryDataPath,
+                       const std::string & processDataPath,
+                       const std::string & executablePath,
+                       const std::string & arguments,
+                       const std::string & input) const;
+
+    /**
+     * @brief load Reads entry from the cache
+     * @param key Key of the entry
+     * @param output Cached output will be stored here
+     * @param attachments Additional cached data of the entry (e.g. result
+     * files of the battery) will be stored here
+     * @return True if the entry was found
+     */
+    bool load(const std::string & key, BatteryOutput & output,
+              std::vector<std::string> & attachments) const;
+
+    /**
+     * @brief store Writes entry into cache. Entry is written under temporary
+     * name and renamed, so readers never see incomplete entry.
+     * @param key Key of the entry
+     * @param output Output of the process
+     * @param attachments Additional data of the entry
+     */
+    void store(const std::string & key, const BatteryOutput & output,
+               const std::vector<std::string> & attachments = {}) const;
+
+    /**
+     * @brief release Forgets hash of the input file after all its variants
+     * were executed. When the file is analysed again later, its hash is
+     * computed again, so a changed file doesn't reuse old entries.
+     * @param binaryDataPath Path to analysed file
+     */
+    void release(const std::string & binaryDataPath);
+
+private:
+    static const std::string FILE_HEADER;
+    static const std::string objectInfo;
+
+    Logger * logger;
+    std::string cacheDir;
+    bool sharedByHosts = false;
+    /* Hashes of input files, each is computed by the first caller that needs it */
+    mutable std::map<std::string, std::shared_future<std::string>> fileHashes;
+    mutable std::mutex fileHashes_mux;
+
+    ResultCache() {}
+
+    std::string getEntryPath(const std::string & key) const;
+
+    /* Data are read from the path used by the processes, that is the memory
+     * file when the input is shared, but the hash is stored per input file. */
+    std::string getFileHash(const std::string & binaryDataPath,
+                            const std::string & processDataPath) const;
+};
+
+} // namespace batteries
+} // namespace rtt
+
+#endif // RTT_BATTERIES_RESULTCACHE_H
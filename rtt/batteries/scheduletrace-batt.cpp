@@ -0,0 +1,88 @@
+#include "scheduletrace-batt.h"
+
+namespace rtt {
+namespace batteries {
+
+const std::string ScheduleTrace::objectInfo = "Schedule trace";
+
+std::unique_ptr<ScheduleTrace> ScheduleTrace::getInstance(Logger * logger,
+                                                          const std::string & path) {
+    std::unique_ptr<ScheduleTrace> st (new ScheduleTrace());
+    st->logger = logger;
+    st->path = path;
+    st->started = Clock::now();
+
+    return st;
+}
+
+bool ScheduleTrace::isEnabled() const {
+    return !path.empty();
+}
+
+void ScheduleTrace::setLaneName(int lane, const std::string & name) {
+    if(!isEnabled())
+        return;
+
+    /* Metadata events, lanes are sorted by their index */
+    nlohmann::json laneName = {
+        { "name", "thread_name" }, { "ph", "M" }, { "pid", 1 }, { "tid", lane },
+        { "args", { { "name", name } } }
+    };
+    nlohmann::json laneOrder = {
+        { "name", "thread_sort_index" }, { "ph", "M" }, { "pid", 1 }, { "tid", lane },
+        { "args", { { "sort_index", lane } } }
+    };
+    std::lock_guard<std::mutex> l (events_mux);
+    events.push_back(laneName);
+    events.push_back(laneOrder);
+}
+
+void ScheduleTrace::addSpan(int lane, const std::string & name, const std::string & category,
+                            Clock::time_point start, Clock::time_point end,
+                            const std::map<std::string, std::string> & args) {
+    if(!isEnabled())
+        return;
+
+    /* Complete event, nested spans of the lane must end before their parent */
+    double ts = getTimestamp(start);
+    nlohmann::json span = {
+        { "name", name }, { "cat", category }, { "ph", "X" }, { "pid", 1 }, { "tid", lane },
+        { "ts", ts }, { "dur", getTimestamp(end) - ts }
+    };
+    if(!args.empty())
+        span["args"] = args;
+
+    std::lock_guard<std::mutex> l (events_mux);
+    events.push_back(std::move(span));
+}
+
+void ScheduleTrace::save() const {
+    if(!isEnabled())
+        return;
+
+    nlohmann::json trace;
+    trace["displayTimeUnit"] = "ms";
+    {
+        std::lock_guard<std::mutex> l (events_mux);
+        trace["traceEvents"] = events;
+    }
+    trace["traceEvents"].push_back({
+        { "name", "process_name" }, { "ph", "M" }, { "pid", 1 },
+        { "args", { { "name", "Randomness Testing Toolkit" } } }
+    });
+
+    try {
+        Utils::createDirectory(Utils::getPathWithoutLastItem(path));
+        Utils::saveStringToFile(path, trace.dump());
+        logger->info(objectInfo + ": written to " + path);
+    } catch(std::exception & ex) {
+        logger->warn(objectInfo + ": can't write " + path + ": " + ex.what());
+    }
+}
+
+double ScheduleTrace::getTimestamp(Clock::time_point time) const {
+    return std::chrono::duration<double, std::micro>(time - started).count();
+}
+
+} // namespace batteries
+} // namespace rtt
@@ -0,0 +1,88 @@
+#ifndef RTT_BATTERIES_SCHEDULETRACE_H
+#define RTT_BATTERIES_SCHEDULETRACE_H
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <vector>
+
+#include "rtt/logger.h"
+#include "rtt/utils.h"
+
+#include "libs/moderncppjson/json.hpp"
+
+namespace rtt {
+namespace batteries {
+
+/**
+ * @brief The ScheduleTrace class Timeline of single execution of tests, written
+ * in Chrome trace event format (opens in about:tracing or Perfetto). Each worker
+ * slot and the process reaper have their own lane. Span of each variant covers
+ * all its phases on the worker (cache lookup, spawn, run, output analysis and
+ * parsing), so idle gaps between variants and stragglers are visible.
+ * Spans can be added from any thread.
+ */
+class ScheduleTrace {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @brief getInstance Creates trace, its time starts now
+     * @param logger Logger pointer
+     * @param path Path of the trace file, if empty, trace is disabled
+     * and nothing is recorded
+     * @return Trace
+     */
+    static std::unique_ptr<ScheduleTrace> getInstance(Logger * logger,
+                                                      const std::string & path);
+
+    /**
+     * @brief isEnabled
+     * @return True if the trace is recorded
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief setLaneName Names the lane in the timeline
+     * @param lane Lane index
+     * @param name Name of the lane
+     */
+    void setLaneName(int lane, const std::string & name);
+
+    /**
+     * @brief addSpan Records span, spans of single lane must either nest or not overlap
+     * @param lane Lane of the span
+     * @param name Name of the span
+     * @param category Category, used for filtering and coloring in the viewer
+     * @param start Start of the span
+     * @param end End of the span
+     * @param args (optional) Additional information shown with the span
+     */
+    void addSpan(int lane, const std::string & name, const std::string & category,
+                 Clock::time_point start, Clock::time_point end,
+                 const std::map<std::string, std::string> & args = {});
+
+    /**
+     * @brief save Writes the trace file
+     */
+    void save() const;
+
+private:
+    static const std::string objectInfo;
+
+    Logger * logger;
+    std::string path;
+    Clock::time_point started;
+    nlohmann::json events = nlohmann::json::array();
+    mutable std::mutex events_mux;
+
+    ScheduleTrace() {}
+
+    /* Microseconds since start of the trace */
+    double getTimestamp(Clock::time_point time) const;
+};
+
+} // namespace batteries
+} // namespace rtt
+
+#endif // RTT_BATTERIES_SCHEDULETRACE_H
@@ -0,0 +1,155 @@
+#include "shardqueue-batt.h"
+
+#include <cstdio>
+
+namespace rtt {
+namespace batteries {
+
+const int         ShardQueue::POLL_INTERVAL_SECONDS = 5;
+const int         ShardQueue::LEASE_SECONDS         = 120;
+const std::string ShardQueue::objectInfo            = "Shard queue";
+
+std::unique_ptr<ShardQueue> ShardQueue::getInstance(Logger * logger,
+                                                    const std::string & runDir,
+                                                    bool coordinator) {
+    std::unique_ptr<ShardQueue> sq (new ShardQueue());
+    sq->logger = logger;
+    sq->runDir = runDir;
+    sq->coordinator = coordinator;
+    if(!sq->isEnabled())
+        return sq;
+
+    if(sq->runDir.back() != '/')
+        sq->runDir.append("/");
+    try {
+        Utils::createDirectory(sq->runDir + "claims");
+    } catch(std::runtime_error & ex) {
+        throw RTTException(objectInfo, ex.what());
+    }
+
+    char hostName[256] = {};
+    gethostname(hostName, sizeof(hostName) - 1);
+    sq->owner = std::string(hostName) + " " + Utils::itostr(getpid());
+    sq->clockProbePath = sq->runDir + "clock." + hostName + "." + Utils::itostr(getpid());
+    sq->heartbeat = std::thread(&ShardQueue::renewClaims, sq.get());
+
+    logger->info(objectInfo + ": run directory " + sq->runDir + ", this instance is " +
+                 (coordinator ? "coordinator" : "worker"));
+    return sq;
+}
+
+ShardQueue::~ShardQueue() {
+    if(!heartbeat.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> l (heldClaims_mux);
+        stopping = true;
+    }
+    heldClaims_cv.notify_all();
+    heartbeat.join();
+    remove(clockProbePath.c_str());
+}
+
+bool ShardQueue::isEnabled() const {
+    return !runDir.empty();
+}
+
+bool ShardQueue::isCoordinator() const {
+    return coordinator;
+}
+
+std::string ShardQueue::getOutputDir() const {
+    if(!isEnabled())
+        return "";
+
+    return runDir + "outputs/";
+}
+
+bool ShardQueue::claim(const std::string & key) {
+    if(!isEnabled())
+        return true;
+
+    /* Only one instance creates each generation of the claim */
+    for(int generation = 0 ; ; ++generation) {
+        std::string claimPath = getClaimPath(key, generation);
+        int fd = open(claimPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0664);
+        if(fd >= 0) {
+            std::string content = owner + "\n";
+            write(fd, content.c_str(), content.length());
+            close(fd);
+            std::lock_guard<std::mutex> l (heldClaims_mux);
+            heldClaims[key] = claimPath;
+            return true;
+        }
+        if(errno != EEXIST) {
+            /* Variant is rather executed twice than never */
+            logger->warn(objectInfo + ": can't create claim " + claimPath + ": " +
+                         strerror(errno) + ". Variant is executed without claim.");
+            return true;
+        }
+        /* Claim removed by its owner in the meantime is created again */
+        struct stat st;
+        if(stat(claimPath.c_str(), &st) != 0) {
+            --generation;
+            continue;
+        }
+        /* Owner of the newest generation is alive */
+        if(!isExpired(st) && !Utils::fileExist(getClaimPath(key, generation + 1)))
+            return false;
+    }
+}
+
+void ShardQueue::release(const std::string & key, bool finished) {
+    if(!isEnabled())
+        return;
+
+    std::lock_guard<std::mutex> l (heldClaims_mux);
+    auto it = heldClaims.find(key);
+    if(it == heldClaims.end())
+        return;
+    if(!finished)
+        remove(it->second.c_str());
+    heldClaims.erase(it);
+}
+
+std::string ShardQueue::getClaimPath(const std::string & key, int generation) const {
+    return runDir + "claims/" + key + "." + Utils::itostr(generation);
+}
+
+bool ShardQueue::isExpired(const struct stat & claim) {
+    /* Claims are created and renewed by the file server's clock too */
+    return getFilesystemTime() - claim.st_mtime > LEASE_SECONDS;
+}
+
+time_t ShardQueue::getFilesystemTime() {
+    /* Time of touched file is set by the server (e.g. NFS SET_TO_SERVER_TIME) */
+    int fd = open(clockProbePath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0664);
+    struct stat st;
+    bool probed = fd >= 0 && futimens(fd, nullptr) == 0 && fstat(fd, &st) == 0;
+    int error = errno;
+    if(fd >= 0)
+        close(fd);
+    if(!probed) {
+        logger->warn(objectInfo + ": can't read time of the run directory from " +
+                     clockProbePath + ": " + strerror(error) + ". Local time is used.");
+        return Utils::getRawTime();
+    }
+    return st.st_mtime;
+}
+
+void ShardQueue::renewClaims() {
+    /* Claims are renewed several times during the lease, so that
+     * single delayed renewal doesn't make the claim expire */
+    std::unique_lock<std::mutex> l (heldClaims_mux);
+    while(!stopping) {
+        heldClaims_cv.wait_for(l, std::chrono::seconds(LEASE_SECONDS / 4));
+        for(const auto & claim : heldClaims) {
+            if(utimensat(AT_FDCWD, claim.second.c_str(), nullptr, 0) != 0)
+                logger->warn(objectInfo + ": can't renew claim " + claim.second + ": " +
+                             strerror(errno));
+        }
+    }
+}
+
+} // namespace batteries
+} // namespace rtt
@@ -0,0 +1,124 @@
+#ifndef RTT_BATTERIES_SHARDQUEUE_H
+#define RTT_BATTERIES_SHARDQUEUE_H
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "rtt/logger.h"
+#include "rtt/utils.h"
+#include "rtt/rttexception.h"
+
+namespace rtt {
+namespace batteries {
+
+/**
+ * @brief The ShardQueue class Work queue of sharded run, shared by instances
+ * of the toolkit through a run directory (e.g. on NFS mount). Instances are
+ * started with the same options and go through the same variants. Variant is
+ * executed by the instance that first creates its claim file, its output is
+ * then stored into the result cache in the run directory, where the other
+ * instances find it. Claim is a lease, its owner renews it while the variant
+ * runs. Claim of crashed instance expires and the variant is claimed again.
+ * Claims of expired owners are not removed, next generation of the claim is
+ * created instead, so that only one instance takes over the variant.
+ * Age of the claim is measured by the clock of the file server, read from
+ * modification time of probe file, so clocks of the hosts may differ.
+ */
+class ShardQueue {
+public:
+    /* Interval in which the coordinator checks variants executed elsewhere */
+    static const int POLL_INTERVAL_SECONDS;
+    /* Claim that wasn't renewed for this time has expired */
+    static const int LEASE_SECONDS;
+
+    /**
+     * @brief getInstance Creates queue
+     * @param logger Logger pointer
+     * @param runDir Directory of the sharded run, if empty,
+     * queue is disabled and every claim succeeds.
+     * @param coordinator True if this instance stores results of the run
+     * @return Queue
+     */
+    static std::unique_ptr<ShardQueue> getInstance(Logger * logger,
+                                                   const std::string & runDir,
+                                                   bool coordinator);
+
+    ~ShardQueue();
+
+    /**
+     * @brief isEnabled
+     * @return True if the run is sharded
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief isCoordinator
+     * @return True if this instance needs outputs of all variants
+     */
+    bool isCoordinator() const;
+
+    /**
+     * @brief getOutputDir
+     * @return Directory of the result cache shared by the instances
+     */
+    std::string getOutputDir() const;
+
+    /**
+     * @brief claim Claims the variant for this instance. Claim is renewed
+     * until it is released.
+     * @param key Key of the variant in the result cache
+     * @return True if this instance executes the variant, false if it is
+     * claimed by another instance that is still alive.
+     */
+    bool claim(const std::string & key);
+
+    /**
+     * @brief release Stops renewing of the claim. Claim of finished variant is
+     * kept, other instances find its output. Claim of variant that failed or was
+     * cancelled is removed, so that other instance can execute it again.
+     * @param key Key of the variant
+     * @param finished True if the output of the variant was stored
+     */
+    void release(const std::string & key, bool finished);
+
+private:
+    static const std::string objectInfo;
+
+    Logger * logger;
+    std::string runDir;
+    bool coordinator = false;
+    /* Written into claim files, identifies owner of the claim */
+    std::string owner;
+    /* Touched to read the current time of the file server */
+    std::string clockProbePath;
+
+    /* Claims held by this instance, renewed by the heartbeat thread */
+    std::map<std::string, std::string> heldClaims;
+    bool stopping = false;
+    std::mutex heldClaims_mux;
+    std::condition_variable heldClaims_cv;
+    std::thread heartbeat;
+
+    ShardQueue() {}
+
+    std::string getClaimPath(const std::string & key, int generation) const;
+
+    /* Claim that wasn't renewed in the lease period belongs to crashed instance */
+    bool isExpired(const struct stat & claim);
+
+    /* Current time of the file server of the run directory, local
+     * time is used if the probe file can't be touched */
+    time_t getFilesystemTime();
+
+    void renewClaims();
+};
+
+} // namespace batteries
+} // namespace rtt
+
+#endif // RTT_BATTERIES_SHARDQUEUE_H
@@ -0,0 +1,370 @@
+#include "sharedinput-batt.h"
+
+namespace rtt {
+namespace batteries {
+
+const std::string SharedInput::MODE_NONE    = "none";
+const std::string SharedInput::MODE_PREWARM = "prewarm";
+const std::string SharedInput::MODE_MEMFD   = "memfd";
+const int         SharedInput::DEFAULT_MAX_FILES = 2;
+const std::string SharedInput::objectInfo   = "Shared input";
+
+std::unique_ptr<SharedInput> SharedInput::getInstance(Logger * logger,
+                                                      const std::string & mode,
+                                                      bool interleave,
+                                                      int maxFiles,
+                                                      std::uint64_t memoryBudget,
+                                                      const std::string & scratchDir,
+                                                      std::uint64_t maxGeneratorOutput) {
+    if(mode != MODE_NONE && mode != MODE_PREWARM && mode != MODE_MEMFD)
+        raiseBugException("unknown input sharing mode: " + mode);
+    if(maxFiles <= 0)
+        raiseBugException("maximum number of memory files must be positive");
+
+    std::unique_ptr<SharedInput> si (new SharedInput());
+    si->logger = logger;
+    si->mode = mode;
+    si->interleave = interleave;
+    si->maxFiles = maxFiles;
+    si->memoryBudget = memoryBudget;
+    si->scratchDir = scratchDir;
+    si->maxGeneratorOutput = maxGeneratorOutput;
+
+    return si;
+}
+
+SharedInput::~SharedInput() {
+    for(auto & file : files) {
+        if(file.second.fd >= 0)
+            close(file.second.fd);
+    }
+}
+
+void SharedInput::addGeneratorOutput(const std::string & name, const std::string & command) {
+    int fd = memfd_create(("rtt:" + name).c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if(fd < 0)
+        throw RTTException(objectInfo, "can't create memory file: " +
+                           std::string(strerror(errno)));
+    int stdout_pipe[2];
+    if(pipe2(stdout_pipe, O_CLOEXEC)) {
+        close(fd);
+        throw RTTException(objectInfo, "generator pipe creation failed");
+    }
+
+    /* Generator inherits environment of the toolkit, so that it can use PATH */
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, stdout_pipe[1], 1);
+    /* Termination signals blocked by the toolkit are not blocked in the generator */
+    posix_spawnattr_t attributes;
+    sigset_t generatorMask;
+    sigemptyset(&generatorMask);
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setsigmask(&attributes, &generatorMask);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK);
+    const char * args[] = { "/bin/sh", "-c", command.c_str(), NULL };
+    pid_t pid = 0;
+    logger->info(objectInfo + ": executing generator " + command);
+    int status = posix_spawn(&pid, args[0], &actions, &attributes,
+                             const_cast<char **>(args), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    close(stdout_pipe[1]);
+    if(status != 0) {
+        close(stdout_pipe[0]);
+        close(fd);
+        throw RTTException(objectInfo, "can't execute generator: " +
+                           std::string(strerror(status)));
+    }
+
+    /* Generator output shares the memory budget with input files */
+    std::uint64_t memoryLimit = std::numeric_limits<std::uint64_t>::max();
+    if(memoryBudget > 0) {
+        std::lock_guard<std::mutex> l (files_mux);
+        memoryLimit = memoryBudget / 2 > memoryFileBytes ? memoryBudget / 2 - memoryFileBytes : 0;
+    }
+    uint64_t size = 0;
+    bool spilled = false;
+    try {
+        size = readGeneratorOutput(stdout_pipe[0], fd, spilled, memoryLimit);
+    } catch(RTTException &) {
+        /* Generator that doesn't end by SIGPIPE is killed */
+        close(stdout_pipe[0]);
+        kill(pid, SIGKILL);
+        while(waitpid(pid, &status, 0) < 0 && errno == EINTR);
+        close(fd);
+        throw;
+    }
+    close(stdout_pipe[0]);
+    while(waitpid(pid, &status, 0) < 0 && errno == EINTR);
+
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0 || size == 0 ||
+       (!spilled && !sealMemoryFile(fd))) {
+        close(fd);
+        throw RTTException(objectInfo, "generator failed, " + std::to_string(size) +
+                           " bytes were read, exit status " + Utils::intToHex(status, 4));
+    }
+    logger->info(objectInfo + ": generator produced " + std::to_string(size) + " bytes.");
+
+    std::promise<void> loaded;
+    loaded.set_value();
+    SharedFile file;
+    file.fd = fd;
+    file.spilled = spilled;
+    file.size = size;
+    file.loaded = loaded.get_future().share();
+
+    std::lock_guard<std::mutex> l (files_mux);
+    files[name] = file;
+    if(!spilled) {
+        ++memoryFiles;
+        memoryFileBytes += size;
+    }
+}
+
+std::string SharedInput::getProcessPath(const std::string & binaryDataPath) {
+    std::lock_guard<std::mutex> l (files_mux);
+    auto it = files.find(binaryDataPath);
+    /* Generator output is in memory in every mode */
+    if(it != files.end() && it->second.fd >= 0)
+        return getProcFdPath(it->second.fd);
+    if(mode != MODE_MEMFD || it != files.end())
+        return Utils::getAbsolutePath(binaryDataPath);
+
+    /* Memory file would be held until all variants on the file are stored. Variants
+     * of all files are interleaved, so only few files can be kept in memory. */
+    std::uint64_t size = 0;
+    try {
+        size = Utils::getFileSize(binaryDataPath);
+    } catch(std::runtime_error &) {
+        /* Process reports the missing file */
+        return Utils::getAbsolutePath(binaryDataPath);
+    }
+    if(memoryFiles >= maxFiles ||
+       (memoryBudget > 0 && memoryFileBytes + size > memoryBudget / 2)) {
+        logger->info(objectInfo + ": limit of memory files was reached, " + binaryDataPath +
+                     " will be read directly.");
+        SharedFile file;
+        file.loaded = std::async(std::launch::deferred, [this, binaryDataPath]() {
+            prewarmFile(binaryDataPath);
+        }).share();
+        files.emplace(binaryDataPath, file);
+        return Utils::getAbsolutePath(binaryDataPath);
+    }
+
+    std::string name = "rtt:" + Utils::getLastItemInPath(binaryDataPath);
+    int fd = memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if(fd < 0) {
+        logger->warn(objectInfo + ": can't create memory file for " + binaryDataPath +
+                     ": " + strerror(errno) + ". File will be read directly.");
+        return Utils::getAbsolutePath(binaryDataPath);
+    }
+    SharedFile file;
+    file.fd = fd;
+    file.size = size;
+    /* Deferred, loaded by the first variant that is executed on the file */
+    file.loaded = std::async(std::launch::deferred, [this, binaryDataPath, fd]() {
+        loadFile(binaryDataPath, fd);
+    }).share();
+    files.emplace(binaryDataPath, file);
+    ++memoryFiles;
+    memoryFileBytes += size;
+    return getProcFdPath(fd);
+}
+
+void SharedInput::acquire(const std::string & binaryDataPath) {
+    std::shared_future<void> loaded;
+    {
+        std::lock_guard<std::mutex> l (files_mux);
+        auto it = files.find(binaryDataPath);
+        if(it == files.end()) {
+            /* Memory file wasn't created, processes read the original file */
+            if(mode != MODE_PREWARM)
+                return;
+
+            SharedFile file;
+            file.loaded = std::async(std::launch::deferred, [this, binaryDataPath]() {
+                prewarmFile(binaryDataPath);
+            }).share();
+            it = files.emplace(binaryDataPath, file).first;
+        }
+        loaded = it->second.loaded;
+    }
+    loaded.get();
+}
+
+void SharedInput::hold(const std::string & binaryDataPath) {
+    std::lock_guard<std::mutex> l (files_mux);
+    ++holders[binaryDataPath];
+}
+
+void SharedInput::release(const std::string & binaryDataPath) {
+    std::lock_guard<std::mutex> l (files_mux);
+    auto holder = holders.find(binaryDataPath);
+    if(holder != holders.end()) {
+        if(--holder->second > 0)
+            return;
+        holders.erase(holder);
+    }
+    auto it = files.find(binaryDataPath);
+    if(it == files.end())
+        return;
+
+    if(it->second.fd >= 0) {
+        close(it->second.fd);
+        if(!it->second.spilled) {
+            --memoryFiles;
+            memoryFileBytes -= it->second.size;
+        }
+    }
+    files.erase(it);
+}
+
+std::uint64_t SharedInput::getMemoryUsage() const {
+    std::lock_guard<std::mutex> l (files_mux);
+    return memoryFileBytes;
+}
+
+void SharedInput::loadFile(const std::string & binaryDataPath, int fd) {
+    if(copyToMemory(binaryDataPath, fd)) {
+        logger->info(objectInfo + ": " + binaryDataPath + " was loaded into memory.");
+        return;
+    }
+
+    /* Memory file is replaced by the original file under the same
+     * descriptor, so the paths given to the processes stay valid. */
+    int fileFd = open(binaryDataPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileFd < 0 || dup3(fileFd, fd, O_CLOEXEC) < 0)
+        logger->warn(objectInfo + ": can't open " + binaryDataPath + ": " + strerror(errno));
+    if(fileFd >= 0)
+        close(fileFd);
+}
+
+bool SharedInput::copyToMemory(const std::string & binaryDataPath, int fd) {
+    int fileFd = open(binaryDataPath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    bool ok = fileFd >= 0 && fstat(fileFd, &st) == 0 && ftruncate(fd, st.st_size) == 0;
+
+    if(ok && st.st_size > 0) {
+        void * mem = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ok = mem != MAP_FAILED;
+        if(ok) {
+#ifdef MADV_HUGEPAGE
+            /* Huge pages are used if the system allows them for shared memory */
+            madvise(mem, st.st_size, MADV_HUGEPAGE);
+#endif
+            /* Pinned processes on every node read the data, no node is preferred */
+            if(interleave)
+                CpuPinning::interleaveMemory(mem, st.st_size);
+            posix_fadvise(fileFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            /* Data are read directly into the mapping. When memory runs out,
+             * read fails instead of the process getting SIGBUS. */
+            for(off_t done = 0 ; ok && done < st.st_size ; ) {
+                ssize_t count = read(fileFd, static_cast<char *>(mem) + done,
+                                     st.st_size - done);
+                if(count < 0 && errno == EINTR)
+                    continue;
+                if(count <= 0)
+                    ok = false;
+                else
+                    done += count;
+            }
+            munmap(mem, st.st_size);
+        }
+    }
+    if(fileFd >= 0)
+        close(fileFd);
+
+    if(ok)
+        ok = sealMemoryFile(fd);
+    if(!ok)
+        logger->warn(objectInfo + ": " + binaryDataPath + " can't be loaded into memory: " +
+                     strerror(errno) + ". File will be read directly.");
+    return ok;
+}
+
+uint64_t SharedInput::readGeneratorOutput(int pipeFd, int & fd, bool & spilled,
+                                          std::uint64_t memoryLimit) {
+    std::vector<char> buffer(1 << 20);
+    uint64_t size = 0;
+    for(;;) {
+        ssize_t count = read(pipeFd, buffer.data(), buffer.size());
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0)
+            return size;
+
+        if(maxGeneratorOutput > 0 && size + count > maxGeneratorOutput)
+            throw RTTException(objectInfo, "generator output exceeds " +
+                               std::to_string(maxGeneratorOutput / (1024 * 1024)) +
+                               " MiB, the limit is set by execution/generator-max-mb");
+
+        /* Output read so far is copied from the memory file into the scratch file */
+        if(!spilled && size + count > memoryLimit) {
+            std::string path = scratchDir + "rtt-generator-XXXXXX";
+            int spillFd = mkostemp(&path[0], O_CLOEXEC);
+            if(spillFd < 0)
+                throw RTTException(objectInfo, "generator output exceeds memory budget and"
+                                   " can't be moved into " + scratchDir + ": " +
+                                   strerror(errno));
+            /* File is removed at once, processes open it through the descriptor */
+            unlink(path.c_str());
+            off_t offset = 0;
+            while(offset < static_cast<off_t>(size)) {
+                ssize_t copied = sendfile(spillFd, fd, &offset, size - offset);
+                if(copied < 0 && errno == EINTR)
+                    continue;
+                if(copied <= 0) {
+                    close(spillFd);
+                    throw RTTException(objectInfo, "generator output can't be moved into " +
+                                       scratchDir + ": " + strerror(errno));
+                }
+            }
+            close(fd);
+            fd = spillFd;
+            spilled = true;
+            logger->info(objectInfo + ": generator output exceeds memory budget, it is"
+                                      " moved into " + scratchDir);
+        }
+
+        for(ssize_t done = 0 ; done < count ; ) {
+            ssize_t written = write(fd, buffer.data() + done, count - done);
+            if(written < 0 && errno == EINTR)
+                continue;
+            if(written <= 0)
+                throw RTTException(objectInfo, "can't store generator output: " +
+                                   std::string(strerror(errno)));
+            done += written;
+        }
+        size += count;
+    }
+}
+
+bool SharedInput::sealMemoryFile(int fd) {
+    return fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW |
+                                  F_SEAL_WRITE | F_SEAL_SEAL) == 0;
+}
+
+std::string SharedInput::getProcFdPath(int fd) {
+    /* Descriptor is close-on-exec, processes open their own
+     * descriptor of the memory file through procfs. */
+    return "/proc/" + Utils::itostr(getpid()) + "/fd/" + Utils::itostr(fd);
+}
+
+void SharedInput::prewarmFile(const std::string & binaryDataPath) {
+    /* Kernel starts reading the file into page cache asynchronously,
+     * processes then read it from memory. */
+    int fileFd = open(binaryDataPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileFd < 0) {
+        logger->warn(objectInfo + ": can't open " + binaryDataPath + ": " + strerror(errno));
+        return;
+    }
+    int err = posix_fadvise(fileFd, 0, 0, POSIX_FADV_WILLNEED);
+    if(err != 0)
+        logger->warn(objectInfo + ": readahead of " + binaryDataPath +
+                     " failed: " + strerror(err));
+    close(fileFd);
+}
+
+} // namespace batteries
+} // namespace rtt
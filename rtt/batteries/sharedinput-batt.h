@@ -0,0 +1,183 @@
+#ifndef RTT_BATTERIES_SHAREDINPUT_H
+#define RTT_BATTERIES_SHAREDINPUT_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <signal.h>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <future>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "rtt/logger.h"
+#include "rtt/utils.h"
+#include "rtt/bugexception.h"
+#include "rtt/rttexception.h"
+#include "rtt/batteries/cpupinning-batt.h"
+
+namespace rtt {
+namespace batteries {
+
+/**
+ * @brief The SharedInput class Provides input data files to battery processes.
+ * In memfd mode, each input file is read only once into sealed anonymous memory
+ * file and all processes open it through /proc/<toolkit pid>/fd/<n>. In prewarm
+ * mode, the input file is only announced to the kernel, so that it is read into
+ * page cache before the processes open it. Output of generator command
+ * is kept in memory file regardless of the mode, it is moved into unlinked
+ * file in the scratch directory when it doesn't fit into the memory budget.
+ * Memory file of input exists from construction of the first variant on the file
+ * until the file is released, number and size of such files are limited. Files
+ * over the limit are read directly after readahead, as in prewarm mode.
+ */
+class SharedInput {
+public:
+    static const std::string MODE_NONE;
+    static const std::string MODE_PREWARM;
+    static const std::string MODE_MEMFD;
+    /* Number of memory files of input files, when not set */
+    static const int DEFAULT_MAX_FILES;
+
+    /**
+     * @brief getInstance Creates shared input
+     * @param logger Logger pointer
+     * @param mode One of MODE_NONE, MODE_PREWARM or MODE_MEMFD
+     * @param interleave (optional) Memory files are spread over all NUMA nodes,
+     * used when the processes are pinned to different nodes.
+     * @param maxFiles (optional) Maximum number of memory files in memfd mode,
+     * including generator output
+     * @param memoryBudget (optional) Memory budget of the execution in bytes, memory
+     * files of input files take at most half of it. Not limited if 0.
+     * @param scratchDir (optional) Directory where generator output that
+     * exceeds the memory budget is moved
+     * @param maxGeneratorOutput (optional) Longest accepted generator output
+     * in bytes, not limited if 0
+     * @return Shared input
+     */
+    static std::unique_ptr<SharedInput> getInstance(Logger * logger,
+                                                    const std::string & mode,
+                                                    bool interleave = false,
+                                                    int maxFiles = DEFAULT_MAX_FILES,
+                                                    std::uint64_t memoryBudget = 0,
+                                                    const std::string & scratchDir = "/tmp/",
+                                                    std::uint64_t maxGeneratorOutput = 0);
+
+    ~SharedInput();
+
+    /**
+     * @brief addGeneratorOutput Executes generator command once and reads its
+     * whole standard output into sealed memory file. Output that would exceed
+     * half of the memory budget (together with other memory files) is moved into
+     * file in the scratch directory. Battery processes then read the output instead
+     * of the file name. Generator is slowed down by the pipe when the toolkit doesn't
+     * keep up with it.
+     * @param name Name used in place of the input file path
+     * @param command Shell command of the generator, its output must be finite
+     * @throws RTTException if the generator fails, its output exceeds the maximum
+     * generator output or it can't be stored
+     */
+    void addGeneratorOutput(const std::string & name, const std::string & command);
+
+    /**
+     * @brief getProcessPath Path under which the battery processes open the file.
+     * In memfd mode, the memory file is created here if it fits into the limits,
+     * but its content is loaded only in acquire.
+     * @param binaryDataPath Path to analysed file
+     * @return Absolute path that is passed to the battery processes
+     */
+    std::string getProcessPath(const std::string & binaryDataPath);
+
+    /**
+     * @brief acquire Must be called before process that uses the file is spawned.
+     * First call loads the file (memfd mode) or starts its readahead (prewarm mode),
+     * concurrent callers wait until the file is loaded. If the file can't be
+     * loaded into memory, processes will open the original file.
+     * @param binaryDataPath Path to analysed file
+     */
+    void acquire(const std::string & binaryDataPath);
+
+    /**
+     * @brief hold Announces execution that will use the file. Memory file is then
+     * kept until each holder releases it, executions running at the same time
+     * can share it. Must be called before variants on the file are created.
+     * @param binaryDataPath Path to analysed file
+     */
+    void hold(const std::string & binaryDataPath);
+
+    /**
+     * @brief release Frees memory held by the file after its last holder
+     * releases it, file that is not held is freed at once. Must be called only
+     * after all processes of the holder that use the file are finished.
+     * @param binaryDataPath Path to analysed file
+     */
+    void release(const std::string & binaryDataPath);
+
+    /**
+     * @brief getMemoryUsage Memory files are counted by their full size
+     * since their creation, even before they are loaded.
+     * @return Bytes held by memory files that were not released yet
+     */
+    std::uint64_t getMemoryUsage() const;
+
+private:
+    static const std::string objectInfo;
+
+    struct SharedFile {
+        /* -1 if processes open the original file */
+        int fd = -1;
+        /* Descriptor is file in the scratch directory, not memory file */
+        bool spilled = false;
+        std::uint64_t size = 0;
+        std::shared_future<void> loaded;
+    };
+
+    Logger * logger;
+    std::string mode;
+    bool interleave = false;
+    int maxFiles = DEFAULT_MAX_FILES;
+    std::uint64_t memoryBudget = 0;
+    std::string scratchDir;
+    std::uint64_t maxGeneratorOutput = 0;
+    std::map<std::string, SharedFile> files;
+    /* Number of executions that hold the file */
+    std::map<std::string, int> holders;
+    /* Memory files in files and their total size */
+    int memoryFiles = 0;
+    std::uint64_t memoryFileBytes = 0;
+    mutable std::mutex files_mux;
+
+    SharedInput() {}
+
+    /* Copies the file into memory file, on failure the descriptor
+     * is replaced by the original file. */
+    void loadFile(const std::string & binaryDataPath, int fd);
+
+    /* Reads whole file into memory file fd, returns false on failure */
+    bool copyToMemory(const std::string & binaryDataPath, int fd);
+
+    /* Reads pipe until its end into memory file fd, returns number of read bytes.
+     * When memory limit is reached, fd is replaced by file in the scratch directory. */
+    uint64_t readGeneratorOutput(int pipeFd, int & fd, bool & spilled,
+                                 std::uint64_t memoryLimit);
+
+    /* Memory file can't be modified by any process after sealing */
+    static bool sealMemoryFile(int fd);
+
+    /* Path under which processes open the descriptor of the toolkit */
+    static std::string getProcFdPath(int fd);
+
+    void prewarmFile(const std::string & binaryDataPath);
+};
+
+} // namespace batteries
+} // namespace rtt
+
+#endif // RTT_BATTERIES_SHAREDINPUT_H
@@ -1,118 +1,228 @@
 #include "testrunner-batt.h"
 
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
 namespace rtt {
 namespace batteries {
 
-/************************************************************************/
-/* Defined variables and corresponding condition variables and mutexes. */
-/************************************************************************/
-/* Sets how many test threads will be run at once. */
-std::atomic_int threadCount{0};
-/* Sets how long can be test running before killing */
-std::atomic_int timeout{0};
-/* Keeps tracks of how many running threads have not yet
- * spawned their child process. */
-uint                    withoutChild = 0;
-std::condition_variable withoutChild_cv;
-std::mutex              withoutChild_mux;
-/* Stores info about how many running threads are still waiting
- * for their child process to end. */
-uint                    waitingForChild = 0;
-std::condition_variable waitingForChild_cv;
-std::mutex              waitingForChild_mux;
-/* Stores pid of process that was reaped last.
- * Stores its exit code as well. */
-int                     finishedPExitCode = 0;
-std::atomic<pid_t>      finishedPid;
-std::condition_variable finishedPid_cv;
-std::mutex              finishedPid_mux;
-/* Used to block thread that reaps finished processes until
- * last finished process is assigned to correct thread for processing. */
-bool                    childReceived = false;
-std::condition_variable childReceived_cv;
-std::mutex              childReceived_mux;
-/* Keeps state of threads.
- * PENDING - there are still threads to be created;
- * READY   - single or more threads were spawned but there are more to be created;
- * DONE    - all available threads were created, now we are just waiting for them to end */
-int                     threadState = 0;
-std::condition_variable threadState_cv;
-std::mutex              threadState_mux;
+/**********************/
+/* Defined variables. */
+/**********************/
+/* Number of workers that are still running. Reaper ends
+ * after this drops to zero and all processes are reaped. */
+std::atomic_int activeWorkers{0};
+/* Processes without pidfd are polled by the reaper in this interval. */
+const int REAPER_POLL_INTERVAL_MS = 100;
+/* Size of the buffer for reading process output and requested capacity
+ * of the stdout pipe, verbose processes then wake the reaper less often. */
+const size_t READ_BUFFER_SIZE = 1024 * 1024;
+/* Process is confined to this multiple of its predicted peak memory, peak
+ * differs between runs and address space is larger than resident set. */
+const uint64_t CHILD_MEMORY_HEADROOM = 2;
+/* Numbers the cgroups of processes of this toolkit */
+std::atomic_uint childCgroups{0};
+
+const std::string TestRunner::MEMORY_LIMIT_NONE   = "none";
+const std::string TestRunner::MEMORY_LIMIT_RLIMIT = "rlimit";
+const std::string TestRunner::MEMORY_LIMIT_CGROUP = "cgroup";
+
+int                                     TestRunner::epollFd = -1;
+int                                     TestRunner::wakeupFd = -1;
+std::vector<TestRunner::ChildProcess *> TestRunner::newChildren;
+std::mutex                              TestRunner::newChildren_mux;
+std::vector<IVariant *>                 TestRunner::pendingVariants;
+std::map<const IVariant *, uint64_t>    TestRunner::reservedMemory;
+uint64_t                                TestRunner::usedMemory = 0;
+int                                     TestRunner::runningVariants = 0;
+std::mutex                              TestRunner::pendingVariants_mux;
+std::condition_variable                 TestRunner::pendingVariants_cv;
+bool                                    TestRunner::poolRunning = false;
+bool                                    TestRunner::poolClosing = false;
+int                                     TestRunner::poolMaxThreads = 0;
+std::vector<std::thread>                TestRunner::workers;
+std::map<const IVariant *, TestRunner::Execution *> TestRunner::variantExecutions;
+MemoryLimits                            TestRunner::memoryLimits;
+std::map<const IVariant *, int>         TestRunner::variantTimeouts;
+CpuPinning *                            TestRunner::cpuPinning = nullptr;
+std::set<const IVariant *>              TestRunner::cancelledVariants;
+std::set<const IVariant *>              TestRunner::finishedVariants;
+std::map<const IVariant *, std::chrono::steady_clock::time_point> TestRunner::postponedVariants;
+bool                                    TestRunner::stopRequested = false;
+std::chrono::steady_clock::time_point   TestRunner::stopDeadline;
+thread_local const IVariant *           TestRunner::currentVariant = nullptr;
+thread_local TestRunner::Execution *    TestRunner::currentExecution = nullptr;
+thread_local int                        TestRunner::traceLane = -1;
 
 /*************/
 /* Functions */
 /*************/
 void TestRunner::executeTests(Logger * logger,
                               std::vector<IVariant *> & variants,
-                              int maxThreads, int testTimeout) {
-    threadCount = maxThreads;
-    timeout = testTimeout;
+                              int maxThreads,
+                              const std::function<int(const IVariant *)> & testTimeout,
+                              const std::function<void(IVariant *)> & onVariantFinished,
+                              const MemoryLimits & memoryLimits,
+                              CpuPinning * cpuPinning,
+                              ScheduleTrace * trace) {
+    if(variants.empty())
+        return;
+
+    Execution execution;
+    execution.onVariantFinished = &onVariantFinished;
+    execution.trace = trace && trace->isEnabled() ? trace : nullptr;
+    execution.started = std::chrono::steady_clock::now();
+    execution.unfinishedVariants = variants.size();
+
+    /* State is guarded, stopExecution can be called from other threads at any time */
+    {
+        std::unique_lock<std::mutex> l (pendingVariants_mux);
+        /* Pool that has nothing left to execute can't be joined, its end is awaited */
+        pendingVariants_cv.wait(l, []() { return !poolRunning || !poolClosing; });
+        if(poolRunning) {
+            queueVariants(variants, execution, testTimeout, memoryLimits);
+            pendingVariants_cv.notify_all();
+            pendingVariants_cv.wait(l, [&]() { return execution.unfinishedVariants == 0; });
+            forgetVariants(variants);
+            return;
+        }
 
-    std::thread manager(threadManager , std::ref(variants));
-    /* String that will be used in logs */
-    std::string objectInfo = "Process reaper";
+        int newEpollFd = epoll_create1(EPOLL_CLOEXEC);
+        int newWakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if(newEpollFd < 0 || newWakeupFd < 0)
+            throw std::runtime_error("process reaper: can't create epoll instance");
+        epollFd = newEpollFd;
+        wakeupFd = newWakeupFd;
+
+        /* Nothing is running, state of the previous pool is dropped */
+        TestRunner::memoryLimits = memoryLimits;
+        TestRunner::cpuPinning = cpuPinning;
+        poolRunning = true;
+        poolMaxThreads = std::max(maxThreads, 1);
+        pendingVariants.clear();
+        reservedMemory.clear();
+        variantTimeouts.clear();
+        variantExecutions.clear();
+        cancelledVariants.clear();
+        finishedVariants.clear();
+        postponedVariants.clear();
+        usedMemory = 0;
+        runningVariants = 0;
+        queueVariants(variants, execution, testTimeout, memoryLimits);
+    }
 
-    /* Thread can proceed only after threadMaker notifies this thread. */
-    std::unique_lock<std::mutex> threadsReady_lock(threadState_mux);
-    threadState_cv.wait(threadsReady_lock ,
-                        []{ return (threadState == THREAD_STATE_DONE) ||
-                                   (threadState == THREAD_STATE_READY); });
-    if(threadState == THREAD_STATE_READY) {
-        /* Flip state if there are any unexecuted tests left */
-        threadState = THREAD_STATE_PENDING;
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeupFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeupFd, &ev);
+
+    reaperLoop(logger);
+
+    /* Workers ended, no call can join the closed pool and add more of them */
+    std::vector<std::thread> endedWorkers;
+    {
+        std::lock_guard<std::mutex> l (pendingVariants_mux);
+        endedWorkers.swap(workers);
     }
-    threadsReady_lock.unlock();
+    for(std::thread & t : endedWorkers)
+        t.join();
 
-    std::unique_lock<std::mutex> withoutChild_lock(withoutChild_mux , std::defer_lock);
-    std::unique_lock<std::mutex> waitingForChild_lock(waitingForChild_mux , std::defer_lock);
-    std::unique_lock<std::mutex> childReceived_lock(childReceived_mux , std::defer_lock);
+    {
+        std::lock_guard<std::mutex> l (pendingVariants_mux);
+        close(wakeupFd);
+        close(epollFd);
+        wakeupFd = -1;
+        epollFd = -1;
+        poolRunning = false;
+        poolClosing = false;
+    }
+    /* Calls waiting for the end of the pool start their own */
+    pendingVariants_cv.notify_all();
+}
 
-    for(;;) {
-        /* Here, I need to lock waitingForChild and withoutChild
-         * so no new threads will be created while this thread will wait.
-         * Furthermore, this thread will start reaping processes only if all currently
-         * active threads are waiting for child through finishedPid */
-        std::lock(waitingForChild_lock , withoutChild_lock);
-        waitingForChild_cv.wait(waitingForChild_lock ,
-                                []{ return waitingForChild == withoutChild; });
-        /* I can reap finished process now and annouce his PID. */
-        /* finishedPid is atomic variable, I can do this w/o mutex */
-        //int status;
-        finishedPid = wait(&finishedPExitCode);
-        /* I can unlock mutexes now, newly created threads
-         * can begin to wait for their process */
-        withoutChild_lock.unlock();
-        waitingForChild_lock.unlock();
-        if(finishedPid > 0) {
-            /* Some child process finished, hand it out to corresponding
-             * thread for processing */
-            /* Notifying all waiting threads that there is new finished process. */
-            finishedPid_cv.notify_all();
-            /* Thread that owns annouced pid will set childReceived to true.
-             * This thread cannot continue without knowing that pid is being processed
-             * to avoid rewriting of pid before all of the threads check it. */
-            childReceived_lock.lock();
-            childReceived_cv.wait(childReceived_lock , []{ return childReceived; });
-            /* Set to false for next iteration */
-            childReceived = false;
-            childReceived_lock.unlock();
-        } else {
-            /* -1 was returned by wait. That means either that this process has no other
-             * child processes (this thread can end), or some other error
-             * happened (very unlikely). */
-            if(errno == ECHILD) {
-                logger->info(objectInfo + ": all tests were executed and finished");
-                break;
-            } else {
-                logger->warn(objectInfo + ": wait() returned invalid value. "
-                                          "This thread will continue reaping "
-                                          "processes but deadlock or some other "
-                                          "errors are possible. Inspect logs.");
-            }
-        }
+void TestRunner::queueVariants(const std::vector<IVariant *> & variants, Execution & execution,
+                               const std::function<int(const IVariant *)> & testTimeout,
+                               const MemoryLimits & executionLimits) {
+    for(IVariant * v : variants) {
+        pendingVariants.push_back(v);
+        variantExecutions[v] = &execution;
+        variantTimeouts[v] = testTimeout(v);
+        /* Variant can't reserve more than the whole budget, otherwise it would never start */
+        if(memoryLimits.budget > 0 && executionLimits.predictPeak)
+            reservedMemory[v] = std::min(executionLimits.predictPeak(v), memoryLimits.budget);
+        /* Variants of execution started after stop are only passed through the workers */
+        if(stopRequested)
+            cancelledVariants.insert(v);
+    }
+
+    /* Only MAX_THREADS workers are running, each of them executes
+     * one variant at a time. */
+    size_t workerCount = std::min(workers.size() + variants.size(), (size_t)poolMaxThreads);
+    if(execution.trace) {
+        execution.trace->setLaneName(0, "process reaper");
+        for(size_t i = 1 ; i <= (size_t)poolMaxThreads ; ++i)
+            execution.trace->setLaneName(i, "worker " + Utils::itostr(i));
+    }
+    while(workers.size() < workerCount) {
+        ++activeWorkers;
+        workers.push_back(std::thread(workerThread, workers.size() + 1));
+    }
+}
+
+void TestRunner::forgetVariants(const std::vector<IVariant *> & variants) {
+    for(const IVariant * v : variants) {
+        variantExecutions.erase(v);
+        variantTimeouts.erase(v);
+        reservedMemory.erase(v);
+        cancelledVariants.erase(v);
+        finishedVariants.erase(v);
+        postponedVariants.erase(v);
+    }
+}
+
+void TestRunner::stopExecution(int graceSeconds) {
+    std::lock_guard<std::mutex> l (pendingVariants_mux);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(graceSeconds);
+    if(!stopRequested || deadline < stopDeadline)
+        stopDeadline = deadline;
+    stopRequested = true;
+    cancelledVariants.insert(pendingVariants.begin(), pendingVariants.end());
+    pendingVariants_cv.notify_all();
+
+    /* Reaper kills running processes when the grace period ends. Descriptor
+     * is closed under the same lock, so it is valid during execution only. */
+    if(wakeupFd >= 0) {
+        uint64_t one = 1;
+        write(wakeupFd, &one, sizeof(one));
+    }
+}
+
+bool TestRunner::isStopped() {
+    std::lock_guard<std::mutex> l (pendingVariants_mux);
+    return stopRequested;
+}
+
+void TestRunner::cancelVariants(const std::vector<const IVariant *> & variants) {
+    std::lock_guard<std::mutex> l (pendingVariants_mux);
+    for(const IVariant * v : variants) {
+        if(finishedVariants.count(v) == 0)
+            cancelledVariants.insert(v);
+    }
+    /* Cancelled variants are only passed through the workers, so that
+     * their owners are notified, they don't wait behind other variants. */
+    std::stable_partition(pendingVariants.begin(), pendingVariants.end(),
+                          [](const IVariant * v) {
+        return cancelledVariants.count(v) > 0;
+    });
+    pendingVariants_cv.notify_all();
+
+    /* Reaper kills running processes of the variants, descriptor
+     * is valid only under the lock, as in stopExecution. */
+    if(wakeupFd >= 0) {
+        uint64_t one = 1;
+        write(wakeupFd, &one, sizeof(one));
     }
-    /* Wait for manager to join all running threads, then join him. */
-    manager.join();
 }
 
 BatteryOutput TestRunner::executeBinary(Logger * logger,
@@ -120,238 +230,645 @@ BatteryOutput TestRunner::executeBinary(Logger * logger,
                                         const std::string & binaryPath,
                                         uint expExitCode,
                                         const std::string & arguments,
-                                        const std::string & input) {
+                                        const std::string & input,
+                                        const BatteryOutput & emptyOutput,
+                                        const std::string & workingDir) {
+    if(isCancelled(currentVariant)) {
+        logger->info(objectInfo + ": test was cancelled, it won't be executed.");
+        return emptyOutput;
+    }
+    int timeoutSeconds = 0;
+    /* Variant without predicted peak is confined to the whole budget */
+    uint64_t childLimit = memoryLimits.budget;
+    {
+        std::lock_guard<std::mutex> l (pendingVariants_mux);
+        auto it = variantTimeouts.find(currentVariant);
+        if(it == variantTimeouts.end())
+            raiseBugException("variant executed outside of worker");
+        timeoutSeconds = it->second;
+        auto reserved = reservedMemory.find(currentVariant);
+        if(reserved != reservedMemory.end() && reserved->second > 0)
+            childLimit = std::min(reserved->second * CHILD_MEMORY_HEADROOM, memoryLimits.budget);
+    }
+
+    auto spawnStart = std::chrono::steady_clock::now();
     int stdin_pipe[2];
     int stdout_pipe[2];
     int stderr_pipe[2];
 
     pid_t pid = 0;
     posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attributes;
 
-    if(pipe(stdin_pipe) || pipe(stdout_pipe) || pipe(stderr_pipe)) {
+    /* Pipes are created as close-on-exec so that children spawned
+     * concurrently by other workers won't inherit them. Duplicated
+     * descriptors of the child don't have the flag set. */
+    if(pipe2(stdin_pipe, O_CLOEXEC)) {
         logger->warn(objectInfo + ": pipe creation failed. Test won't be executed.");
-        {
-            /* Remove thread from list of threads without child, notify and end */
-            std::lock_guard<std::mutex> l (withoutChild_mux);
-            --withoutChild;
-        }
-        withoutChild_cv.notify_one();
-        return {};
+        return emptyOutput;
+    }
+    if(pipe2(stdout_pipe, O_CLOEXEC)) {
+        close(stdin_pipe[0]); close(stdin_pipe[1]);
+        logger->warn(objectInfo + ": pipe creation failed. Test won't be executed.");
+        return emptyOutput;
+    }
+    if(pipe2(stderr_pipe, O_CLOEXEC)) {
+        close(stdin_pipe[0]); close(stdin_pipe[1]);
+        close(stdout_pipe[0]); close(stdout_pipe[1]);
+        logger->warn(objectInfo + ": pipe creation failed. Test won't be executed.");
+        return emptyOutput;
     }
 
     /* Pipes will be mapped to I/O after process start */
-    /* Unused ends are closed */
     posix_spawn_file_actions_init(&actions);
-    /* Standard input */
-    posix_spawn_file_actions_addclose(&actions , stdin_pipe[1]);
     posix_spawn_file_actions_adddup2(&actions , stdin_pipe[0] , 0);
-    posix_spawn_file_actions_addclose(&actions , stdin_pipe[0]);
-    /* Standard output */
-    posix_spawn_file_actions_addclose(&actions , stdout_pipe[0]);
     posix_spawn_file_actions_adddup2(&actions , stdout_pipe[1] , 1);
-    posix_spawn_file_actions_addclose(&actions , stdout_pipe[1]);
-    /* Standard error output */
-    posix_spawn_file_actions_addclose(&actions , stderr_pipe[0]);
     posix_spawn_file_actions_adddup2(&actions , stderr_pipe[1] , 2);
-    posix_spawn_file_actions_addclose(&actions , stderr_pipe[1]);
+    /* Directory is changed only in the child, working
+     * directory of the toolkit is shared by all threads. */
+    if(!workingDir.empty())
+        posix_spawn_file_actions_addchdir_np(&actions , workingDir.c_str());
+    /* Termination signals are handled by the toolkit, its threads block them.
+     * Child gets clear mask and its own process group, so that signal sent to
+     * the terminal's foreground group doesn't end it before the grace period. */
+    sigset_t childMask;
+    sigemptyset(&childMask);
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setsigmask(&attributes , &childMask);
+    posix_spawnattr_setpgroup(&attributes , 0);
+    posix_spawnattr_setflags(&attributes , POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETPGROUP);
 
     int argc = 0;
     char ** args = buildArgv(arguments , &argc);
+    /* Limit is entered by shell wrapper before it executes the binary,
+     * so the battery never runs unconfined. */
+    std::string wrapper;
+    std::string cgroup = limitChildMemory(logger, objectInfo, childLimit, wrapper);
+    std::vector<char *> spawnArgs;
+    if(!wrapper.empty()) {
+        wrapper += "exec " + quoteShellArgument(binaryPath) + " \"$@\"";
+        spawnArgs = { const_cast<char *>("/bin/sh"), const_cast<char *>("-c"), &wrapper[0] };
+    }
+    spawnArgs.insert(spawnArgs.end(), args, args + argc);
 
-    /* Creating locks but not locking them yet */
-    std::unique_lock<std::mutex> finishedPid_lock(finishedPid_mux , std::defer_lock);
-    std::unique_lock<std::mutex> withoutChild_lock(withoutChild_mux , std::defer_lock);
-    std::unique_lock<std::mutex> waitingForChild_lock(waitingForChild_mux , std::defer_lock);
-    std::unique_lock<std::mutex> childReceived_lock(childReceived_mux , std::defer_lock);
-    std::unique_lock<std::mutex> threadsReady_lock(threadState_mux , std::defer_lock);
-
-    /* Need both locks, if they cannot be acquired
-     * main thread is waiting for process to end */
-    std::lock(finishedPid_lock , waitingForChild_lock);
+    /* Child inherits CPU affinity and memory policy of this thread */
+    int cpuSlot = -1;
+    std::string cpuInfo;
+    if(cpuPinning)
+        cpuSlot = cpuPinning->bindThread(cpuInfo);
 
     /* Starting child process of this thread */
-    logger->info(objectInfo + ": spawning child process with arguments " + arguments);
-    int status = posix_spawn(&pid , binaryPath.c_str() ,
-                             &actions , NULL , args , NULL);
-
-    if(status == 0) {
-        /* Process was started without problems, proceed */
-        logger->info(objectInfo + ": child process has pid " + Utils::itostr(pid));
-        /* Closing pipes */
-        close(stdin_pipe[0]);
-        close(stdout_pipe[1]);
-        close(stderr_pipe[1]);
-        if(!input.empty())
-            write(stdin_pipe[1] , input.c_str() , input.length());
-        /* Start thread for output reading. Thread will be mostly in blocked wait.
-         * Also will be essentially over as soon as the process finishes.
-         * With this, pipes won't be filled and won't block underlying process. */
-        BatteryOutput output;
-        std::thread reader(readOutput , std::ref(output),
-                           stdout_pipe , stderr_pipe);
-
-        /* Incrementing number of threads waiting.
-         * Only if this variable is same as withoutChild
-         * main thread can start reaping child processes. */
-        ++waitingForChild;
-        waitingForChild_lock.unlock();
-        waitingForChild_cv.notify_one();
-
-        /* Waiting for PID. PID is annouced by main thread and thread
-         * will work with his associated process only
-         * (because the thread owns the pipes to this process) */
-        auto now = std::chrono::system_clock::now();
-
-        if(!finishedPid_cv.wait_until(finishedPid_lock ,
-                                      now + std::chrono::seconds(timeout) ,
-                                      [&] { return finishedPid == pid; })) {
-            /* If thread goes into this branch, its process timeouted.
-             * Send kill signal to it, main thread will then reap it.
-             * That's why this go into wait once more (usually it will instantly return) */
-            logger->warn(objectInfo + ": child process with pid " + Utils::itostr(pid) + " timeouted."
-                         " Process will be killed now.");
-            kill(pid , SIGKILL);
-            finishedPid_cv.wait(finishedPid_lock , [&] { return finishedPid == pid; });
+    logger->info(objectInfo + ": spawning child process " +
+                 (cpuInfo.empty() ? "" : "on " + cpuInfo + " ") +
+                 "with arguments " + arguments);
+    int status = posix_spawn(&pid , wrapper.empty() ? binaryPath.c_str() : "/bin/sh" ,
+                             &actions , &attributes , spawnArgs.data() , NULL);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    destroyArgv(argc , args);
+
+    /* Closing ends of the pipes that belong to the child */
+    close(stdin_pipe[0]);
+    close(stdout_pipe[1]);
+    close(stderr_pipe[1]);
+
+    if(status != 0) {
+        /* Some nasty error happened at execution. Report and end thread */
+        logger->warn(objectInfo + ": can't execute child process.");
+        if(!cgroup.empty())
+            rmdir(cgroup.c_str());
+        if(cpuPinning)
+            cpuPinning->releaseSlot(cpuSlot);
+        close(stdin_pipe[1]);
+        close(stdout_pipe[0]);
+        close(stderr_pipe[0]);
+        return emptyOutput;
+    }
+
+    /* Process was started without problems, proceed */
+    logger->info(objectInfo + ": child process has pid " + Utils::itostr(pid));
+
+    if(!input.empty())
+        write(stdin_pipe[1] , input.c_str() , input.length());
+    close(stdin_pipe[1]);
+
+    /* Output pipes are read by the reaper, it can't block on them. */
+    fcntl(stdout_pipe[0], F_SETFL, fcntl(stdout_pipe[0], F_GETFL) | O_NONBLOCK);
+    fcntl(stderr_pipe[0], F_SETFL, fcntl(stderr_pipe[0], F_GETFL) | O_NONBLOCK);
+    /* Fails above pipe-max-size, default capacity is kept then */
+    fcntl(stdout_pipe[0], F_SETPIPE_SZ, static_cast<int>(READ_BUFFER_SIZE));
+
+    ScheduleTrace * trace = currentExecution ? currentExecution->trace : nullptr;
+    ChildProcess child;
+    child.objectInfo = objectInfo;
+    child.trace = trace;
+    /* Reaper scans the output for errors and warnings as it reads it */
+    child.output = emptyOutput;
+    child.pid = pid;
+    child.variant = currentVariant;
+    child.pidFd = syscall(SYS_pidfd_open, pid, 0);
+    child.stdoutFd = stdout_pipe[0];
+    child.stderrFd = stderr_pipe[0];
+    child.started = std::chrono::steady_clock::now();
+    child.timeout = timeoutSeconds;
+    child.deadline = child.started + std::chrono::seconds(timeoutSeconds);
+    std::future<void> finished = child.finished.get_future();
+
+    /* Handing the process over to the reaper */
+    {
+        std::lock_guard<std::mutex> l (newChildren_mux);
+        newChildren.push_back(&child);
+    }
+    uint64_t one = 1;
+    write(wakeupFd, &one, sizeof(one));
+
+    auto runStart = std::chrono::steady_clock::now();
+    if(trace)
+        trace->addSpan(traceLane, "spawn", "process", spawnStart, runStart,
+                       { { "pid", Utils::itostr(pid) }, { "cpu", cpuInfo } });
+
+    /* Waiting only for the process of this worker */
+    finished.wait();
+    if(trace)
+        trace->addSpan(traceLane, "run", "process", runStart, std::chrono::steady_clock::now(),
+                       { { "exit-code", Utils::itostr(child.exitCode) },
+                         { "stdout-bytes", Utils::itostr(child.output.getStdOutLength()) },
+                         { "stderr-bytes", Utils::itostr(child.output.getStdErr().length()) },
+                         { "reaper-read-us", Utils::itostr(
+                               std::chrono::duration_cast<std::chrono::microseconds>(
+                                   child.readTime).count()) } });
+    /* Reaped process left the cgroup */
+    if(!cgroup.empty())
+        rmdir(cgroup.c_str());
+    if(cpuPinning)
+        cpuPinning->releaseSlot(cpuSlot);
+
+    logger->info(objectInfo + ": child process with pid " + Utils::itostr(pid) +
+                 " finished in " + Utils::formatSeconds(child.output.getWallTime()) +
+                 ". Exit code "
+                 + Utils::intToHex(child.exitCode, 4) +
+                 " (" + Utils::itostr(child.exitCode) + ")");
+    /* Process ended by a signal after the stop (e.g. the signal was sent
+     * to all processes of the job) didn't finish, it is cancelled too. */
+    if(!child.cancelled && currentVariant && WIFSIGNALED(child.exitCode) && isStopped()) {
+        std::lock_guard<std::mutex> l (pendingVariants_mux);
+        cancelledVariants.insert(currentVariant);
+        child.cancelled = true;
+    }
+    /* Output of killed process is incomplete, it is not used at all */
+    if(child.cancelled) {
+        logger->info(objectInfo + ": test was cancelled, its output is discarded.");
+        return emptyOutput;
+    }
+    if(child.exitCode != expExitCode) {
+        logger->warn(objectInfo + ": received exit code (" +
+                     Utils::intToHex(child.exitCode, 4) + ") "
+                     "differs from the expected exit code (" +
+                     Utils::intToHex(expExitCode, 4) +
+                     ") of the test process");
+    }
+    return std::move(child.output);
+}
+
+void TestRunner::workerThread(int lane) {
+    using Clock = std::chrono::steady_clock;
+    auto toMicroseconds = [](Clock::duration d) {
+        return Utils::itostr(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    };
+    traceLane = lane;
+    for(;;) {
+        Clock::duration takeLockWait {};
+        Execution * execution = nullptr;
+        auto takeStart = Clock::now();
+        IVariant * variant = takeNextVariant(takeLockWait, execution);
+        if(!variant)
+            break;
+        auto started = Clock::now();
+        ScheduleTrace * trace = execution->trace;
+        if(trace)
+            trace->addSpan(lane, "take", "scheduling", takeStart, started,
+                           { { "lock-wait-us", toMicroseconds(takeLockWait) } });
+
+        currentVariant = variant;
+        currentExecution = execution;
+        variant->execute();
+        currentVariant = nullptr;
+        bool postponed = false;
+        auto finishStart = Clock::now();
+        Clock::duration finishLockWait {};
+        {
+            std::lock_guard<std::mutex> l (pendingVariants_mux);
+            finishLockWait = Clock::now() - finishStart;
+            auto reserved = reservedMemory.find(variant);
+            if(reserved != reservedMemory.end())
+                usedMemory -= reserved->second;
+            --runningVariants;
+            /* Postponed variant goes to the end of the queue, it is not finished */
+            postponed = postponedVariants.count(variant) > 0;
+            if(postponed)
+                pendingVariants.push_back(variant);
+            else
+                finishedVariants.insert(variant);
         }
-        /* Obtaining all possible mutexes, decrementing variables that
-         * track waiting and active threads, setting childReceived to true
-         * so main thread will be notified */
-        std::lock(withoutChild_lock , waitingForChild_lock , childReceived_lock);
-        logger->info(objectInfo + ": child process with pid " + Utils::itostr(pid) +
-                     " finished. Exit code "
-                     + Utils::intToHex(finishedPExitCode, 4) +
-                     " (" + Utils::itostr(finishedPExitCode) + ")");
-        if(finishedPExitCode != expExitCode) {
-            logger->warn(objectInfo + ": received exit code (" +
-                         Utils::intToHex(finishedPExitCode, 4) + ") "
-                         "differs from the expected exit code (" +
-                         Utils::intToHex(expExitCode, 4) +
-                         ") of the test process");
+        pendingVariants_cv.notify_all();
+        if(*execution->onVariantFinished && !postponed)
+            (*execution->onVariantFinished)(variant);
+        if(trace)
+            trace->addSpan(lane, variant->getObjectInfo(), "variant", started, Clock::now(),
+                           { { "queued-us", toMicroseconds(started - execution->started) },
+                             { "lock-wait-us", toMicroseconds(finishLockWait) },
+                             { "state", postponed ? "postponed" : isCancelled(variant) ?
+                                                    "cancelled" : "finished" } });
+        currentExecution = nullptr;
+        /* Execution of joined call ends when its last variant is finished */
+        if(!postponed) {
+            std::lock_guard<std::mutex> l (pendingVariants_mux);
+            --execution->unfinishedVariants;
+            pendingVariants_cv.notify_all();
         }
-        --waitingForChild;
-        --withoutChild;
-        /* Unlock mutexes, this thread no longer needs them */
-        finishedPid_lock.unlock();
-        waitingForChild_lock.unlock();
-        withoutChild_lock.unlock();
-        /* Notify threadCreator that number of active threads changed.
-         * He will spawn new threads if there is a need to. */
-        withoutChild_cv.notify_one();
-
-        /* This thread need to wait for notification from threadMaker
-         * that it is ok to continue and after that, main thread can
-         * be notified that child process was received and is being
-         * processed.*/
-        threadsReady_lock.lock();
-        threadState_cv.wait(threadsReady_lock ,
-                            []{ return (threadState == THREAD_STATE_DONE) ||
-                                       (threadState == THREAD_STATE_READY); });
-        if(threadState == THREAD_STATE_READY) {
-            /* Flip threadState so next thread must wait too. */
-            threadState = THREAD_STATE_PENDING;
+    }
+    traceLane = -1;
+
+    /* Last worker wakes up the reaper so it can end. */
+    if(--activeWorkers == 0) {
+        uint64_t one = 1;
+        write(wakeupFd, &one, sizeof(one));
+    }
+}
+
+IVariant * TestRunner::takeNextVariant(std::chrono::steady_clock::duration & lockWait,
+                                       Execution *& execution) {
+    auto lockStart = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> l (pendingVariants_mux);
+    lockWait = std::chrono::steady_clock::now() - lockStart;
+    for(;;) {
+        /* Running variant can be postponed and other calls can join the pool
+         * meanwhile, so the pool ends only when nothing is running */
+        if(pendingVariants.empty() && runningVariants == 0) {
+            poolClosing = true;
+            pendingVariants_cv.notify_all();
+            return nullptr;
+        }
+
+        /* Variants are started in queue order, variant that doesn't fit
+         * is skipped until running variants free enough memory. Memory
+         * released by the toolkit is noticed when next variant finishes. */
+        uint64_t heldMemory = memoryLimits.budget > 0 && memoryLimits.heldMemory ?
+                              memoryLimits.heldMemory() : 0;
+        auto now = std::chrono::steady_clock::now();
+        auto wakeup = std::chrono::steady_clock::time_point::max();
+        for(auto it = pendingVariants.begin() ; it != pendingVariants.end() ; ++it) {
+            /* Postponed variant waits for its time, cancelled one doesn't wait */
+            auto postponed = postponedVariants.find(*it);
+            if(postponed != postponedVariants.end() && postponed->second > now &&
+               cancelledVariants.count(*it) == 0) {
+                wakeup = std::min(wakeup, postponed->second);
+                continue;
+            }
+            auto reserved = reservedMemory.find(*it);
+            uint64_t needed = reserved == reservedMemory.end() ||
+                              cancelledVariants.count(*it) ? 0 : reserved->second;
+            if(runningVariants == 0 || heldMemory + usedMemory + needed <= memoryLimits.budget ||
+               memoryLimits.budget == 0) {
+                IVariant * variant = *it;
+                pendingVariants.erase(it);
+                if(postponed != postponedVariants.end())
+                    postponedVariants.erase(postponed);
+                usedMemory += needed;
+                ++runningVariants;
+                execution = variantExecutions.at(variant);
+                return variant;
+            }
+        }
+        /* Woken up when some running variant finishes, postponed variant
+         * is due or other call joins the pool */
+        if(wakeup == std::chrono::steady_clock::time_point::max())
+            pendingVariants_cv.wait(l);
+        else
+            pendingVariants_cv.wait_until(l, wakeup);
+    }
+}
+
+bool TestRunner::isCancelled(const IVariant * variant) {
+    std::lock_guard<std::mutex> l (pendingVariants_mux);
+    return cancelledVariants.count(variant) > 0;
+}
+
+void TestRunner::tracePhase(const std::string & name,
+                            std::chrono::steady_clock::time_point start) {
+    if(currentExecution && currentExecution->trace && traceLane >= 0)
+        currentExecution->trace->addSpan(traceLane, name, "phase", start,
+                                         std::chrono::steady_clock::now());
+}
+
+void TestRunner::postponeVariant(int delaySeconds) {
+    std::lock_guard<std::mutex> l (pendingVariants_mux);
+    if(currentVariant)
+        postponedVariants[currentVariant] = std::chrono::steady_clock::now() +
+                                            std::chrono::seconds(delaySeconds);
+}
+
+std::string TestRunner::limitChildMemory(Logger * logger, const std::string & objectInfo,
+                                         uint64_t limitKiB, std::string & wrapper) {
+    if(memoryLimits.childLimit == MEMORY_LIMIT_RLIMIT) {
+        /* Address space of the shell and of the binary after exec */
+        wrapper = "ulimit -v " + std::to_string(limitKiB) + "; ";
+        return "";
+    }
+    if(memoryLimits.childLimit != MEMORY_LIMIT_CGROUP)
+        return "";
+
+    /* Cgroup is prepared before the process exists, it enters it by itself */
+    std::string cgroup = memoryLimits.cgroupDir + "rtt-" + Utils::itostr(getpid()) +
+                         "-" + std::to_string(++childCgroups);
+    auto writeCgroupFile = [&](const std::string & name, const std::string & value) {
+        int fd = open((cgroup + "/" + name).c_str(), O_WRONLY | O_CLOEXEC);
+        bool ok = fd >= 0 && write(fd, value.c_str(), value.length()) ==
+                             static_cast<ssize_t>(value.length());
+        if(fd >= 0)
+            close(fd);
+        return ok;
+    };
+    if(mkdir(cgroup.c_str(), 0755) != 0 ||
+       !writeCgroupFile("memory.max", std::to_string(limitKiB * 1024))) {
+        logger->warn(objectInfo + ": can't limit memory of child process in cgroup " +
+                     cgroup + ": " + strerror(errno));
+        rmdir(cgroup.c_str());
+        return "";
+    }
+    wrapper = "echo $$ > " + quoteShellArgument(cgroup + "/cgroup.procs") + "; ";
+    return cgroup;
+}
+
+std::string TestRunner::quoteShellArgument(const std::string & argument) {
+    std::string quoted = "'";
+    for(char c : argument) {
+        if(c == '\'')
+            quoted += "'\\''";
+        else
+            quoted += c;
+    }
+    return quoted + "'";
+}
+
+void TestRunner::reaperLoop(Logger * logger) {
+    /* String that will be used in logs */
+    std::string objectInfo = "Process reaper";
+    /* Owners of descriptors registered in epoll */
+    std::map<int, ChildProcess *> fdOwners;
+    std::vector<ChildProcess *> running;
+    std::vector<epoll_event> events(64);
+
+    for(;;) {
+        acceptChildren(fdOwners, running);
+        if(activeWorkers == 0 && running.empty()) {
+            /* Workers register their processes before they end,
+             * check once more that nothing was left behind. */
+            acceptChildren(fdOwners, running);
+            if(running.empty()) {
+                logger->info(objectInfo + ": all tests were executed and finished");
+                break;
+            }
+        }
+
+        /* Epoll wakes up at the latest when the closest deadline passes */
+        auto now = std::chrono::steady_clock::now();
+        int waitMs = -1;
+        for(ChildProcess * child : running) {
+            int ms = -1;
+            if(child->pidFd < 0)
+                ms = REAPER_POLL_INTERVAL_MS;
+            if(!child->killed) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                child->deadline - now).count() + 1;
+                left = std::max(left, (decltype(left))0);
+                if(ms < 0 || left < ms)
+                    ms = left;
+            }
+            if(ms >= 0 && (waitMs < 0 || ms < waitMs))
+                waitMs = ms;
         }
-        threadsReady_lock.unlock();
-
-        /* Notify main thread that it can continue in reaping processes */
-        childReceived = true;
-        childReceived_lock.unlock();
-        childReceived_cv.notify_one();
-        /* This thread now completed all communication with other threads.
-         *  DO YOUR WORK SLAVE!!! */
-        reader.join();
-
-        return output;
-    } else {
-        /* Some nasty error happened at execution. Report and end thread */
-        logger->warn(objectInfo + ": can't execute child process.");
         {
-            /* Remove thread from list of threads without child, notify and end */
-            std::lock_guard<std::mutex> l (withoutChild_mux);
-            --withoutChild;
+            /* Running processes are killed when grace period of the stop ends */
+            std::lock_guard<std::mutex> l (pendingVariants_mux);
+            bool killable = std::any_of(running.begin(), running.end(),
+                                        [](const ChildProcess * c) { return !c->killed; });
+            if(stopRequested && killable) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                stopDeadline - now).count() + 1;
+                left = std::max(left, (decltype(left))0);
+                if(waitMs < 0 || left < waitMs)
+                    waitMs = left;
+            }
+        }
+
+        int count = epoll_wait(epollFd, events.data(), events.size(), waitMs);
+        if(count < 0 && errno != EINTR) {
+            logger->warn(objectInfo + ": epoll_wait() failed. "
+                                      "This thread will continue reaping "
+                                      "processes but deadlock or some other "
+                                      "errors are possible. Inspect logs.");
+        }
+
+        for(int i = 0 ; i < count ; ++i) {
+            int fd = events.at(i).data.fd;
+            if(fd == wakeupFd) {
+                uint64_t value;
+                read(wakeupFd, &value, sizeof(value));
+                continue;
+            }
+            auto owner = fdOwners.find(fd);
+            if(owner == fdOwners.end())
+                continue;
+            ChildProcess * child = owner->second;
+            if(fd == child->pidFd) {
+                tryReap(child);
+            } else if(!readOutput(child, fd)) {
+                if(fd == child->stdoutFd)
+                    closeChildFd(child->stdoutFd, fdOwners);
+                else
+                    closeChildFd(child->stderrFd, fdOwners);
+            }
+        }
+
+        now = std::chrono::steady_clock::now();
+        for(ChildProcess * child : running) {
+            if(!child->reaped && child->pidFd < 0) {
+                /* Without pidfd, process must be checked explicitly */
+                tryReap(child);
+            }
+            if(!child->reaped && !child->killed && now >= child->deadline) {
+                /* Process timeouted. Send kill signal to it,
+                 * it will be reaped in one of the next iterations. */
+                logger->warn(child->objectInfo + ": child process with pid " +
+                             Utils::itostr(child->pid) + " timeouted after " +
+                             Utils::itostr(child->timeout) + " seconds."
+                             " Process will be killed now.");
+                kill(child->pid , SIGKILL);
+                child->killed = true;
+            }
+        }
+
+        killCancelled(logger, running);
+
+        for(auto it = running.begin() ; it != running.end() ; ) {
+            if((*it)->reaped) {
+                finishChild(*it, fdOwners);
+                it = running.erase(it);
+            } else {
+                ++it;
+            }
         }
-        withoutChild_cv.notify_one();
-        return {};
     }
-    /* All locks go out of scope, so everything will be unlocked here */
 }
 
-void TestRunner::threadManager(std::vector<IVariant *> & variants) {
-    /* Incrementing variable withoutChild with each new thread */
-    std::unique_lock<std::mutex> withoutChild_lock(withoutChild_mux);
-    std::unique_lock<std::mutex> threadState_lock(threadState_mux , std::defer_lock);
-    std::vector<std::thread> threads;
-    /* Initial threads are activated. Only MAX_THREADS are running at a time. */
-    for(size_t i = 0 ; (i < threadCount) && i < variants.size() ; ++i) {
-        threads.push_back(std::thread(&IVariant::execute , variants.at(i)));
-        ++withoutChild;
-    }
-    /* Unlock so we won't block anyone */
-    withoutChild_lock.unlock();
-
-    /* Setting threadState to READY - more threads will be created */
-    threadState_lock.lock();
-    threadState = THREAD_STATE_READY;
-    threadState_lock.unlock();
-    /* Notify main thread that it can proceed */
-    threadState_cv.notify_one();
-
-    for(size_t i = threadCount ; i < variants.size() ; ++i) {
-        /* Each thread, after finishing its ITC, will notify this thread that
-         * withoutChild has changed. If there are less active threads than MAX_THREADS
-         * and there are some unexecuted tests left, this thread will add them. */
-        withoutChild_lock.lock();
-        withoutChild_cv.wait(withoutChild_lock , []{ return withoutChild < threadCount; });
-        threadState_lock.lock();
-        threads.push_back(std::thread(&IVariant::execute , variants.at(i)));
-        ++withoutChild;
-        /* More threads can be created and one was created.
-         * Let's share that with world */
-        threadState = THREAD_STATE_READY;
-
-        /* Unlock mutexes and notify other thread that might be waiting for this. */
-        threadState_lock.unlock();
-        withoutChild_lock.unlock();
-        threadState_cv.notify_one();
-    }
-
-    /* No more threads will be created, set threadState to DONE. */
-    threadState_lock.lock();
-    threadState = THREAD_STATE_DONE;
-    threadState_lock.unlock();
-    /* I don't think there will be ever thread that will wait for this.
-     * But better be safe than sorry. */
-    threadState_cv.notify_all();
-
-    /* Now there are no more threads to spawn. Thread will just
-     * wait here and join finishing threads when they are ready. */
-    for(std::thread & t : threads)
-        t.join();
-    /* Joining complete, end. */
+void TestRunner::acceptChildren(std::map<int, ChildProcess *> & fdOwners,
+                                std::vector<ChildProcess *> & running) {
+    std::vector<ChildProcess *> accepted;
+    {
+        std::lock_guard<std::mutex> l (newChildren_mux);
+        accepted.swap(newChildren);
+    }
+    for(ChildProcess * child : accepted) {
+        for(int fd : {child->pidFd, child->stdoutFd, child->stderrFd}) {
+            if(fd < 0)
+                continue;
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+            fdOwners[fd] = child;
+        }
+        running.push_back(child);
+    }
 }
 
-void TestRunner::readOutput(BatteryOutput & output ,
-                            int * stdout_pipe, int * stderr_pipe) {
-    std::string buffer(1024 , ' ');
-    std::string tmpStr;
-    size_t bytes_read;
-
-    std::vector<pollfd> pollVector {{stdout_pipe[0] , POLLIN , 0},
-                                    {stderr_pipe[0] , POLLIN , 0}};
-    for(; poll(&pollVector[0] , pollVector.size() , -1) > 0 ; ) {
-        if(pollVector[0].revents&POLLIN) {
-            bytes_read = read(stdout_pipe[0] , &buffer[0] , buffer.length());
-            tmpStr = buffer.substr(0, bytes_read);
-            output.appendStdOut(tmpStr);
+void TestRunner::killCancelled(Logger * logger, std::vector<ChildProcess *> & running) {
+    std::lock_guard<std::mutex> l (pendingVariants_mux);
+    if(stopRequested && std::chrono::steady_clock::now() >= stopDeadline) {
+        for(ChildProcess * child : running) {
+            if(child->variant)
+                cancelledVariants.insert(child->variant);
         }
-        else if(pollVector[1].revents&POLLIN) {
-            bytes_read = read(stderr_pipe[0] , &buffer[0] , buffer.length());
-            tmpStr = buffer.substr(0, bytes_read);
-            output.appendStdErr(tmpStr);
+    }
+    if(cancelledVariants.empty())
+        return;
+
+    for(ChildProcess * child : running) {
+        if(child->reaped || child->killed || cancelledVariants.count(child->variant) == 0)
+            continue;
+
+        logger->warn(child->objectInfo + ": child process with pid " +
+                     Utils::itostr(child->pid) + " was cancelled."
+                     " Process will be killed now.");
+        kill(child->pid , SIGKILL);
+        child->killed = true;
+        child->cancelled = true;
+    }
+}
+
+void TestRunner::tryReap(ChildProcess * child) {
+    /* Finished process is only checked first, its I/O
+     * counters disappear when it is reaped. */
+    siginfo_t info = {};
+    if(waitid(P_PID, child->pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0 ||
+       info.si_pid != child->pid)
+        return;
+    ResourceUsage usage;
+    readIoCounters(child->pid, usage);
+
+    int status = 0;
+    struct rusage ru;
+    if(wait4(child->pid, &status, WNOHANG, &ru) != child->pid)
+        return;
+    usage.measured   = true;
+    usage.userTime   = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6;
+    usage.systemTime = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+    usage.maxRss     = ru.ru_maxrss;
+
+    child->exitCode = status;
+    child->reaped = true;
+    child->reapedAt = std::chrono::steady_clock::now();
+    child->output.setExitCode(status);
+    child->output.setResourceUsage(usage);
+    child->output.setWallTime(std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - child->started).count());
+}
+
+void TestRunner::readIoCounters(pid_t pid, ResourceUsage & usage) {
+    std::string io;
+    try {
+        io = Utils::readFileToString("/proc/" + Utils::itostr(pid) + "/io");
+    } catch(std::runtime_error &) {
+        /* Kernel without task I/O accounting */
+        return;
+    }
+    for(const std::string & line : Utils::split(io, '\n')) {
+        auto item = Utils::split(line, ' ');
+        if(item.size() != 2)
+            continue;
+        if(item.at(0) == "rchar:")
+            usage.readBytes = std::strtoull(item.at(1).c_str(), nullptr, 10);
+        else if(item.at(0) == "wchar:")
+            usage.writtenBytes = std::strtoull(item.at(1).c_str(), nullptr, 10);
+    }
+}
+
+bool TestRunner::readOutput(ChildProcess * child, int fd) {
+    /* Data are appended directly from the reused buffer */
+    static thread_local std::vector<char> buffer(READ_BUFFER_SIZE);
+    /* Time is accounted to the process on each return */
+    struct ReadTimer {
+        ChildProcess * child;
+        std::chrono::steady_clock::time_point start;
+        ~ReadTimer() { child->readTime += std::chrono::steady_clock::now() - start; }
+    } timer { child, std::chrono::steady_clock::now() };
+    for(;;) {
+        ssize_t bytes_read = read(fd , buffer.data() , buffer.size());
+        if(bytes_read > 0) {
+            if(fd == child->stdoutFd)
+                child->output.appendStdOut(buffer.data(), bytes_read);
+            else
+                child->output.appendStdErr(buffer.data(), bytes_read);
+        } else if(bytes_read < 0 && errno == EINTR) {
+            continue;
+        } else if(bytes_read < 0 && errno == EAGAIN) {
+            return true;
+        } else {
+            /* End of the pipe or error, nothing else to read */
+            return false;
         }
-        else break; /* Nothing else to read */
     }
 }
 
+void TestRunner::finishChild(ChildProcess * child,
+                             std::map<int, ChildProcess *> & fdOwners) {
+    /* Everything the process wrote is already in the pipes. Pipe can stay open
+     * after the process exit only if it was inherited by its own children,
+     * these are not waited for. */
+    if(child->stdoutFd >= 0)
+        readOutput(child, child->stdoutFd);
+    if(child->stderrFd >= 0)
+        readOutput(child, child->stderrFd);
+    closeChildFd(child->stdoutFd, fdOwners);
+    closeChildFd(child->stderrFd, fdOwners);
+    closeChildFd(child->pidFd, fdOwners);
+    if(child->trace)
+        child->trace->addSpan(0, child->objectInfo, "reap", child->reapedAt,
+                              std::chrono::steady_clock::now(),
+                              { { "pid", Utils::itostr(child->pid) } });
+    child->finished.set_value();
+}
+
+void TestRunner::closeChildFd(int & fd, std::map<int, ChildProcess *> & fdOwners) {
+    if(fd < 0)
+        return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    fdOwners.erase(fd);
+    close(fd);
+    fd = -1;
+}
+
 char ** TestRunner::buildArgv(const std::string & arguments, int * argc) {
     std::vector<std::string> vecArg = Utils::split(arguments , ' ');
     char ** argv = new char * [vecArg.size() + 1];
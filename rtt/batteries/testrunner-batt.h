@@ -1,69 +1,187 @@
 #ifndef RTT_BATTERIES_TESTRUNNER_H
 #define RTT_BATTERIES_TESTRUNNER_H
 
-#include <poll.h>
 #include <unistd.h>
 #include <spawn.h>
+#include <fcntl.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <sys/types.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <thread>
-#include <condition_variable>
+#include <algorithm>
+#include <mutex>
+#include <future>
 #include <chrono>
 #include <atomic>
+#include <map>
+#include <set>
+#include <vector>
+#include <condition_variable>
+#include <functional>
 
 #include "rtt/logger.h"
 #include "rtt/batteries/ivariant-batt.h"
 #include "rtt/batteries/batteryoutput.h"
+#include "rtt/batteries/cpupinning-batt.h"
+#include "rtt/batteries/scheduletrace-batt.h"
 
 namespace rtt {
 namespace batteries {
 
+/**
+ * @brief The MemoryLimits struct Memory constraints of the execution.
+ * Variant is started only when its predicted peak memory fits into the budget
+ * together with the already running variants. Variant that is predicted to
+ * need more than the whole budget is started only when nothing else runs.
+ */
+struct MemoryLimits {
+    /* Memory in KiB for all running variants, 0 if not limited */
+    std::uint64_t budget = 0;
+    /* Predicted peak memory of the variant in KiB */
+    std::function<std::uint64_t(const IVariant *)> predictPeak;
+    /* Memory in KiB held by the toolkit for the variants (shared input files),
+     * it is taken from the budget. Nothing is held if not set. */
+    std::function<std::uint64_t()> heldMemory;
+    /* Each process is confined to multiple of its predicted peak memory (whole
+     * budget if unknown), one of TestRunner::MEMORY_LIMIT_*, processes are not
+     * confined if empty. */
+    std::string childLimit;
+    /* Delegated cgroup v2 directory, used with TestRunner::MEMORY_LIMIT_CGROUP */
+    std::string cgroupDir;
+};
+
 /**
  * @brief The TestRunner class This is static class responsible for execution of given set of tests.
  * Multiple tests can be executed at once.
  */
 class TestRunner {
 public:
+    /* Ways of confining memory of single test process */
+    static const std::string MEMORY_LIMIT_NONE;
+    static const std::string MEMORY_LIMIT_RLIMIT;
+    static const std::string MEMORY_LIMIT_CGROUP;
 
     /* Threads overview
-     * Main thread -    Handles incoming signals about
-     *                  finished processes, announces finished PIDs.
-     * Thread manager - Handles starting and joining of process threads.
-     * Process thread - Starts process and waits for its PID to be announced.
-     *                  If PID isn't announced withit TIMEOUT, kills process.
-     *                  Also starts reader thread and joins it at the end.
-     * Reader thread  - Reads process pipes. Usually is blocked by read.
-     *                  It is important that this thread is running, otherwise
-     *                  pipes could be filled up, blocking associated process.*/
-
-    static const int THREAD_STATE_PENDING       = 0;
-    static const int THREAD_STATE_READY         = 1;
-    static const int THREAD_STATE_DONE          = 2;
+     * Main thread    - Runs process reaper. Reaper is single event loop
+     *                  that watches pidfd of each running child process
+     *                  together with its stdout and stderr pipes. It reads
+     *                  the output, kills processes that exceed timeout and
+     *                  reaps finished processes. Each finished process is
+     *                  handed only to the worker that spawned it.
+     * Worker threads - Pool of at most maxThreads threads. Worker takes
+     *                  next variant from the queue and executes it. Spawned
+     *                  process is registered in the reaper and the worker then
+     *                  waits only for completion of its own process. Workers
+     *                  end when the queue is empty and no variant is running.
+     * Joined threads - Threads that called executeTests while the pool was
+     *                  running. Their variants are added into the queue of the
+     *                  pool and they wait until these variants are finished. */
 
     /**
-     * @brief executeTests Called from battery's runTests code. This is main thread,
-     * creates one threadManager and receives and hands out IDs of
-     * finished child processes of RTT.
+     * @brief executeTests Called from battery's runTests code. Creates pool of worker
+     * threads that execute given variants and runs process reaper in calling thread
+     * until all variants are executed. Call made from other thread while the pool
+     * is running joins the pool: its variants are queued after the pending ones,
+     * the call returns as soon as they are finished. Pool executes the joined
+     * variants with its own limits (threads, memory budget and confinement,
+     * CPU pinning), the call that created it returns after all of them.
      * @param logger pointer to thread-safe logger object
      * @param variants all test variants in the battery that will be executed
      * @param maxThreads maximum of parallel running threads
-     * @param testTimeout timeout of single test, after this time, the test will be killed.
+     * @param testTimeout timeout of each variant in seconds, after this time, its process
+     * will be killed. Called once for each variant when the execution starts.
+     * @param onVariantFinished (optional) called from worker thread after each variant
+     * is executed, calls can run concurrently. Only variants of this call are reported.
+     * @param memoryLimits (optional) memory budget of the variants and confinement
+     * of the processes, memory is not limited by default. Joined call uses only its
+     * prediction of peak memory.
+     * @param cpuPinning (optional) binds processes to CPUs, processes are not bound if
+     * null. Unused by joined call.
+     * @param trace (optional) records timeline of variants of this call, lane 0 is
+     * the reaper, lanes 1 to maxThreads are the workers. Nothing is recorded if null.
      */
     static void executeTests(Logger * logger, std::vector<IVariant *> & variants,
-                             int maxThreads, int testTimeout);
+                             int maxThreads,
+                             const std::function<int(const IVariant *)> & testTimeout,
+                             const std::function<void(IVariant *)> & onVariantFinished = nullptr,
+                             const MemoryLimits & memoryLimits = MemoryLimits(),
+                             CpuPinning * cpuPinning = nullptr,
+                             ScheduleTrace * trace = nullptr);
+
+    /**
+     * @brief cancelVariants Cancels execution of given variants during executeTests.
+     * Variants that weren't started are not executed, processes of running variants
+     * are killed. Output of cancelled variant is empty. Variants that are already
+     * finished are not affected. Can be called from onVariantFinished.
+     * @param variants Variants to cancel
+     */
+    static void cancelVariants(const std::vector<const IVariant *> & variants);
+
+    /**
+     * @brief stopExecution Stops the execution, e.g. when the toolkit received
+     * termination signal. Variants that weren't started are cancelled, running
+     * processes are given grace period to finish, then they are killed and
+     * their variants are cancelled too. Executions started later cancel all
+     * their variants. Can be called from any thread, repeated call can
+     * only shorten the grace period.
+     * @param graceSeconds Time given to the running processes
+     */
+    static void stopExecution(int graceSeconds);
+
+    /**
+     * @brief isStopped
+     * @return True if stopExecution was called
+     */
+    static bool isStopped();
+
+    /**
+     * @brief isCancelled
+     * @param variant
+     * @return True if the variant was cancelled, its output is then empty
+     * or incomplete and it must be executed again to get its results.
+     */
+    static bool isCancelled(const IVariant * variant);
+
+    /**
+     * @brief postponeVariant Called from execute of the variant that can't be
+     * executed yet (e.g. its output is produced by another toolkit). After execute
+     * returns, the variant is put back into the queue and taken again after the delay,
+     * other variants are executed meanwhile. Its owner is not notified until the
+     * variant is executed. Cancelled variant is taken again at once.
+     * @param delaySeconds Time after which the variant is executed again
+     */
+    static void postponeVariant(int delaySeconds);
+
+    /**
+     * @brief tracePhase Records phase of the variant executed by the calling worker
+     * (including onVariantFinished) into the trace of the execution. Does nothing
+     * when the execution is not traced or when called outside of worker.
+     * @param name Name of the phase
+     * @param start Start of the phase, it ends now
+     */
+    static void tracePhase(const std::string & name,
+                           std::chrono::steady_clock::time_point start);
 
     /**
      * @brief executeBinary Called from test code in method execute. Thread is not created
-     * directly from this method, but from test's execute.
+     * directly from this method, but from test's execute. Spawned process is handed
+     * to the process reaper, method returns after the process is reaped.
      * @param logger Logger pointer
      * @param objectInfo Info about caller, will be used in logging
      * @param binaryPath Path to battery executeble binary
      * @param expExitCode Expected exit code of the executable
      * @param arguments Arguments that will be passed to the executable
      * @param input Standard input that will be passed to the created process
+     * @param emptyOutput Output the process output is appended to, it provides
+     * scanner of errors and warnings and spill settings of standard output
+     * @param workingDir (optional) Working directory of the created process,
+     * if empty, the process inherits working directory of the toolkit
      * @return Object that holds standard (error) output
      */
     static BatteryOutput executeBinary(Logger * logger,
@@ -71,14 +189,150 @@ public:
                                        const std::string & binaryPath,
                                        uint expExitCode,
                                        const std::string & arguments,
-                                       const std::string & input);
+                                       const std::string & input,
+                                       const BatteryOutput & emptyOutput,
+                                       const std::string & workingDir = "");
 private:
-    /* Manages creation of maximum number of threads. After creation
-     * wait for the threads to end and joins them. */
-    static void threadManager(std::vector<IVariant *> & variants);
+    /* Variants of single call of executeTests, it lives on the stack of the call */
+    struct Execution {
+        const std::function<void(IVariant *)> * onVariantFinished = nullptr;
+        ScheduleTrace * trace = nullptr;
+        std::chrono::steady_clock::time_point started;
+        /* Variants that were not finished yet, guarded by pendingVariants_mux */
+        size_t unfinishedVariants = 0;
+    };
+
+    /* Running child process, shared by worker that spawned it and the reaper.
+     * Worker must not touch it until finished is set by the reaper. */
+    struct ChildProcess {
+        std::string objectInfo;
+        pid_t pid = 0;
+        /* Set to -1 if pidfd is not supported by the kernel.
+         * Such process is then polled by reaper. */
+        int pidFd = -1;
+        int stdoutFd = -1;
+        int stderrFd = -1;
+        std::chrono::steady_clock::time_point started;
+        int timeout = 0;
+        std::chrono::steady_clock::time_point deadline;
+        std::chrono::steady_clock::time_point reapedAt;
+        /* Time spent by the reaper reading output of the process */
+        std::chrono::steady_clock::duration readTime {};
+        /* Variant that spawned the process and trace of its execution */
+        const IVariant * variant = nullptr;
+        ScheduleTrace * trace = nullptr;
+        bool killed = false;
+        bool cancelled = false;
+        bool reaped = false;
+        int exitCode = 0;
+        BatteryOutput output;
+        std::promise<void> finished;
+    };
+
+    /* Epoll instance of the reaper, watches pidfds and pipes of all running children. */
+    static int epollFd;
+    /* Eventfd used for waking up the reaper when its state changes. */
+    static int wakeupFd;
+    /* Children spawned by workers that were not yet accepted by the reaper. */
+    static std::vector<ChildProcess *> newChildren;
+    static std::mutex newChildren_mux;
+
+    /* Variants that weren't started yet, in order of dispatch */
+    static std::vector<IVariant *> pendingVariants;
+    /* Predicted peak memory of pending and running variants, limited by the budget */
+    static std::map<const IVariant *, std::uint64_t> reservedMemory;
+    static std::uint64_t usedMemory;
+    static int runningVariants;
+    static std::mutex pendingVariants_mux;
+    static std::condition_variable pendingVariants_cv;
+    /* Set while the pool is running and when it has nothing left to execute,
+     * calls made after that wait for its end. Guarded by pendingVariants_mux. */
+    static bool poolRunning;
+    static bool poolClosing;
+    static int poolMaxThreads;
+    /* Workers of the pool, joined by the call that created the pool */
+    static std::vector<std::thread> workers;
+    /* Execution of each queued variant, guarded by pendingVariants_mux */
+    static std::map<const IVariant *, Execution *> variantExecutions;
+    static MemoryLimits memoryLimits;
+    /* Timeout of each variant in seconds, guarded by pendingVariants_mux */
+    static std::map<const IVariant *, int> variantTimeouts;
+    /* Variants cancelled by cancelVariants, guarded by pendingVariants_mux */
+    static std::set<const IVariant *> cancelledVariants;
+    /* Variants whose execution ended, they can't be cancelled anymore,
+     * guarded by pendingVariants_mux */
+    static std::set<const IVariant *> finishedVariants;
+    /* Pending variants postponed by postponeVariant and time when they can
+     * be taken, guarded by pendingVariants_mux */
+    static std::map<const IVariant *, std::chrono::steady_clock::time_point> postponedVariants;
+    /* Set by stopExecution, guarded by pendingVariants_mux */
+    static bool stopRequested;
+    static std::chrono::steady_clock::time_point stopDeadline;
+    /* Variant executed by the calling worker thread and its execution */
+    static thread_local const IVariant * currentVariant;
+    static thread_local Execution * currentExecution;
+    static CpuPinning * cpuPinning;
+    /* Trace lane of the calling worker thread, -1 outside of workers */
+    static thread_local int traceLane;
+
+    /* Adds variants of the execution into the queue, starts more workers
+     * if needed. Caller must hold pendingVariants_mux. */
+    static void queueVariants(const std::vector<IVariant *> & variants, Execution & execution,
+                              const std::function<int(const IVariant *)> & testTimeout,
+                              const MemoryLimits & executionLimits);
+
+    /* Drops state of the variants, their objects can be destroyed then.
+     * Caller must hold pendingVariants_mux. */
+    static void forgetVariants(const std::vector<IVariant *> & variants);
+
+    /* Takes variants from the shared queue and executes them, until the
+     * pool ends. Lane is the slot of the worker in trace. */
+    static void workerThread(int lane);
+
+    /* Removes the first pending variant that fits into memory budget and wasn't postponed
+     * from the queue, waits until some variant fits. Returns nullptr when the queue is empty
+     * and no variant is running, the pool is closed then. Time spent acquiring the queue
+     * lock is stored into lockWait, execution of the variant into execution. */
+    static IVariant * takeNextVariant(std::chrono::steady_clock::duration & lockWait,
+                                      Execution *& execution);
+
+    /* Prepares confinement of the process that is going to be spawned to limitKiB.
+     * Shell commands that apply it are stored into wrapper, empty if the process
+     * is not confined. Returns cgroup of the process or empty string. */
+    static std::string limitChildMemory(Logger * logger, const std::string & objectInfo,
+                                        std::uint64_t limitKiB, std::string & wrapper);
+
+    /* Quotes the argument for /bin/sh */
+    static std::string quoteShellArgument(const std::string & argument);
+
+    /* Event loop of the reaper. Ends when all workers
+     * ended and there are no running processes left. */
+    static void reaperLoop(Logger * logger);
+
+    /* Adds children registered by workers into epoll. */
+    static void acceptChildren(std::map<int, ChildProcess *> & fdOwners,
+                               std::vector<ChildProcess *> & running);
+
+    /* Kills running processes of cancelled variants. After the grace period
+     * of stopExecution, all running variants are cancelled. */
+    static void killCancelled(Logger * logger, std::vector<ChildProcess *> & running);
+
+    /* Reaps the process if it already finished. */
+    static void tryReap(ChildProcess * child);
+
+    /* Reads I/O counters of the process from procfs, the process must not be reaped yet. */
+    static void readIoCounters(pid_t pid, ResourceUsage & usage);
+
+    /* Reads everything that is currently available in the pipe.
+     * Returns false if end of the pipe was reached. */
+    static bool readOutput(ChildProcess * child, int fd);
+
+    /* Drains pipes of reaped process, releases its descriptors
+     * and hands the process back to its worker. */
+    static void finishChild(ChildProcess * child,
+                            std::map<int, ChildProcess *> & fdOwners);
 
-    static void readOutput(BatteryOutput & output,
-                           int * stdout_pipe, int * stderr_pipe);
+    static void closeChildFd(int & fd, std::map<int, ChildProcess *> & fdOwners);
 
     static char ** buildArgv(const std::string & arguments , int * argc);
 
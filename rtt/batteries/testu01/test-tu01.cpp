@@ -5,8 +5,10 @@ namespace batteries {
 namespace testu01 {
 
 std::unique_ptr<Test> Test::getInstance(std::string battObjInf, int testIndex ,
+                                        const BatteryArg & battery,
+                                        const std::string & binaryDataPath,
                                         const GlobalContainer & container) {
-    std::unique_ptr<Test> t (new Test(battObjInf, testIndex , container));
+    std::unique_ptr<Test> t (new Test(battObjInf, testIndex, battery, binaryDataPath, container));
 
     /* Battery specific code goes here */
 
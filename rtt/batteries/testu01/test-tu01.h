@@ -20,13 +20,17 @@ typedef std::vector<std::string> tStringVector;
 class Test : public ITest {
 public:
     static std::unique_ptr<Test> getInstance(std::string battObjInf, int testId ,
+                                             const BatteryArg & battery,
+                                             const std::string & binaryDataPath,
                                              const GlobalContainer & container);
 private:
 
     /* Methods */
     Test(std::string battObjInf, int testIndex,
+         const BatteryArg & battery,
+         const std::string & binaryDataPath,
          const GlobalContainer & container)
-        : ITest(battObjInf, testIndex , container)
+        : ITest(battObjInf, testIndex, battery, binaryDataPath, container)
     {}
 };
 
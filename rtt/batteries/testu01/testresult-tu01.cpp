@@ -1,9 +1,187 @@
 #include "testresult-tu01.h"
 
+#include <algorithm>
+
 namespace rtt {
 namespace batteries {
 namespace testu01 {
 
+/* Log of the variant is scanned in a single pass, without copying of the
+ * subtests. Comments of the scanning functions give regular expressions
+ * that were used for the extraction before, matches are the same. */
+static const std::string SUBTEST_SEPARATOR = "\nGenerator providing data from binary file";
+static const std::string STATISTIC_PREFIX  = "p-value of test" + std::string(23, ' ') + ":";
+static const std::string PVALUES_HEADER    = "\n=== First level p-values/statistics of the test ===\n";
+static const std::string PVALUES_FOOTER    = "\n===================================================\n";
+
+static bool isSpaceChar(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+static bool isBlankChar(char c) {
+    return c == ' ';
+}
+
+static bool isDigitChar(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static const char * findLiteral(const char * begin, const char * end,
+                                const std::string & literal) {
+    return std::search(begin, end, literal.begin(), literal.end());
+}
+
+/* "\nGenerator providing data from binary file.\n", any character but
+ * line end stands for the dot. Returns end of the log if there is none. */
+static const char * findSubTestSeparator(const char * begin, const char * end) {
+    for(const char * it = findLiteral(begin, end, SUBTEST_SEPARATOR) ; it != end ;
+        it = findLiteral(it + 1, end, SUBTEST_SEPARATOR)) {
+        const char * dot = it + SUBTEST_SEPARATOR.size();
+        if(end - dot >= 2 && dot[0] != '\n' && dot[0] != '\r' && dot[1] == '\n')
+            return it;
+    }
+    return end;
+}
+
+/* Returns end of the literal if the text starts with it, nullptr otherwise */
+static const char * skipLiteral(const char * it, const char * end,
+                                const std::string & literal) {
+    if(!it || static_cast<size_t>(end - it) < literal.size() ||
+       !std::equal(literal.begin(), literal.end(), it))
+        return nullptr;
+
+    return it + literal.size();
+}
+
+/* Digits are always taken as a whole, "\d{2,4}" is followed by non-digit */
+static const char * skipDigits(const char * it, const char * end,
+                               size_t minCount, size_t maxCount) {
+    if(!it)
+        return nullptr;
+    const char * digitsEnd = std::find_if_not(it, end, isDigitChar);
+    size_t count = digitsEnd - it;
+    if(count < minCount || count > maxCount)
+        return nullptr;
+
+    return digitsEnd;
+}
+
+/* " *?(\*\*\*\*\*)?\n" after the p-value, stars mark suspect p-value */
+static const char * matchStatisticEnd(const char * it, const char * end) {
+    it = std::find_if_not(it, end, isBlankChar);
+    if(const char * suspect = skipLiteral(it, end, "*****"))
+        it = suspect;
+    if(it == end || *it != '\n')
+        return nullptr;
+
+    return it + 1;
+}
+
+/* Rest of the line after the statistic prefix, " *?(eps|1 - eps1|0\.\d{2,4}|
+ * (1 -  ?)?\d\.\de-\d{1,3})". Alternatives are tried in this order.
+ * Returns start of the next line, nullptr if the line doesn't match. */
+static const char * matchStatistic(const char * it, const char * end,
+                                   std::string & value, std::string & oneMinus) {
+    it = std::find_if_not(it, end, isBlankChar);
+    auto accept = [&](const char * valueEnd, size_t oneMinusLength) -> const char * {
+        const char * lineEnd = valueEnd ? matchStatisticEnd(valueEnd, end) : nullptr;
+        if(lineEnd) {
+            value.assign(it, valueEnd);
+            oneMinus.assign(it, oneMinusLength);
+        }
+        return lineEnd;
+    };
+
+    const char * lineEnd = nullptr;
+    if((lineEnd = accept(skipLiteral(it, end, "eps"), 0)) ||
+       (lineEnd = accept(skipLiteral(it, end, "1 - eps1"), 0)) ||
+       (lineEnd = accept(skipDigits(skipLiteral(it, end, "0."), end, 2, 4), 0)))
+        return lineEnd;
+
+    for(const char * prefix : { "1 -  ", "1 - ", "" }) {
+        const char * mantissa = skipLiteral(it, end, prefix);
+        if(!mantissa || end - mantissa < 5 ||
+           !isDigitChar(mantissa[0]) || mantissa[1] != '.' ||
+           !isDigitChar(mantissa[2]) || mantissa[3] != 'e' || mantissa[4] != '-')
+            continue;
+        if((lineEnd = accept(skipDigits(mantissa + 5, end, 1, 3), mantissa - it)))
+            return lineEnd;
+    }
+    return nullptr;
+}
+
+/* "name +?= +?([^\s,]+?)", or "w = +?([1-9]+?)" for Block Alphabit.
+ * Returns end of the value, nullptr if the parameter doesn't match. */
+static const char * matchParameter(const char * it, const char * end,
+                                   const std::string & name, bool positiveDigits,
+                                   std::vector<std::string> & values) {
+    it = skipLiteral(it, end, name);
+    if(!it)
+        return nullptr;
+    if(positiveDigits) {
+        it = skipLiteral(it, end, " =");
+    } else {
+        const char * equals = std::find_if_not(it, end, isBlankChar);
+        it = equals != it ? skipLiteral(equals, end, "=") : nullptr;
+    }
+    if(!it)
+        return nullptr;
+    const char * valueBegin = std::find_if_not(it, end, isBlankChar);
+    if(valueBegin == it)
+        return nullptr;
+
+    const char * valueEnd = positiveDigits ?
+                std::find_if_not(valueBegin, end, [](char c) {
+                    return c >= '1' && c <= '9';
+                }) :
+                std::find_if_not(valueBegin, end, [](char c) {
+                    return c != ',' && !isSpaceChar(c);
+                });
+    if(valueEnd == valueBegin)
+        return nullptr;
+
+    values.emplace_back(valueBegin, valueEnd);
+    return valueEnd;
+}
+
+/* Counts non-overlapping matches of "\s+?N +?= +?([^\s,]+?),\s+?n +?= ... \s",
+ * as regex iterator would. Values of the first match are stored. */
+static size_t countParameters(const char * begin, const char * end,
+                              const std::vector<std::string> & paramNames,
+                              std::vector<std::string> & values,
+                              bool positiveDigits = false) {
+    size_t count = 0;
+    std::vector<std::string> matchedValues;
+    const char * matchEnd = begin;
+    for(const char * it = begin + 1 ; it < end ; ++it) {
+        /* Whitespace before the name must follow the previous match */
+        if(it - 1 < matchEnd || !isSpaceChar(it[-1]) || *it != paramNames.at(0).at(0))
+            continue;
+
+        const char * paramEnd = it;
+        matchedValues.clear();
+        for(size_t i = 0 ; paramEnd && i < paramNames.size() ; ++i) {
+            if(i > 0) {
+                paramEnd = skipLiteral(paramEnd, end, ",");
+                if(!paramEnd || paramEnd == end || !isSpaceChar(*paramEnd))
+                    break;
+                paramEnd = std::find_if_not(paramEnd, end, isSpaceChar);
+            }
+            paramEnd = matchParameter(paramEnd, end, paramNames.at(i),
+                                      positiveDigits, matchedValues);
+        }
+        if(!paramEnd || matchedValues.size() != paramNames.size() ||
+           paramEnd == end || !isSpaceChar(*paramEnd))
+            continue;
+
+        if(count++ == 0)
+            values = matchedValues;
+        matchEnd = paramEnd + 1;
+        it = paramEnd;
+    }
+    return count;
+}
+
 std::unique_ptr<TestResult> TestResult::getInstance(
         const std::vector<ITest *> & tests) {
     if(tests.empty())
@@ -13,101 +191,108 @@ std::unique_ptr<TestResult> TestResult::getInstance(
                                        tests.at(0)->getLogger(),
                                        tests.at(0)->getLogicName()));
 
-    const static std::regex RE_SUBTEST {
-        "\nGenerator providing data from binary file.\n"
-        "([^]*?)"  /* This will capture output of one subtest */
-        "(?=\nGenerator providing data from binary file.\n|$)"
-    };
-    auto endIt = std::sregex_iterator();
-    std::vector<result::SubTestResult> tmpSubTestResults;
-    std::vector<result::Statistic> tmpStatistics;
-    std::vector<std::pair<std::string, std::string>> tmpParamVec;
-    std::vector<double> tmpPValuesVec;
-
     r->battery = tests.at(0)->getBatteryArg();
 
     /* Single test processing */
     for(const ITest * test : tests) {
-        /* Single variant processing */
+        /* Variants are usually parsed already, right after their execution.
+         * Cancelled variants have no output, results are partial. */
         for(IVariant * variant : test->getVariants()) {
-            testu01::Variant * tu01Var =
-                    dynamic_cast<Variant *>(variant);
-            r->objectInfo = tu01Var->getObjectInfo();
-
-            /* Split log into subtests */
-            std::string variantLog = tu01Var->getBatteryOutput().getStdOut();
-
-            auto subTestIt = std::sregex_iterator(
-                                 variantLog.begin(),
-                                 variantLog.end(),
-                                 RE_SUBTEST);
-
-            /* Single subtest processing */
-            for(; subTestIt != endIt ; ++subTestIt) {
-                std::smatch match = *subTestIt;
-                std::string subTestLog = match[1].str();
-
-                tmpStatistics = r->extractStatistics(
-                                   subTestLog,
-                                   tu01Var->getStatisticNames());
-
-                /* Test settings extraction */
-                tmpParamVec = r->extractTestParameters(
-                                  subTestLog,
-                                  tu01Var->getExtractableParamNames());
-
-                /* P-values extraction */
-                tmpPValuesVec = r->extractPValues(subTestLog);
-
-                /* Creation of a result of the subtest */
-                auto tmpSubTestRes = result::SubTestResult::getInstance(
-                                         std::move(tmpStatistics),
-                                         std::move(tmpPValuesVec));
-
-                /* Additional subtest specifics */
-                tmpSubTestRes.setTestParameters(
-                            std::move(tmpParamVec));
-
-                /* Add subtest result to collection of results */
-                tmpSubTestResults.push_back(std::move(tmpSubTestRes));
-            }
-            r->varRes.push_back(result::VariantResult::getInstance(
-                                    tmpSubTestResults,
-                                    tu01Var->getUserSettings(),
-                                    tu01Var->getBatteryOutput()));
-            tmpSubTestResults.clear();
+            if(variant->isCancelled())
+                continue;
+            r->objectInfo = variant->getObjectInfo();
+            r->varRes.push_back(ITestResult::getVariantResult(variant));
         }
     }
     return r;
 }
 
+result::VariantResult TestResult::parseVariant(const IVariant * variant) {
+    const Variant * tu01Var =
+            dynamic_cast<const Variant *>(variant);
+    if(!tu01Var)
+        raiseBugException("variant is not TestU01 variant");
+
+    TestResult r (tu01Var->getLogger(), "");
+    r.objectInfo = tu01Var->getObjectInfo();
+    r.battery = tu01Var->getBattery();
+
+    std::vector<result::SubTestResult> tmpSubTestResults;
+    std::vector<result::Statistic> tmpStatistics;
+    std::vector<std::pair<std::string, std::string>> tmpParamVec;
+    std::vector<double> tmpPValuesVec;
+
+    /* Split log into subtests, subtest spans from the separator to the next one
+     * or to the end of the log, as "\nGenerator...\n([^]*?)(?=\nGenerator...\n|$)" */
+    const BatteryOutput & variantLog = tu01Var->getBatteryOutput();
+    const char * logBegin = variantLog.getStdOutData();
+    const char * logEnd = logBegin + variantLog.getStdOutLength();
+    const char * subTestBegin = findSubTestSeparator(logBegin, logEnd);
+
+    /* Single subtest processing */
+    while(subTestBegin != logEnd) {
+        subTestBegin += SUBTEST_SEPARATOR.size() + 2;
+        const char * subTestEnd = findSubTestSeparator(subTestBegin, logEnd);
+
+        tmpStatistics = r.extractStatistics(
+                           subTestBegin, subTestEnd,
+                           tu01Var->getStatisticNames());
+
+        /* Test settings extraction */
+        tmpParamVec = r.extractTestParameters(
+                          subTestBegin, subTestEnd,
+                          tu01Var->getExtractableParamNames());
+
+        /* P-values extraction */
+        tmpPValuesVec = r.extractPValues(subTestBegin, subTestEnd);
+
+        /* Creation of a result of the subtest */
+        auto tmpSubTestRes = result::SubTestResult::getInstance(
+                                 std::move(tmpStatistics),
+                                 std::move(tmpPValuesVec));
+
+        /* Additional subtest specifics */
+        tmpSubTestRes.setTestParameters(
+                    std::move(tmpParamVec));
+
+        /* Add subtest result to collection of results */
+        tmpSubTestResults.push_back(std::move(tmpSubTestRes));
+        subTestBegin = subTestEnd;
+    }
+    return result::VariantResult::getInstance(tmpSubTestResults,
+                                              tu01Var->getUserSettings(),
+                                              tu01Var->getBatteryOutput());
+}
+
 std::vector<result::Statistic> TestResult::extractStatistics(
-        const std::string & testLog, std::vector<std::string> statNames) {
+        const char * begin, const char * end, std::vector<std::string> statNames) {
     std::vector<result::Statistic> rval;
-    const static std::regex RE_PVALUES {
-        "p-value of test {23}: *?("
-        "eps|"                            /* Just "eps" */
-        "1 - eps1|"                       /* Just "1 - eps1" */
-        "0\\.\\d{2,4}|"                   /* Decimal rounded from 2 to 4 digits */
-        "(1 -  ?)?\\d\\.\\de-\\d{1,3}"    /* Decimal in scientific notation that can be preceeded by "1 - " */
-        ") *?(\\*\\*\\*\\*\\*)?\\n"       /* Capture ending "*****" - pvalue is suspect */
-    };
-    auto pValIt = std::sregex_iterator(
-                      testLog.begin(),
-                      testLog.end(),
-                      RE_PVALUES);
-    auto endIt = std::sregex_iterator();
-    if(static_cast<size_t>(std::distance(pValIt, endIt)) != statNames.size()) {
+    /* Printed p-values with their "1 - " prefixes */
+    std::vector<std::pair<std::string, std::string>> matches;
+    std::string value;
+    std::string oneMinus;
+
+    for(const char * it = findLiteral(begin, end, STATISTIC_PREFIX) ; it != end ;
+        it = findLiteral(it, end, STATISTIC_PREFIX)) {
+        const char * lineEnd = matchStatistic(it + STATISTIC_PREFIX.size(), end,
+                                              value, oneMinus);
+        if(lineEnd) {
+            matches.emplace_back(value, oneMinus);
+            it = lineEnd;
+        } else {
+            ++it;
+        }
+    }
+    if(matches.size() != statNames.size()) {
         statNames.clear();
-        for(uint i = 0 ; i < std::distance(pValIt , endIt) ; ++i)
+        for(uint i = 0 ; i < matches.size() ; ++i)
             statNames.push_back("Unknown " + Utils::itostr(i));
         logger->warn(objectInfo +
                      Strings::TEST_ERR_UNKNOWN_STATISTICS);
     }
-    for(uint i = 0 ; pValIt != endIt ; ++i , ++pValIt) {
-        std::smatch match = *pValIt;
-        double pVal = convertStringToDouble(match[1].str(),
-                                            match[2].str());
+    for(uint i = 0 ; i < matches.size() ; ++i) {
+        double pVal = convertStringToDouble(matches.at(i).first,
+                                            matches.at(i).second);
         rval.push_back(result::Statistic::getInstance(statNames.at(i), pVal));
     }
     return rval;
@@ -138,78 +323,44 @@ double TestResult::convertStringToDouble(const std::string & num,
 }
 
 std::vector<std::pair<std::string, std::string>> TestResult::extractTestParameters(
-        const std::string & testLog,
-        std::vector<std::string> paramNames) {
+        const char * begin, const char * end,
+        const std::vector<std::string> & paramNames) {
     std::vector<std::pair<std::string, std::string>> rval;
-    std::regex RE_PARAM = buildParamRegex(paramNames);
-    auto paramIt = std::sregex_iterator(testLog.begin(),
-                                        testLog.end(),
-                                        RE_PARAM);
-    auto endIt = std::sregex_iterator();
-    if(std::distance(paramIt , endIt) != 1)
+    std::vector<std::string> values;
+    if(countParameters(begin, end, paramNames, values) != 1)
         throw RTTException(objectInfo,
                            "parameter extraction failed");
-    std::smatch paramMatch = *paramIt;
     for(uint i = 0 ; i < paramNames.size() ; ++i) {
-        rval.push_back({paramNames.at(i), paramMatch[i + 1].str()});
+        rval.push_back({paramNames.at(i), values.at(i)});
     }
     /* Extracting w in Block Alphabit */
     if(battery.getBatteryId() == Constants::BatteryID::TU01_BLOCK_ALPHABIT) {
-        static const std::regex RE_W_PARAM {
-            "\\sw = +?([1-9]+?)\\s"
-        };
-        auto wParamIt = std::sregex_iterator(
-                            testLog.begin(),
-                            testLog.end(),
-                            RE_W_PARAM);
-        if(std::distance(wParamIt, endIt) != 1) {
+        if(countParameters(begin, end, { "w" }, values, true) != 1) {
             throw RTTException(objectInfo,
                                "extraction of parameter \"w\" failed");
         }
-        std::smatch wMatch = *wParamIt;
-        //rval.push_back("w = " + wMatch[1].str());
-        rval.push_back({"w", wMatch[1].str()});
+        rval.push_back({"w", values.at(0)});
     }
 
     return rval;
 }
 
-std::vector<double> TestResult::extractPValues(const std::string & testLog) {
-    const static std::regex RE_PVALUES {
-        "\n=== First level p-values/statistics of the test ===\n"
-        "([^]*?)" /* This will capture printed p-values in the log */
-        "\n===================================================\n"
-    };
-    std::smatch m;
-    std::regex_search(testLog, m, RE_PVALUES);
-    if(m.empty())
+std::vector<double> TestResult::extractPValues(const char * begin, const char * end) {
+    /* "\n=== First level...===\n([^]*?)\n===...===\n", first block is taken */
+    const char * block = findLiteral(begin, end, PVALUES_HEADER);
+    if(block == end)
+        return {};
+    block += PVALUES_HEADER.size();
+    const char * blockEnd = findLiteral(block, end, PVALUES_FOOTER);
+    if(blockEnd == end)
         return {};
 
-    auto pValsSplit = Utils::split(m[1], '\n');
+    /* Single p-value on each line */
     std::vector<double> rval;
-    rval.reserve(pValsSplit.size());
-
-    for(auto pVal : pValsSplit)
-        rval.push_back(Utils::strtod(pVal));
-
+    Utils::strtodLines(block, blockEnd, rval);
     return rval;
 }
 
-std::regex TestResult::buildParamRegex(
-        std::vector<std::string> paramNames) {
-    std::stringstream rval;
-    for(uint i = 0 ; i < paramNames.size() ; ++i) {
-        rval << "\\s+?" << paramNames.at(i) << " +?= +?([^\\s,]+?)";
-        if(i + 1 != paramNames.size()) {
-            rval << ",";
-        } else {
-            rval << "\\s";
-        }
-    }
-    return std::regex(rval.str());
-}
-
-
 } // namespace testu01
 } // namespace batteries
 } // namespace rtt
@@ -14,6 +14,13 @@ public:
     static std::unique_ptr<TestResult> getInstance(
             const std::vector<ITest *> & tests);
 
+    /**
+     * @brief parseVariant Extracts results from output of single executed variant
+     * @param variant Executed variant
+     * @return Result of the variant
+     */
+    static result::VariantResult parseVariant(const IVariant * variant);
+
 private:
     BatteryArg battery;
 
@@ -21,21 +28,19 @@ private:
         : ITestResult(logger , testName)
     {}
 
-    static std::regex buildParamRegex(
-            std::vector<std::string> paramNames);
-
     static double convertStringToDouble(const std::string & num,
                                         const std::string & oneMinus);
 
+    /* Functions below get single subtest of the log, subtest is not copied */
     std::vector<result::Statistic> extractStatistics(
-            const std::string & testLog,
+            const char * begin, const char * end,
             std::vector<std::string> statNames);
 
     std::vector<std::pair<std::string, std::string> > extractTestParameters(
-            const std::string & testLog,
-            std::vector<std::string> paramNames);
+            const char * begin, const char * end,
+            const std::vector<std::string> & paramNames);
 
-    std::vector<double> extractPValues(const std::string & testLog);
+    std::vector<double> extractPValues(const char * begin, const char * end);
 };
 
 } // namespace testu01
@@ -5,8 +5,10 @@ namespace batteries {
 namespace testu01 {
 
 std::unique_ptr<Variant> Variant::getInstance(int testId, std::string testObjInf,
-                                              uint variantIdx, const GlobalContainer & cont) {
-    std::unique_ptr<Variant> v (new Variant(testId, testObjInf, variantIdx, cont));
+                                              uint variantIdx, const BatteryArg & battery,
+                                              const std::string & binaryDataPath,
+                                              const GlobalContainer & cont) {
+    std::unique_ptr<Variant> v (new Variant(testId, testObjInf, variantIdx, battery, binaryDataPath, cont));
     auto battConf = cont.getBatteryConfiguration();
 
     v->settableParamNames =
@@ -84,6 +86,48 @@ std::vector<std::string> Variant::getExtractableParamNames() const {
     return extractableParamNames;
 }
 
+double Variant::getCostEstimate() const {
+    /* Tests in bigger batteries are run with more samples,
+     * bit batteries process bit_nb bits in each repetition. */
+    double repetitionCost = 1;
+    switch(battery.getBatteryId()) {
+        case Constants::BatteryID::TU01_CRUSH:
+            repetitionCost = 10;
+            break;
+        case Constants::BatteryID::TU01_BIGCRUSH:
+            repetitionCost = 50;
+            break;
+        case Constants::BatteryID::TU01_RABBIT:
+        case Constants::BatteryID::TU01_ALPHABIT:
+        case Constants::BatteryID::TU01_BLOCK_ALPHABIT:
+            try {
+                repetitionCost = Utils::lexical_cast<double>(bit_nb) / 1e6;
+            } catch(std::runtime_error &) {}
+            break;
+        default:
+            break;
+    }
+    return repetitions * repetitionCost;
+}
+
+std::uint64_t Variant::getInputDemand() const {
+    /* Only bit batteries have the amount of data in their settings, each repetition
+     * processes bit_nb bits. (Block) Alphabit takes s bits of each 32 bit number. */
+    if(!battery.isInTU01BitFamily())
+        return 0;
+    try {
+        std::uint64_t bits = Utils::lexical_cast<std::uint64_t>(bit_nb);
+        std::uint64_t bitsPerNumber = 32;
+        if(battery.isInTU01AlphabitFamily())
+            bitsPerNumber = Utils::lexical_cast<std::uint64_t>(bit_s);
+        if(bitsPerNumber == 0 || bitsPerNumber > 32)
+            return 0;
+        return repetitions * (bits / bitsPerNumber * 4);
+    } catch(std::runtime_error &) {
+        return 0;
+    }
+}
+
 void Variant::buildStrings() {
     /* Building CLI arguments */
     std::stringstream arguments;
@@ -109,7 +153,7 @@ void Variant::buildStrings() {
     /* Test number option */
     arguments << "-t " << testId << " ";
     /* Input file option */
-    arguments << "-i " << binaryDataPath << " ";
+    arguments << "-i " << processDataPath << " ";
     /* Repetitions option */
     if(repetitions != 1)
         arguments << "-r " << repetitions << " ";
@@ -13,13 +13,19 @@ typedef std::pair<std::string , std::string> tParam;
 class Variant : public IVariant {
 public:
     static std::unique_ptr<Variant> getInstance(int testId, std::string testObjInf,
-                                                uint variantIdx, const GlobalContainer & cont);
+                                                uint variantIdx, const BatteryArg & battery,
+                                                const std::string & binaryDataPath,
+                                                const GlobalContainer & cont);
 
 
     std::vector<std::string> getStatisticNames() const;
 
     std::vector<std::string> getExtractableParamNames() const;
 
+    double getCostEstimate() const;
+
+    std::uint64_t getInputDemand() const;
+
 private:
     /* TestU01 specific */
     std::vector<std::string> settableParamNames;
@@ -36,8 +42,10 @@ private:
 
     /* Methods */
     Variant(int testId, std::string testObjInf,
-            uint variantIdx, const GlobalContainer & cont)
-        : IVariant(testId, testObjInf, variantIdx, cont)
+            uint variantIdx, const BatteryArg & battery,
+            const std::string & binaryDataPath,
+            const GlobalContainer & cont)
+        : IVariant(testId, testObjInf, variantIdx, battery, binaryDataPath, cont)
     {}
 
     void buildStrings();
@@ -0,0 +1,224 @@
+#include "batteryjob.h"
+
+#include <map>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+
+namespace rtt {
+
+/* Selects messages that belong to the given job. Messages are prefixed
+ * by object info of their origin, messages without prefix of any job
+ * (e.g. configuration errors) belong to all jobs. */
+static std::vector<std::string> filterJobMessages(const std::vector<std::string> & messages,
+                                                  const std::set<std::string> & jobObjectInfos,
+                                                  const std::string & objectInfo) {
+    std::vector<std::string> rval;
+    for(const std::string & msg : messages) {
+        std::string prefix = msg.substr(0, std::min(msg.find(':'), msg.find(" - ")));
+        if(prefix == objectInfo || jobObjectInfos.count(prefix) == 0)
+            rval.push_back(msg);
+    }
+    return rval;
+}
+
+std::vector<BatteryJob> BatteryJob::createJobs(const GlobalContainer & container,
+                                               storage::IStorage * storage) {
+    auto rttCliOptions = container.getRttCliOptions();
+
+    /* Each chosen battery is executed on each input file */
+    std::vector<BatteryJob> jobs;
+    for(const auto & dataPath : rttCliOptions->getInputDataPaths()) {
+        for(const auto & batteryArg : rttCliOptions->getBatteryArgs()) {
+            BatteryJob job;
+            job.batteryArg = batteryArg;
+            job.dataPath = dataPath;
+            job.objectInfo = batteries::IBattery::getObjectInfo(
+                                 batteryArg, dataPath, rttCliOptions->isBatchMode(),
+                                 container.getJobId());
+            job.container = &container;
+            job.storage = storage;
+            /* Jobs of the server run alongside other jobs, they can't
+             * take messages from the logger that is shared by all. */
+            if(container.getJobId() > 0) {
+                container.getLogger()->openScope(job.objectInfo);
+                job.scopedMessages = true;
+            }
+            jobs.push_back(std::move(job));
+        }
+    }
+    return jobs;
+}
+
+void BatteryJob::executeJobs(std::vector<BatteryJob> & jobs, Logger * logger,
+                             const std::function<void(BatteryJob &)> & onJobStored) {
+    auto jobObjectInfos = getObjectInfos(jobs);
+
+    /* Initialization of batteries, battery that fails
+     * is reported and the rest is executed */
+    std::vector<batteries::IBattery *> batteries;
+    std::map<batteries::IBattery *, BatteryJob *> batteryJobs;
+    /* Input file is released when all its batteries are finished */
+    std::map<std::string, int> unfinishedFileJobs;
+    for(BatteryJob & job : jobs) {
+        /* Other execution of the server can use the same file meanwhile */
+        if(unfinishedFileJobs.count(job.dataPath) == 0) {
+            job.container->getSharedInput()->hold(job.dataPath);
+            unfinishedFileJobs[job.dataPath] = 0;
+        }
+        try {
+            job.battery = batteries::IBattery::getInstance(*job.container, job.batteryArg,
+                                                           job.dataPath);
+            batteries.push_back(job.battery.get());
+            batteryJobs[job.battery.get()] = &job;
+            ++unfinishedFileJobs[job.dataPath];
+        } catch(std::exception & ex) {
+            logger->error(ex.what());
+        }
+    }
+    /* File without any created battery is released at once */
+    for(auto it = unfinishedFileJobs.begin() ; it != unfinishedFileJobs.end() ;) {
+        if(it->second == 0) {
+            jobs.front().container->getSharedInput()->release(it->first);
+            it = unfinishedFileJobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::deque<BatteryJob *> finishedJobs;
+    bool executionEnded = false;
+    std::mutex finishedJobs_mux;
+    std::condition_variable finishedJobs_cv;
+    auto storeFinishedJobs = [&]() {
+        for(;;) {
+            BatteryJob * job = nullptr;
+            {
+                std::unique_lock<std::mutex> l (finishedJobs_mux);
+                finishedJobs_cv.wait(l, [&]() {
+                    return !finishedJobs.empty() || executionEnded;
+                });
+                if(finishedJobs.empty())
+                    return;
+                job = finishedJobs.front();
+                finishedJobs.pop_front();
+            }
+            try {
+                storeJob(*job, logger, jobObjectInfos);
+            } catch(std::exception & ex) {
+                logger->error(ex.what());
+            }
+            if(--unfinishedFileJobs.at(job->dataPath) == 0) {
+                job->container->getSharedInput()->release(job->dataPath);
+                job->container->getResultCache()->release(job->dataPath);
+            }
+            if(onJobStored)
+                onJobStored(*job);
+        }
+    };
+    auto onBatteryFinished = [&](batteries::IBattery * battery) {
+        {
+            std::lock_guard<std::mutex> l (finishedJobs_mux);
+            finishedJobs.push_back(batteryJobs.at(battery));
+        }
+        finishedJobs_cv.notify_one();
+    };
+    std::thread storer (storeFinishedJobs);
+    try {
+        if(!batteries.empty())
+            batteries::IBattery::runTests(batteries, onBatteryFinished);
+    } catch(std::exception & ex) {
+        logger->error(ex.what());
+    }
+    {
+        std::lock_guard<std::mutex> l (finishedJobs_mux);
+        executionEnded = true;
+    }
+    finishedJobs_cv.notify_one();
+    storer.join();
+}
+
+std::string BatteryJob::planJobs(std::vector<BatteryJob> & jobs, Logger * logger) {
+    std::vector<batteries::IBattery *> batteries;
+    for(BatteryJob & job : jobs) {
+        try {
+            job.battery = batteries::IBattery::getInstance(*job.container, job.batteryArg,
+                                                           job.dataPath);
+            batteries.push_back(job.battery.get());
+        } catch(std::exception & ex) {
+            logger->error(ex.what());
+        }
+    }
+    if(batteries.empty())
+        throw RTTException("Execution plan", "no battery was created");
+
+    return batteries::IBattery::planTests(batteries);
+}
+
+void BatteryJob::storeJobs(std::vector<BatteryJob> & jobs, Logger * logger,
+                           const std::function<void(BatteryJob &)> & onJobStored) {
+    auto jobObjectInfos = getObjectInfos(jobs);
+    for(BatteryJob & job : jobs) {
+        if(job.stored)
+            continue;
+        try {
+            storeJob(job, logger, jobObjectInfos);
+        } catch(std::exception & ex) {
+            logger->error(ex.what());
+        }
+        if(onJobStored)
+            onJobStored(job);
+    }
+}
+
+std::set<std::string> BatteryJob::getObjectInfos(const std::vector<BatteryJob> & jobs) {
+    std::set<std::string> rval;
+    for(const BatteryJob & job : jobs)
+        rval.insert(job.objectInfo);
+    return rval;
+}
+
+void BatteryJob::storeJob(BatteryJob & job, Logger * logger,
+                          const std::set<std::string> & jobObjectInfos) {
+    std::vector<std::string> warnings;
+    std::vector<std::string> errors;
+    /* Job is never stored twice, even if storing fails */
+    job.stored = true;
+    /* Results of sharded run are stored only by the coordinator */
+    if(!job.storage) {
+        if(job.scopedMessages)
+            logger->closeScope(job.objectInfo, warnings, errors);
+        return;
+    }
+    job.storage->init(job.batteryArg, job.dataPath);
+    try {
+        /* Obtaining and storing results, batteries that failed
+         * during initialization or execution have no results */
+        if(job.battery) {
+            const auto & results = job.battery->getTestResults();
+            job.storage->writeResults(Utils::getRawPtrs(results));
+            if(job.battery->isStoppedEarly())
+                job.storage->setPartialResults();
+        }
+    } catch(std::exception & ex) {
+        logger->error(ex.what());
+    }
+
+    /* Store warnings and errors into storage */
+    if(job.scopedMessages) {
+        logger->closeScope(job.objectInfo, warnings, errors);
+    } else {
+        warnings = filterJobMessages(logger->getWarningMessages(),
+                                     jobObjectInfos, job.objectInfo);
+        errors = filterJobMessages(logger->getErrorMessages(),
+                                   jobObjectInfos, job.objectInfo);
+    }
+    job.storage->addBatteryWarnings(warnings);
+    job.storage->addBatteryErrors(errors);
+    /* Call to close storage is important -
+     * changes are commited, files saved, etc... */
+    job.storage->close();
+}
+
+} // namespace rtt
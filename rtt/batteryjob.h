@@ -0,0 +1,86 @@
+#ifndef RTT_BATTERYJOB_H
+#define RTT_BATTERYJOB_H
+
+#include <set>
+#include <vector>
+#include <functional>
+
+#include "rtt/globalcontainer.h"
+#include "rtt/storage/istorage.h"
+#include "rtt/batteries/ibattery-batt.h"
+
+namespace rtt {
+
+/**
+ * @brief The BatteryJob struct Battery executed on single input file. Its results
+ * are stored as soon as all its tests are finished. Jobs of single run share
+ * the container and the storage, jobs submitted to the server have their own.
+ * Warnings and errors of server jobs are collected in their own scope of the
+ * logger, jobs of single run select theirs from all messages of the logger.
+ */
+struct BatteryJob {
+    clinterface::BatteryArg batteryArg;
+    std::string dataPath;
+    std::string objectInfo;
+    const GlobalContainer * container = nullptr;
+    /* Null if the results are not stored (worker of sharded run) */
+    storage::IStorage * storage = nullptr;
+    std::unique_ptr<batteries::IBattery> battery;
+    bool stored = false;
+    /* Set if the messages are collected in scope of the job */
+    bool scopedMessages = false;
+
+    /**
+     * @brief createJobs Creates job for each chosen battery and each input file.
+     * Scopes of messages are opened for jobs of the server, they are closed
+     * when the jobs are stored.
+     * @param container Container with options of the run
+     * @param storage Storage of the results
+     * @return Jobs, batteries are created later by executeJobs
+     */
+    static std::vector<BatteryJob> createJobs(const GlobalContainer & container,
+                                              storage::IStorage * storage);
+
+    /**
+     * @brief executeJobs Creates batteries of the jobs and executes tests of all
+     * batteries in single pool. Results of each battery are stored as soon as it
+     * is finished. Storing runs in its own thread, so that workers can continue
+     * with other tests. Jobs whose battery failed are left to storeJobs.
+     * @param jobs Jobs, must not be resized while executing
+     * @param logger Logger shared by all jobs
+     * @param onJobStored Called after each job was stored
+     */
+    static void executeJobs(std::vector<BatteryJob> & jobs, Logger * logger,
+                            const std::function<void(BatteryJob &)> & onJobStored = nullptr);
+
+    /**
+     * @brief planJobs Creates batteries of the jobs and plans execution of their
+     * tests, nothing is executed. Jobs whose battery failed are left out.
+     * @param jobs Jobs
+     * @param logger Logger shared by all jobs
+     * @return Plan of the execution
+     */
+    static std::string planJobs(std::vector<BatteryJob> & jobs, Logger * logger);
+
+    /**
+     * @brief storeJobs Stores jobs that weren't stored yet, e.g. when the run
+     * failed before execution, only warnings and errors are stored then.
+     * @param jobs Jobs
+     * @param logger Logger shared by all jobs
+     * @param onJobStored Called after each job was stored
+     */
+    static void storeJobs(std::vector<BatteryJob> & jobs, Logger * logger,
+                          const std::function<void(BatteryJob &)> & onJobStored = nullptr);
+
+private:
+    /* Object infos of all jobs, used to assign logged messages to jobs */
+    static std::set<std::string> getObjectInfos(const std::vector<BatteryJob> & jobs);
+
+    /* Writes results, warnings and errors of the job into its storage */
+    static void storeJob(BatteryJob & job, Logger * logger,
+                         const std::set<std::string> & jobObjectInfos);
+};
+
+} // namespace rtt
+
+#endif // RTT_BATTERYJOB_H
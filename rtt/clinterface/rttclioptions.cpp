@@ -5,10 +5,18 @@ namespace clinterface {
 
 const std::string RTTCliOptions::BATTERY_ARG_NAME        = "-b";
 const std::string RTTCliOptions::DATA_FILE_ARG_NAME      = "-f";
+const std::string RTTCliOptions::BATCH_ARG_NAME          = "--batch";
+const std::string RTTCliOptions::GENERATOR_ARG_NAME      = "--generator";
 const std::string RTTCliOptions::CONF_FILE_ARG_NAME      = "-c";
 const std::string RTTCliOptions::TEST_ID_ARG_NAME        = "-t";
 const std::string RTTCliOptions::RESULT_STORAGE_ARG_NAME = "-r";
 const std::string RTTCliOptions::MYSQL_DB_EID_ARG_NAME   = "--eid";
+const std::string RTTCliOptions::FAIL_FAST_ARG_NAME      = "--fail-fast";
+const std::string RTTCliOptions::SERVE_ARG_NAME          = "--serve";
+const std::string RTTCliOptions::SHARD_COORDINATOR_ARG_NAME = "--shard-coordinator";
+const std::string RTTCliOptions::SHARD_WORKER_ARG_NAME   = "--shard-worker";
+const std::string RTTCliOptions::PLAN_ARG_NAME           = "--plan";
+const std::string RTTCliOptions::GENERATOR_INPUT_NAME    = "generator-output";
 
 RTTCliOptions RTTCliOptions::getInstance(int argc, char * argv[]) {
     RTTCliOptions options;
@@ -21,6 +29,14 @@ RTTCliOptions RTTCliOptions::getInstance(int argc, char * argv[]) {
         options.setArgumentValue(argv[i], argv[i + 1]);
     }
 
+    /* Server gets the remaining options with each submitted job */
+    if(options.isArgumentSet(SERVE_ARG_NAME)) {
+        if(argc != 3)
+            throw RTTException(options.objectInfo, "option \"--serve\" can't be "
+                                                   "combined with other options");
+        return options;
+    }
+
     /* Check whether are all mandatory options set */
     {
         auto argIsInvalid = [](const auto & arg) {
@@ -37,9 +53,34 @@ RTTCliOptions RTTCliOptions::getInstance(int argc, char * argv[]) {
     }
 
     /* Additional sanity checks for certain options */
-    auto inDataPath = options.getArgumentValue<std::string>(DATA_FILE_ARG_NAME);
-    if(!Utils::fileExist(inDataPath))
-        throw RTTException(options.objectInfo, Strings::ERR_FILE_OPEN_FAIL + inDataPath);
+    std::vector<BatteryArg> batteries = options.getBatteryArgs();
+    for(size_t i = 0; i < batteries.size(); ++i) {
+        for(size_t j = 0; j < i; ++j) {
+            if(batteries.at(i).getBatteryId() == batteries.at(j).getBatteryId())
+                throw RTTException(options.objectInfo, "battery " +
+                                   batteries.at(i).getShortName() + " is set multiple times");
+        }
+    }
+    /* Test id is specific to single battery */
+    if(batteries.size() > 1 && options.isArgumentSet(TEST_ID_ARG_NAME))
+        throw RTTException(options.objectInfo, "option \"-t\" can't be used with multiple batteries");
+
+    /* Exactly one of -f, --batch and --generator must be set */
+    if(options.isArgumentSet(DATA_FILE_ARG_NAME) + options.isArgumentSet(BATCH_ARG_NAME) +
+       options.isArgumentSet(GENERATOR_ARG_NAME) != 1)
+        throw RTTException(options.objectInfo, "exactly one of options \"-f\", \"--batch\" "
+                                               "and \"--generator\" must be set");
+
+    /* Generator output is created only when the analysis starts */
+    if(!options.isGeneratorMode()) {
+        auto inDataPaths = options.getInputDataPaths();
+        if(inDataPaths.empty())
+            throw RTTException(options.objectInfo, "no input files in " + options.getInputDataPath());
+        for(const auto & inDataPath : inDataPaths) {
+            if(!Utils::fileExist(inDataPath))
+                throw RTTException(options.objectInfo, Strings::ERR_FILE_OPEN_FAIL + inDataPath);
+        }
+    }
 
     auto inConfPath = options.getArgumentValue<std::string>(CONF_FILE_ARG_NAME);
     if(!Utils::fileExist(inConfPath))
@@ -55,6 +96,25 @@ RTTCliOptions RTTCliOptions::getInstance(int argc, char * argv[]) {
             !options.isArgumentSet(MYSQL_DB_EID_ARG_NAME))
         throw RTTException(options.objectInfo, "option \"--eid\" must be set when db_mysql storage is used");
 
+    /* Database doesn't store path of the input data, results
+     * of all files would be stored under single experiment */
+    if(options.getResultStorageId() == Constants::ResultStorageID::DB_MYSQL &&
+            options.isArgumentSet(BATCH_ARG_NAME))
+        throw RTTException(options.objectInfo, "option \"--batch\" can't be used with db_mysql storage");
+
+    if(options.isArgumentSet(FAIL_FAST_ARG_NAME) &&
+            options.getArgumentValue<int>(FAIL_FAST_ARG_NAME) <= 0)
+        throw RTTException(options.objectInfo, "option \"--fail-fast\" must be positive");
+
+    if(options.isArgumentSet(SHARD_COORDINATOR_ARG_NAME) &&
+            options.isArgumentSet(SHARD_WORKER_ARG_NAME))
+        throw RTTException(options.objectInfo, "options \"--shard-coordinator\" and "
+                                               "\"--shard-worker\" can't be combined");
+
+    if(options.isPlanMode() && options.isShardMode())
+        throw RTTException(options.objectInfo, "option \"--plan\" can't be combined "
+                                               "with \"--shard-*\"");
+
     return options;
 }
 
@@ -75,6 +135,9 @@ std::string RTTCliOptions::getUsage() {
     rval << "                 values of <battery> are: nist_sts, dieharder,       " << std::endl;
     rval << "                 tu01_smallcrush, tu01_crush, tu01_bigcrush,         " << std::endl;
     rval << "                 tu01_rabbit, tu01_alphabit and tu01_blockalphabit.  " << std::endl;
+    rval << "                 Multiple batteries can be set as comma separated    " << std::endl;
+    rval << "                 list (e.g. dieharder,nist_sts), their tests are     " << std::endl;
+    rval << "                 then executed together.                             " << std::endl;
     rval << "                                                                     " << std::endl;
     rval << "-c <cfg-path>    Sets the path to the file with battery config.      " << std::endl;
     rval << "                 For the structure of the file see documentation.    " << std::endl;
@@ -82,6 +145,20 @@ std::string RTTCliOptions::getUsage() {
     rval << "-f <data-path>   Sets the path to the file with binary data. The data" << std::endl;
     rval << "                 will be analysed with the chosen battery.           " << std::endl;
     rval << "                                                                     " << std::endl;
+    rval << "--batch <path>   Can be set instead of -f. Sets multiple files with  " << std::endl;
+    rval << "                 binary data, <path> is either a directory with the  " << std::endl;
+    rval << "                 files or a file with one path per line. Tests of all" << std::endl;
+    rval << "                 files are executed together, results of each file   " << std::endl;
+    rval << "                 are stored as soon as its tests are finished.       " << std::endl;
+    rval << "                 Can't be used with db_mysql storage.                " << std::endl;
+    rval << "                                                                     " << std::endl;
+    rval << "--generator <cmd>                                                    " << std::endl;
+    rval << "                 Can be set instead of -f. Sets shell command that   " << std::endl;
+    rval << "                 writes the binary data to its standard output. The  " << std::endl;
+    rval << "                 command is executed once, its output is kept in     " << std::endl;
+    rval << "                 memory and analysed as if it was read from a file.  " << std::endl;
+    rval << "                 The output must be finite (e.g. limit it by head).  " << std::endl;
+    rval << "                                                                     " << std::endl;
     rval << "-t <test-id>     (Optional) Sets the id of the test that will be     " << std::endl;
     rval << "                 executed. If left empty, tests that are defined in  " << std::endl;
     rval << "                 battery configuration file will be executed.        " << std::endl;
@@ -95,6 +172,36 @@ std::string RTTCliOptions::getUsage() {
     rval << "--eid <eid>      (Optional) Must be set when <storage> is db_mysql.  " << std::endl;
     rval << "                 Sets id of experiment in the database that will be  " << std::endl;
     rval << "                 assigned the results of this battery execution.     " << std::endl;
+    rval << "                                                                     " << std::endl;
+    rval << "--fail-fast <n>  (Optional) Results of each test are evaluated as    " << std::endl;
+    rval << "                 soon as the test is finished. When <n> tests of a   " << std::endl;
+    rval << "                 battery fail, its remaining tests are cancelled and " << std::endl;
+    rval << "                 the results are stored marked as partial.           " << std::endl;
+    rval << "                                                                     " << std::endl;
+    rval << "--serve <socket> Runs the toolkit as a server listening on Unix      " << std::endl;
+    rval << "                 socket <socket>, must be the only option. Each      " << std::endl;
+    rval << "                 connection submits one job as a single line of the  " << std::endl;
+    rval << "                 options above (e.g. -b dieharder -f data.bin -c     " << std::endl;
+    rval << "                 cfg.json -r db_mysql --eid 12), options are         " << std::endl;
+    rval << "                 separated by spaces. Reply \"OK\" or \"ERROR <msg>\"    " << std::endl;
+    rval << "                 is sent when the results are stored. Queued jobs    " << std::endl;
+    rval << "                 are executed together in single pool of tests.      " << std::endl;
+    rval << "                                                                     " << std::endl;
+    rval << "--shard-coordinator <run-dir>                                        " << std::endl;
+    rval << "--shard-worker <run-dir>                                             " << std::endl;
+    rval << "                 (Optional) Shards the run across several instances  " << std::endl;
+    rval << "                 (e.g. on hosts sharing NFS mount) started with the  " << std::endl;
+    rval << "                 same options and the same <run-dir>. Instances claim" << std::endl;
+    rval << "                 the tests through lock files in <run-dir> and keep  " << std::endl;
+    rval << "                 their outputs there. Workers execute claimed tests  " << std::endl;
+    rval << "                 and end, single coordinator executes tests too, then" << std::endl;
+    rval << "                 waits for outputs of all tests and stores results.  " << std::endl;
+    rval << "                                                                     " << std::endl;
+    rval << "--plan <output>  (Optional) Only plans the run, nothing is executed  " << std::endl;
+    rval << "                 or stored. Tests are created and each command line, " << std::endl;
+    rval << "                 amount of input data read by each test, predicted   " << std::endl;
+    rval << "                 core-hours and makespan are written to file <output>" << std::endl;
+    rval << "                 (\"-\" for standard output).                          " << std::endl;
     rval << "=====================================================================" << std::endl;
     return rval.str();
 }
@@ -104,9 +211,52 @@ std::string RTTCliOptions::getInputCfgPath() const {
 }
 
 std::string RTTCliOptions::getInputDataPath() const {
+    if(isGeneratorMode())
+        return GENERATOR_INPUT_NAME;
+    if(isBatchMode())
+        return getArgumentValue<std::string>(BATCH_ARG_NAME);
+
     return getArgumentValue<std::string>(DATA_FILE_ARG_NAME);
 }
 
+std::vector<std::string> RTTCliOptions::getInputDataPaths() const {
+    if(!isBatchMode())
+        return { getInputDataPath() };
+
+    auto batchPath = getArgumentValue<std::string>(BATCH_ARG_NAME);
+    if(!Utils::fileExist(batchPath))
+        throw RTTException(objectInfo, Strings::ERR_FILE_OPEN_FAIL + batchPath);
+
+    try {
+        if(Utils::isDirectory(batchPath))
+            return Utils::listDirFiles(batchPath);
+
+        /* List file, one path per line, empty lines and comments are skipped */
+        std::vector<std::string> rval;
+        for(std::string line : Utils::split(Utils::readFileToString(batchPath), '\n')) {
+            line.erase(0, line.find_first_not_of(" \t\r"));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if(!line.empty() && line.front() != '#')
+                rval.push_back(line);
+        }
+        return rval;
+    } catch (std::runtime_error & e) {
+        throw RTTException(objectInfo, e.what());
+    }
+}
+
+bool RTTCliOptions::isBatchMode() const {
+    return isArgumentSet(BATCH_ARG_NAME);
+}
+
+bool RTTCliOptions::isGeneratorMode() const {
+    return isArgumentSet(GENERATOR_ARG_NAME);
+}
+
+std::string RTTCliOptions::getGeneratorCommand() const {
+    return getArgumentValue<std::string>(GENERATOR_ARG_NAME);
+}
+
 std::vector<int> RTTCliOptions::getTestConsts() const {
     if(isArgumentSet(TEST_ID_ARG_NAME))
         return { getArgumentValue<int>(TEST_ID_ARG_NAME) };
@@ -114,12 +264,20 @@ std::vector<int> RTTCliOptions::getTestConsts() const {
     return {};
 }
 
-Constants::BatteryID RTTCliOptions::getBatteryId() const {
-    return getBatteryArg().getBatteryId();
-}
+std::vector<BatteryArg> RTTCliOptions::getBatteryArgs() const {
+    std::vector<BatteryArg> rval;
+    for(const std::string & shortName :
+        Utils::split(getArgumentValue<std::string>(BATTERY_ARG_NAME), ',')) {
+        try {
+            rval.push_back(BatteryArg(shortName));
+        } catch (std::runtime_error & e) {
+            throw RTTException(objectInfo, e.what());
+        }
+    }
+    if(rval.empty())
+        throw RTTException(objectInfo, "no battery was set");
 
-BatteryArg RTTCliOptions::getBatteryArg() const {
-    return getArgumentValue<BatteryArg>(BATTERY_ARG_NAME);
+    return rval;
 }
 
 Constants::ResultStorageID RTTCliOptions::getResultStorageId() const {
@@ -134,6 +292,46 @@ std::uint64_t RTTCliOptions::getMysqlDbEid() const {
     return getArgumentValue<std::uint64_t>(MYSQL_DB_EID_ARG_NAME);
 }
 
+int RTTCliOptions::getFailFastCount() const {
+    if(isArgumentSet(FAIL_FAST_ARG_NAME))
+        return getArgumentValue<int>(FAIL_FAST_ARG_NAME);
+
+    return 0;
+}
+
+bool RTTCliOptions::isServeMode() const {
+    return isArgumentSet(SERVE_ARG_NAME);
+}
+
+std::string RTTCliOptions::getServeSocketPath() const {
+    return getArgumentValue<std::string>(SERVE_ARG_NAME);
+}
+
+bool RTTCliOptions::isShardMode() const {
+    return isArgumentSet(SHARD_COORDINATOR_ARG_NAME) || isArgumentSet(SHARD_WORKER_ARG_NAME);
+}
+
+bool RTTCliOptions::isShardCoordinator() const {
+    return isArgumentSet(SHARD_COORDINATOR_ARG_NAME);
+}
+
+std::string RTTCliOptions::getShardRunDir() const {
+    if(isShardCoordinator())
+        return getArgumentValue<std::string>(SHARD_COORDINATOR_ARG_NAME);
+    if(isArgumentSet(SHARD_WORKER_ARG_NAME))
+        return getArgumentValue<std::string>(SHARD_WORKER_ARG_NAME);
+
+    return "";
+}
+
+bool RTTCliOptions::isPlanMode() const {
+    return isArgumentSet(PLAN_ARG_NAME);
+}
+
+std::string RTTCliOptions::getPlanOutputPath() const {
+    return getArgumentValue<std::string>(PLAN_ARG_NAME);
+}
+
 bool RTTCliOptions::isArgumentSet(const std::string & argName) const {
     auto cmpArgumentName = [&](const auto & arg) {
         return argName == arg.getArgumentName();
@@ -45,6 +45,9 @@ public:
      */
     static std::string getUsage();
 
+    /* Name used in place of input file path when generator is analysed */
+    static const std::string GENERATOR_INPUT_NAME;
+
     /**
      * @brief getInputCfgPath
      * @return Path to config with battery configuration.
@@ -53,27 +56,49 @@ public:
 
     /**
      * @brief getInputDataPath
-     * @return Path to file with binary data to analyse.
+     * @return Path to file with binary data to analyse. In batch mode,
+     * path to the directory or file with the list of analysed files,
+     * GENERATOR_INPUT_NAME in generator mode.
      */
     std::string getInputDataPath() const;
 
     /**
-     * @brief getTestConsts
-     * @return IDs of tests that was set through the command line.
+     * @brief getInputDataPaths
+     * @return Paths to all files with binary data to analyse.
      */
-    std::vector<int> getTestConsts() const;
+    std::vector<std::string> getInputDataPaths() const;
+
+    /**
+     * @brief isBatchMode
+     * @return True if multiple input files were set with batch option.
+     */
+    bool isBatchMode() const;
+
+    /**
+     * @brief isGeneratorMode
+     * @return True if output of generator command is analysed instead of file.
+     * Input data path is then GENERATOR_INPUT_NAME.
+     */
+    bool isGeneratorMode() const;
 
     /**
-     * @brief getBatteryId
-     * @return ID of the chosen battery.
+     * @brief getGeneratorCommand
+     * @return Shell command that generates the analysed data.
      */
-    Constants::BatteryID getBatteryId() const;
+    std::string getGeneratorCommand() const;
 
     /**
-     * @brief getBatteryArg
-     * @return Whole object of the chosen battery.
+     * @brief getTestConsts
+     * @return IDs of tests that was set through the command line.
+     */
+    std::vector<int> getTestConsts() const;
+
+    /**
+     * @brief getBatteryArgs
+     * @return Objects of all chosen batteries, in order in which
+     * they were set on the command line.
      */
-    BatteryArg getBatteryArg() const;
+    std::vector<BatteryArg> getBatteryArgs() const;
 
     /**
      * @brief getResultStorageId
@@ -93,21 +118,88 @@ public:
      */
     std::uint64_t getMysqlDbEid() const;
 
+    /**
+     * @brief getFailFastCount
+     * @return Number of failed tests after which the remaining tests
+     * of the battery are cancelled, 0 if all tests are always executed.
+     */
+    int getFailFastCount() const;
+
+    /**
+     * @brief isServeMode
+     * @return True if the toolkit runs as a server that executes jobs
+     * submitted through a socket. No other options are set then.
+     */
+    bool isServeMode() const;
+
+    /**
+     * @brief getServeSocketPath
+     * @return Path of the Unix socket on which the server listens.
+     */
+    std::string getServeSocketPath() const;
+
+    /**
+     * @brief isShardMode
+     * @return True if the run is sharded, its variants are then executed
+     * by several instances of the toolkit that share the run directory.
+     */
+    bool isShardMode() const;
+
+    /**
+     * @brief isShardCoordinator
+     * @return True if this instance collects outputs of all variants
+     * of the sharded run and stores the results.
+     */
+    bool isShardCoordinator() const;
+
+    /**
+     * @brief getShardRunDir
+     * @return Directory shared by all instances of the sharded run.
+     */
+    std::string getShardRunDir() const;
+
+    /**
+     * @brief isPlanMode
+     * @return True if the run is only planned, tests are created
+     * but nothing is executed or stored.
+     */
+    bool isPlanMode() const;
+
+    /**
+     * @brief getPlanOutputPath
+     * @return Path of the file where the plan is written, "-" for standard output.
+     */
+    std::string getPlanOutputPath() const;
+
 private:
     static const std::string BATTERY_ARG_NAME;
     static const std::string DATA_FILE_ARG_NAME;
+    static const std::string BATCH_ARG_NAME;
+    static const std::string GENERATOR_ARG_NAME;
     static const std::string CONF_FILE_ARG_NAME;
     static const std::string TEST_ID_ARG_NAME;
     static const std::string RESULT_STORAGE_ARG_NAME;
     static const std::string MYSQL_DB_EID_ARG_NAME;
+    static const std::string FAIL_FAST_ARG_NAME;
+    static const std::string SERVE_ARG_NAME;
+    static const std::string SHARD_COORDINATOR_ARG_NAME;
+    static const std::string SHARD_WORKER_ARG_NAME;
+    static const std::string PLAN_ARG_NAME;
 
     std::vector<tArgumentTypes> arguments = {
-        ClArgument<BatteryArg>(BATTERY_ARG_NAME),                    /* Battery */
-        ClArgument<std::string>(DATA_FILE_ARG_NAME),                 /* Input data file */
+        ClArgument<std::string>(BATTERY_ARG_NAME),                   /* Battery list */
+        ClArgument<std::string>(DATA_FILE_ARG_NAME, true),           /* Input data file */
+        ClArgument<std::string>(BATCH_ARG_NAME, true),               /* Input data files */
+        ClArgument<std::string>(GENERATOR_ARG_NAME, true),           /* Input data generator */
         ClArgument<std::string>(CONF_FILE_ARG_NAME),                 /* Input config file */
         ClArgument<int>(TEST_ID_ARG_NAME, true),                     /* (opt) Test to run in battery */
         ClArgument<ResultStorageArg>(RESULT_STORAGE_ARG_NAME, true), /* (opt) Result storage */
-        ClArgument<std::uint64_t>(MYSQL_DB_EID_ARG_NAME, true)       /* (opt) Experiment ID  */
+        ClArgument<std::uint64_t>(MYSQL_DB_EID_ARG_NAME, true),      /* (opt) Experiment ID  */
+        ClArgument<int>(FAIL_FAST_ARG_NAME, true),                   /* (opt) Failed tests limit */
+        ClArgument<std::string>(SERVE_ARG_NAME, true),               /* (opt) Server socket */
+        ClArgument<std::string>(SHARD_COORDINATOR_ARG_NAME, true),   /* (opt) Shard run directory */
+        ClArgument<std::string>(SHARD_WORKER_ARG_NAME, true),        /* (opt) Shard run directory */
+        ClArgument<std::string>(PLAN_ARG_NAME, true)                 /* (opt) Plan output file */
     };
 
     std::string objectInfo = "CL Arguments Parser";
@@ -6,18 +6,18 @@ namespace rtt {
 void GlobalContainer::initRttCliOptions(int argc, char * argv[]) {
     using namespace clinterface;
     rttCliOptions =
-            std::make_unique<RTTCliOptions>(RTTCliOptions::getInstance(argc , argv));
+            std::make_shared<RTTCliOptions>(RTTCliOptions::getInstance(argc , argv));
 }
 
 void GlobalContainer::initToolkitSettings(const std::string & filename) {
     toolkitSettings =
-            std::make_unique<ToolkitSettings>(ToolkitSettings::getInstance(filename));
+            std::make_shared<ToolkitSettings>(ToolkitSettings::getInstance(filename));
 }
 
 void GlobalContainer::initBatteriesConfiguration(const std::string & filename) {
     using namespace batteries;
     batteryConfiguration =
-            std::make_unique<Configuration>(Configuration::getInstance(filename));
+            std::make_shared<Configuration>(Configuration::getInstance(filename));
 }
 
 void GlobalContainer::initLogger(const std::string & logId, bool toCout) {
@@ -26,13 +26,83 @@ void GlobalContainer::initLogger(const std::string & logId, bool toCout) {
     if(toolkitSettings == nullptr)
         raiseBugException("can't initialize logger before toolkit settings are init'd");
 
-    auto logFilePath = Utils::getLogFilePath(creationTime,
-                                             toolkitSettings->getLoggerRunLogDir(),
-                                             rttCliOptions->getInputDataPath(),
-                                             rttCliOptions->getBatteryArg().getShortName()
-                       );
+    /* Batteries executed together share the log, server has single log for all jobs */
+    std::string batteryShortNames;
+    std::string inputDataPath = "server";
+    if(!rttCliOptions->isServeMode()) {
+        for(const auto & battery : rttCliOptions->getBatteryArgs()) {
+            if(!batteryShortNames.empty())
+                batteryShortNames.append("+");
+            batteryShortNames.append(battery.getShortName());
+        }
+        inputDataPath = rttCliOptions->getInputDataPath();
+    }
+    logFilePath = Utils::getLogFilePath(creationTime,
+                                        toolkitSettings->getLoggerRunLogDir(),
+                                        inputDataPath, batteryShortNames);
+
+    logger = std::shared_ptr<Logger>(new Logger(logId , logFilePath , toCout));
+}
+
+void GlobalContainer::initShardQueue() {
+    if(rttCliOptions == nullptr)
+        raiseBugException("can't initialize shard queue before command line options are init'd");
+    if(logger == nullptr)
+        raiseBugException("can't initialize shard queue before logger is init'd");
+
+    shardQueue = batteries::ShardQueue::getInstance(logger.get(),
+                                                    rttCliOptions->getShardRunDir(),
+                                                    rttCliOptions->isShardCoordinator());
+}
+
+void GlobalContainer::initResultCache() {
+    if(toolkitSettings == nullptr)
+        raiseBugException("can't initialize result cache before toolkit settings are init'd");
+    if(logger == nullptr)
+        raiseBugException("can't initialize result cache before logger is init'd");
+    if(shardQueue == nullptr)
+        raiseBugException("can't initialize result cache before shard queue is init'd");
+
+    /* Instances of sharded run exchange the outputs through the cache */
+    if(shardQueue->isEnabled())
+        resultCache = batteries::ResultCache::getInstance(logger.get(),
+                                                          shardQueue->getOutputDir(), true);
+    else
+        resultCache = batteries::ResultCache::getInstance(
+                          logger.get(), toolkitSettings->getExecResultCacheDir());
+}
+
+void GlobalContainer::initSharedInput() {
+    if(toolkitSettings == nullptr)
+        raiseBugException("can't initialize shared input before toolkit settings are init'd");
+    if(logger == nullptr)
+        raiseBugException("can't initialize shared input before logger is init'd");
+
+    sharedInput = batteries::SharedInput::getInstance(
+                      logger.get(), toolkitSettings->getExecSharedInput(),
+                      toolkitSettings->getExecCpuPinning() != batteries::CpuPinning::POLICY_NONE,
+                      toolkitSettings->getExecSharedInputMaxFiles(),
+                      toolkitSettings->getExecMemoryBudget() * 1024ULL * 1024ULL,
+                      toolkitSettings->getExecScratchDir(),
+                      toolkitSettings->getExecGeneratorMax() * 1024ULL * 1024ULL);
+}
 
-    logger = std::unique_ptr<Logger>(new Logger(logId , logFilePath , toCout));
+std::unique_ptr<GlobalContainer> GlobalContainer::createJobContainer(
+        const clinterface::RTTCliOptions & options,
+        std::shared_ptr<batteries::Configuration> configuration,
+        int jobId) const {
+    std::unique_ptr<GlobalContainer> job (new GlobalContainer());
+    job->jobId                = jobId;
+    job->rttCliOptions        = std::make_shared<clinterface::RTTCliOptions>(options);
+    job->batteryConfiguration = std::move(configuration);
+    job->toolkitSettings      = toolkitSettings;
+    job->logger               = logger;
+    job->resultCache          = resultCache;
+    job->sharedInput          = sharedInput;
+    job->shardQueue           = shardQueue;
+    job->logFilePath          = logFilePath;
+
+    return job;
 }
 
 clinterface::RTTCliOptions * GlobalContainer::getRttCliOptions() const {
@@ -63,9 +133,38 @@ Logger * GlobalContainer::getLogger() const {
     return logger.get();
 }
 
+batteries::ResultCache * GlobalContainer::getResultCache() const {
+    if(resultCache == nullptr)
+        raiseBugException("resultCache was not initialized");
+
+    return resultCache.get();
+}
+
+batteries::SharedInput * GlobalContainer::getSharedInput() const {
+    if(sharedInput == nullptr)
+        raiseBugException("sharedInput was not initialized");
+
+    return sharedInput.get();
+}
+
+batteries::ShardQueue * GlobalContainer::getShardQueue() const {
+    if(shardQueue == nullptr)
+        raiseBugException("shardQueue was not initialized");
+
+    return shardQueue.get();
+}
+
+int GlobalContainer::getJobId() const {
+    return jobId;
+}
+
 time_t GlobalContainer::getCreationTime() const {
     return creationTime;
 }
 
+std::string GlobalContainer::getLogFilePath() const {
+    return logFilePath;
+}
+
 
 } // namespace rtt
@@ -7,6 +7,9 @@
 #include "rtt/toolkitsettings.h"
 #include "rtt/batteries/configuration-batt.h"
 #include "rtt/logger.h"
+#include "rtt/batteries/resultcache-batt.h"
+#include "rtt/batteries/sharedinput-batt.h"
+#include "rtt/batteries/shardqueue-batt.h"
 
 namespace rtt {
 
@@ -17,7 +20,8 @@ namespace rtt {
  * as constant reference, only holds pointers to other objects. Before
  * calling getter on desired object, it must be first initialized using
  * init methods. Init only calls class' constructor or getInstance
- * method and creates an unique pointer.
+ * method and creates a pointer. Job containers of the server share
+ * the objects of the server container.
  */
 class GlobalContainer {
 public:
@@ -53,12 +57,58 @@ public:
      */
     void initLogger(const std::string & logId , bool toCout);
 
+    /**
+     * @brief initShardQueue Initializes work queue of sharded run,
+     * command line options and logger must be initialized before.
+     */
+    void initShardQueue();
+
+    /**
+     * @brief initResultCache Initializes cache of variant outputs, toolkit settings,
+     * logger and shard queue must be initialized before. Sharded run uses
+     * the cache in its run directory instead of the one from settings.
+     */
+    void initResultCache();
+
+    /**
+     * @brief initSharedInput Initializes provider of input data for battery processes,
+     * toolkit settings and logger must be initialized before.
+     */
+    void initSharedInput();
+
+    /**
+     * @brief createJobContainer Creates container of a job submitted to the server.
+     * Toolkit settings, logger, result cache and shared input are shared with this
+     * container, the job has its own options, battery configuration and creation time.
+     * @param options Options of the job
+     * @param configuration Parsed battery configuration of the job
+     * @param jobId Identifier of the job, unique within the server
+     * @return Job container
+     */
+    std::unique_ptr<GlobalContainer> createJobContainer(
+            const clinterface::RTTCliOptions & options,
+            std::shared_ptr<batteries::Configuration> configuration,
+            int jobId) const;
+
+    /**
+     * @brief getJobId
+     * @return Identifier of the job submitted to the server, 0 outside of server
+     */
+    int getJobId() const;
+
     /**
      * @brief getCreationTime
      * @return Raw time of creation of the class instance
      */
     time_t getCreationTime() const;
 
+    /**
+     * @brief getLogFilePath
+     * @return Path of the log file, files of the run
+     * (e.g. checkpoint) are named after it
+     */
+    std::string getLogFilePath() const;
+
     /**
      * @brief getCliOptions
      * @return CliOptions pointer, bug exception if not initialized
@@ -83,14 +133,37 @@ public:
      */
     Logger * getLogger() const;
 
+    /**
+     * @brief getResultCache
+     * @return ResultCache pointer, bug exception if not initialized
+     */
+    batteries::ResultCache * getResultCache() const;
+
+    /**
+     * @brief getSharedInput
+     * @return SharedInput pointer, bug exception if not initialized
+     */
+    batteries::SharedInput * getSharedInput() const;
+
+    /**
+     * @brief getShardQueue
+     * @return ShardQueue pointer, bug exception if not initialized
+     */
+    batteries::ShardQueue * getShardQueue() const;
+
 private:
     /* Application start time, will be used in naming files, etc. */
     time_t creationTime;
+    std::string logFilePath;
+    int jobId = 0;
     //std::unique_ptr<CliOptions> cliOptions;
-    std::unique_ptr<clinterface::RTTCliOptions> rttCliOptions;
-    std::unique_ptr<ToolkitSettings> toolkitSettings;
-    std::unique_ptr<batteries::Configuration> batteryConfiguration;
-    std::unique_ptr<Logger> logger;
+    std::shared_ptr<clinterface::RTTCliOptions> rttCliOptions;
+    std::shared_ptr<ToolkitSettings> toolkitSettings;
+    std::shared_ptr<batteries::Configuration> batteryConfiguration;
+    std::shared_ptr<Logger> logger;
+    std::shared_ptr<batteries::ResultCache> resultCache;
+    std::shared_ptr<batteries::SharedInput> sharedInput;
+    std::shared_ptr<batteries::ShardQueue> shardQueue;
 };
 
 } // namespace rtt
@@ -0,0 +1,233 @@
+#include "jobserver.h"
+
+#include <thread>
+#include <sstream>
+
+#include "rtt/storage/mysqlstorage.h"
+#include "rtt/batteries/testrunner-batt.h"
+
+namespace rtt {
+
+const std::string JobServer::objectInfo          = "Job server";
+const size_t      JobServer::MAX_REQUEST_LENGTH  = 64 * 1024;
+
+std::unique_ptr<JobServer> JobServer::getInstance(const GlobalContainer & container) {
+    std::unique_ptr<JobServer> s (new JobServer());
+    s->container = &container;
+    s->logger = container.getLogger();
+    s->socketPath = container.getRttCliOptions()->getServeSocketPath();
+
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if(s->socketPath.empty() || s->socketPath.size() >= sizeof(addr.sun_path))
+        throw RTTException(objectInfo, "invalid socket path: " + s->socketPath);
+    s->socketPath.copy(addr.sun_path, s->socketPath.size());
+
+    /* Socket left by the previous server is replaced, other files are not */
+    struct stat st;
+    if(lstat(s->socketPath.c_str(), &st) == 0) {
+        if(!S_ISSOCK(st.st_mode))
+            throw RTTException(objectInfo, s->socketPath + " exists and is not a socket");
+        unlink(s->socketPath.c_str());
+    }
+
+    /* Descriptors of the server are not inherited by battery processes */
+    s->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(s->listenFd < 0 ||
+       bind(s->listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+       listen(s->listenFd, SOMAXCONN) != 0)
+        throw RTTException(objectInfo, "can't listen on " + s->socketPath + ": " +
+                           strerror(errno));
+
+    return s;
+}
+
+JobServer::~JobServer() {
+    if(listenFd >= 0) {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+}
+
+void JobServer::run() {
+    logger->info(objectInfo + ": listening on " + socketPath);
+    storage::MySQLStorage::keepConnections(true);
+
+    for(;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if(fd < 0) {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+            std::lock_guard<std::mutex> l (runningRequests_mux);
+            if(stopping)
+                break;
+            logger->error(objectInfo + ": accepting of connections failed: " + strerror(errno));
+            break;
+        }
+        /* Slow client blocks only its own thread. Job is executed alongside
+         * the running jobs, its tests join their pool. */
+        {
+            std::lock_guard<std::mutex> l (runningRequests_mux);
+            ++runningRequests;
+        }
+        std::thread (&JobServer::handleConnection, this, fd).detach();
+    }
+
+    std::unique_lock<std::mutex> l (runningRequests_mux);
+    runningRequests_cv.wait(l, [&]() { return runningRequests == 0; });
+    storage::MySQLStorage::keepConnections(false);
+}
+
+void JobServer::stop() {
+    std::lock_guard<std::mutex> l (runningRequests_mux);
+    stopping = true;
+    /* Blocked accept fails, so that run can end */
+    shutdown(listenFd, SHUT_RDWR);
+}
+
+std::unique_ptr<JobServer::Request> JobServer::readRequest(int fd) {
+    /* Client that doesn't send its job doesn't keep its thread forever */
+    timeval timeout = {};
+    timeout.tv_sec = 10;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string line;
+    char buffer[4096];
+    while(line.find('\n') == std::string::npos && line.size() <= MAX_REQUEST_LENGTH) {
+        ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0)
+            break;
+        line.append(buffer, count);
+    }
+    line = line.substr(0, line.find('\n'));
+
+    /* Job has the same options as the command line, program name is added */
+    std::vector<std::string> args = { "randomness-testing-toolkit" };
+    std::istringstream tokens (line);
+    for(std::string token ; tokens >> token ; )
+        args.push_back(token);
+    std::vector<char *> argv;
+    for(std::string & arg : args)
+        argv.push_back(&arg[0]);
+
+    /* Rejected jobs are not logged as errors, those
+     * would be stored in the reports of other jobs. */
+    try {
+        if(line.size() > MAX_REQUEST_LENGTH)
+            throw RTTException(objectInfo, "job is too long");
+        if(args.size() == 1)
+            throw RTTException(objectInfo, "no options were received");
+
+        std::unique_ptr<Request> request (new Request());
+        {
+            std::lock_guard<std::mutex> l (runningRequests_mux);
+            request->id = ++lastJobId;
+        }
+        request->fd = fd;
+        request->options = std::make_unique<clinterface::RTTCliOptions>(
+                               clinterface::RTTCliOptions::getInstance(argv.size(),
+                                                                       argv.data()));
+        /* Outputs of concurrent generators would share single name */
+        if(request->options->isServeMode() || request->options->isGeneratorMode() ||
+           request->options->isShardMode() || request->options->isPlanMode())
+            throw RTTException(objectInfo, "options \"--serve\", \"--generator\", "
+                                           "\"--shard-*\" and \"--plan\" can't be used in job");
+        logger->info(objectInfo + ": job " + Utils::itostr(request->id) + " queued: " + line);
+        return request;
+    } catch(std::exception & ex) {
+        logger->info(objectInfo + ": job rejected: " + ex.what());
+        reply(fd, "ERROR " + std::string(ex.what()));
+        return nullptr;
+    }
+}
+
+void JobServer::handleConnection(int fd) {
+    auto request = readRequest(fd);
+    if(request)
+        executeRequest(std::move(request));
+
+    {
+        std::lock_guard<std::mutex> l (runningRequests_mux);
+        --runningRequests;
+    }
+    runningRequests_cv.notify_all();
+}
+
+void JobServer::executeRequest(std::unique_ptr<Request> request) {
+    /* Jobs are not started after the execution was stopped */
+    if(batteries::TestRunner::isStopped()) {
+        reply(request->fd, "ERROR server was stopped, job wasn't executed");
+        request->fd = -1;
+    }
+
+    std::vector<BatteryJob> jobs;
+    if(request->fd >= 0) {
+        try {
+            request->container = container->createJobContainer(
+                                     *request->options,
+                                     getConfiguration(request->options->getInputCfgPath()),
+                                     request->id);
+            request->storage = storage::IStorage::getInstance(*request->container);
+            jobs = BatteryJob::createJobs(*request->container, request->storage.get());
+            request->unstoredJobs = jobs.size();
+        } catch(std::exception & ex) {
+            logger->info(objectInfo + ": job rejected: " + ex.what());
+            reply(request->fd, "ERROR " + std::string(ex.what()));
+            request->fd = -1;
+        }
+    }
+
+    if(!jobs.empty()) {
+        logger->info(objectInfo + ": job " + Utils::itostr(request->id) + " executes " +
+                     Utils::itostr(jobs.size()) + " batteries");
+        /* Client gets reply as soon as all batteries of its job are stored */
+        auto onJobStored = [&](BatteryJob & job) {
+            if(job.battery && job.battery->isStoppedEarly())
+                request->partial = true;
+            if(--request->unstoredJobs == 0) {
+                reply(request->fd, request->partial && batteries::TestRunner::isStopped() ?
+                                   "ERROR execution was stopped, results are partial" : "OK");
+                request->fd = -1;
+            }
+        };
+        BatteryJob::executeJobs(jobs, logger, onJobStored);
+        BatteryJob::storeJobs(jobs, logger, onJobStored);
+    }
+
+    /* Jobs are destroyed before their container */
+    jobs.clear();
+}
+
+std::shared_ptr<batteries::Configuration> JobServer::getConfiguration(
+        const std::string & path) {
+    auto absolutePath = Utils::getAbsolutePath(path);
+    struct stat st;
+    if(stat(absolutePath.c_str(), &st) != 0)
+        throw RTTException(objectInfo, Strings::ERR_FILE_OPEN_FAIL + path);
+
+    std::lock_guard<std::mutex> l (configurations_mux);
+    auto it = configurations.find(absolutePath);
+    if(it != configurations.end() && it->second.size == st.st_size &&
+       it->second.modificationTime.tv_sec == st.st_mtim.tv_sec &&
+       it->second.modificationTime.tv_nsec == st.st_mtim.tv_nsec)
+        return it->second.configuration;
+
+    CachedConfiguration cached;
+    cached.configuration = std::make_shared<batteries::Configuration>(
+                               batteries::Configuration::getInstance(absolutePath));
+    cached.modificationTime = st.st_mtim;
+    cached.size = st.st_size;
+    configurations[absolutePath] = cached;
+    return cached.configuration;
+}
+
+void JobServer::reply(int fd, const std::string & message) {
+    /* Client that already disconnected must not kill the server by SIGPIPE */
+    std::string line = message + "\n";
+    send(fd, line.data(), line.size(), MSG_NOSIGNAL);
+    close(fd);
+}
+
+} // namespace rtt
@@ -0,0 +1,113 @@
+#ifndef RTT_JOBSERVER_H
+#define RTT_JOBSERVER_H
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+
+#include "rtt/globalcontainer.h"
+#include "rtt/batteryjob.h"
+#include "rtt/rttexception.h"
+
+namespace rtt {
+
+/**
+ * @brief The JobServer class Keeps the toolkit resident and executes jobs submitted
+ * through Unix socket. Each connection submits one job as a single line with
+ * command line options of a normal run. The reply "OK" is sent when all results
+ * of the job are stored, "ERROR <message>" when the job can't be executed.
+ * Toolkit settings, logger, result cache and parsed battery configurations are
+ * kept between jobs, connections of the database storage are reused.
+ * Each job is prepared in its own thread and its tests join the tests
+ * of the running jobs, all of them run in single pool limited by the maximum
+ * number of threads from toolkit settings.
+ * Messages in the log are marked by identifier of their job, each job
+ * stores only its own warnings and errors.
+ */
+class JobServer {
+public:
+    /**
+     * @brief getInstance Creates server listening on the socket
+     * set on the command line. Stale socket file is replaced.
+     * @param container Container of the server, its objects are shared by all jobs
+     * @return Server
+     */
+    static std::unique_ptr<JobServer> getInstance(const GlobalContainer & container);
+
+    ~JobServer();
+
+    /**
+     * @brief run Accepts and executes jobs, returns when the server was
+     * stopped or the listening socket failed. Running jobs are finished before.
+     */
+    void run();
+
+    /**
+     * @brief stop Stops accepting of jobs, can be called from any thread.
+     * Jobs that weren't started are rejected, running jobs are
+     * stopped by TestRunner::stopExecution and stored as partial.
+     */
+    void stop();
+
+private:
+    /* Submitted job, it owns container and storage of its batteries */
+    struct Request {
+        int id = 0;
+        int fd = -1;
+        std::unique_ptr<clinterface::RTTCliOptions> options;
+        std::unique_ptr<GlobalContainer> container;
+        std::unique_ptr<storage::IStorage> storage;
+        size_t unstoredJobs = 0;
+        bool partial = false;
+    };
+
+    /* Parsed configuration and identity of its file when it was parsed */
+    struct CachedConfiguration {
+        std::shared_ptr<batteries::Configuration> configuration;
+        struct timespec modificationTime = {};
+        off_t size = 0;
+    };
+
+    static const std::string objectInfo;
+    /* Longest accepted line with the job */
+    static const size_t MAX_REQUEST_LENGTH;
+
+    const GlobalContainer * container;
+    Logger * logger;
+    std::string socketPath;
+    int listenFd = -1;
+    /* Number of connections whose threads didn't end yet */
+    int runningRequests = 0;
+    /* Identifier of the last accepted job */
+    int lastJobId = 0;
+    bool stopping = false;
+    std::mutex runningRequests_mux;
+    std::condition_variable runningRequests_cv;
+
+    std::map<std::string, CachedConfiguration> configurations;
+    std::mutex configurations_mux;
+
+    JobServer() {}
+
+    /* Reads and parses job of the connection, returns null if it was rejected */
+    std::unique_ptr<Request> readRequest(int fd);
+
+    /* Reads and executes job of the connection, runs in its own thread */
+    void handleConnection(int fd);
+
+    void executeRequest(std::unique_ptr<Request> request);
+
+    /* Returns parsed configuration, file is parsed again only when it was changed */
+    std::shared_ptr<batteries::Configuration> getConfiguration(const std::string & path);
+
+    /* Sends reply and closes the connection */
+    static void reply(int fd, const std::string & message);
+};
+
+} // namespace rtt
+
+#endif // RTT_JOBSERVER_H
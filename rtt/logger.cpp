@@ -57,8 +57,8 @@ Logger::~Logger() {
     /* Writing ending info */
     rawLogger->info("\n\nLogging end        " +
                     Utils::formatRawTime(Utils::getRawTime() , "%d-%m-%Y %H:%M:%S"));
-    rawLogger->info("Error count        " + Utils::itostr(errorMessages.size()));
-    rawLogger->info("Warning count      " + Utils::itostr(warningMessages.size()));
+    rawLogger->info("Error count        " + Utils::itostr(errorCount));
+    rawLogger->info("Warning count      " + Utils::itostr(warningCount));
     rawLogger->info("");
 }
 
@@ -87,7 +87,9 @@ void Logger::warn(const std::string & msg) {
     rawLogger->warn(msg);
     {
         std::lock_guard<std::mutex> l (warningMessages_mux);
-        warningMessages.push_back(msg);
+        ++warningCount;
+        if(!addToScopes(msg, LogLevel::WARN))
+            warningMessages.push_back(msg);
     }
 }
 
@@ -96,7 +98,9 @@ void Logger::error(const std::string & msg) {
     rawLogger->error(msg);
     {
         std::lock_guard<std::mutex> l (errorMessages_mux);
-        errorMessages.push_back(msg);
+        ++errorCount;
+        if(!addToScopes(msg, LogLevel::ERROR))
+            errorMessages.push_back(msg);
     }
 }
 
@@ -110,4 +114,38 @@ std::vector<std::string> Logger::getErrorMessages() {
     return errorMessages;
 }
 
+void Logger::openScope(const std::string & objectInfo) {
+    std::lock_guard<std::mutex> l (scopes_mux);
+    if(!scopes.emplace(objectInfo, decltype(scopes)::mapped_type()).second)
+        raiseBugException("scope of " + objectInfo + " is already open");
+}
+
+void Logger::closeScope(const std::string & objectInfo,
+                        std::vector<std::string> & warnings,
+                        std::vector<std::string> & errors) {
+    std::lock_guard<std::mutex> l (scopes_mux);
+    auto it = scopes.find(objectInfo);
+    if(it == scopes.end())
+        raiseBugException("scope of " + objectInfo + " is not open");
+    warnings = std::move(it->second.first);
+    errors = std::move(it->second.second);
+    scopes.erase(it);
+}
+
+bool Logger::addToScopes(const std::string & msg, LogLevel level) {
+    std::lock_guard<std::mutex> l (scopes_mux);
+    if(scopes.empty())
+        return false;
+
+    /* Messages start with object info of their origin */
+    auto it = scopes.find(msg.substr(0, std::min(msg.find(':'), msg.find(" - "))));
+    if(it != scopes.end()) {
+        (level == LogLevel::WARN ? it->second.first : it->second.second).push_back(msg);
+        return true;
+    }
+    for(auto & scope : scopes)
+        (level == LogLevel::WARN ? scope.second.first : scope.second.second).push_back(msg);
+    return true;
+}
+
 } // namespace rtt
@@ -1,6 +1,7 @@
 #ifndef RTT_LOGGER_H
 #define RTT_LOGGER_H
 
+#include <map>
 #include <string>
 
 #ifndef ELPP_NO_DEFAULT_LOG_FILE
@@ -78,6 +79,27 @@ public:
      */
     std::vector<std::string> getErrorMessages();
 
+    /**
+     * @brief openScope Starts collecting warnings and errors of the object
+     * separately, e.g. of a job executed by the server. Messages of the object
+     * go only into its scope, messages of no open scope go into all open scopes.
+     * Messages are stored by the logger itself only while no scope is open.
+     * @param objectInfo Info of the object, its messages start with it
+     * followed by ':' or " - "
+     */
+    void openScope(const std::string & objectInfo);
+
+    /**
+     * @brief closeScope Stops collecting messages of the object, later
+     * messages of the object are handled as messages of no scope.
+     * @param objectInfo Info of the object
+     * @param warnings Warnings collected in the scope
+     * @param errors Errors collected in the scope
+     */
+    void closeScope(const std::string & objectInfo,
+                    std::vector<std::string> & warnings,
+                    std::vector<std::string> & errors);
+
 private:
     el::Logger * rawLogger = NULL;
     el::Configurations rawLoggerConf;
@@ -89,6 +111,18 @@ private:
     /* Mutex for operations with error messages */
     std::mutex errorMessages_mux;
     std::vector<std::string> errorMessages;
+
+    /* All messages logged, including those collected in scopes */
+    size_t warningCount = 0;
+    size_t errorCount = 0;
+
+    /* Warnings and errors collected in each open scope */
+    std::mutex scopes_mux;
+    std::map<std::string, std::pair<std::vector<std::string>,
+                                    std::vector<std::string>>> scopes;
+
+    /* Adds the message into scopes, returns false if no scope is open */
+    bool addToScopes(const std::string & msg, LogLevel level);
 };
 
 } // namespace rtt
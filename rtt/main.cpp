@@ -1,10 +1,16 @@
 #include <iostream>
 #include <stdexcept>
+#include <csignal>
+#include <thread>
+#include <mutex>
 
 #include "rtt/storage/istorage.h"
 #include "rtt/batteries/ibattery-batt.h"
+#include "rtt/batteries/testrunner-batt.h"
 #include "rtt/clinterface/rttclioptions.h"
 #include "rtt/globalcontainer.h"
+#include "rtt/batteryjob.h"
+#include "rtt/jobserver.h"
 #include "rtt/version.h"
 
 /* This line must stay in main! */
@@ -12,7 +18,71 @@ INITIALIZE_EASYLOGGINGPP
 
 using namespace rtt;
 
+/* Server of the toolkit in server mode, stopped by the signal handler */
+std::mutex server_mux;
+JobServer * server = nullptr;
+
+/* Receives termination signals in its own thread, other threads and the battery
+ * processes have them blocked. First signal stops the execution with the grace
+ * period from the settings, next one kills the running tests at once. */
+void handleTerminationSignals(sigset_t signals, Logger * logger, int graceSeconds) {
+    for(bool first = true ; ; first = false) {
+        int sig = 0;
+        if(sigwait(&signals, &sig) != 0)
+            return;
+        int grace = first ? graceSeconds : 0;
+        logger->warn("Toolkit: received signal " + std::string(strsignal(sig)) +
+                     ", execution is stopped. Running tests are killed in " +
+                     Utils::itostr(grace) + " s, completed tests are stored.");
+        batteries::TestRunner::stopExecution(grace);
+        std::lock_guard<std::mutex> l (server_mux);
+        if(server)
+            server->stop();
+    }
+}
+
+/* Writes checkpoint of the stopped run next to its log. Run is resumed by executing
+ * it again with the same arguments, completed tests are loaded from result cache. */
+void writeCheckpoint(const GlobalContainer & gc, int argc, char * argv[],
+                     const std::vector<BatteryJob> & jobs) {
+    Logger * logger = gc.getLogger();
+    std::string cacheDir = gc.getToolkitSettings()->getExecResultCacheDir();
+    json checkpoint;
+    checkpoint["arguments"] = std::vector<std::string>(argv + 1, argv + argc);
+    checkpoint["working-directory"] = Utils::getAbsolutePath(".");
+    checkpoint["result-cache-dir"] = cacheDir;
+    checkpoint["batteries"] = json::array();
+    for(const BatteryJob & job : jobs) {
+        json battery;
+        battery["battery"] = job.batteryArg.getShortName();
+        battery["input-file"] = job.dataPath;
+        battery["state"] = !job.battery ? "failed" :
+                           job.battery->isStoppedEarly() ? "partial" : "finished";
+        checkpoint["batteries"].push_back(battery);
+    }
+
+    std::string path = gc.getLogFilePath();
+    path = path.substr(0, path.rfind("-log.txt")) + "-checkpoint.json";
+    try {
+        Utils::saveStringToFile(path, checkpoint.dump(4));
+        logger->info("Toolkit: checkpoint of the stopped run was written to " + path +
+                     ", execute the toolkit with the same arguments to resume the run.");
+    } catch(std::exception & ex) {
+        logger->error("Toolkit: can't write checkpoint " + path + ": " + ex.what());
+    }
+    if(cacheDir.empty())
+        logger->warn("Toolkit: result cache is disabled, "
+                     "resumed run will execute all tests again.");
+}
+
 int main (int argc , char * argv[]) try {
+    /* Blocked before any thread is created, all threads inherit the mask */
+    sigset_t terminationSignals;
+    sigemptyset(&terminationSignals);
+    sigaddset(&terminationSignals, SIGINT);
+    sigaddset(&terminationSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &terminationSignals, nullptr);
+
     if(argc == 1 || (argc == 2 && (strcmp(argv[1], "-h") == 0 ||
                                    strcmp(argv[1], "--help") == 0))) {
         std::cout << clinterface::RTTCliOptions::getUsage() << std::endl;
@@ -35,38 +105,100 @@ int main (int argc , char * argv[]) try {
     /* Logger must be initialized last as it uses settings from main configuration file
      * and command line options. Otherwise exception is raised. */
     gc.initLogger("Randomness_Testing_Toolkit", true);
+    try {
+        gc.initShardQueue();
+    } catch(std::exception & ex) {
+        gc.getLogger()->error(ex.what());
+        return -1;
+    }
+    gc.initResultCache();
+    gc.initSharedInput();
 
     /* Logger is now created and all subsequent errors are logged. */
+    std::thread(handleTerminationSignals, terminationSignals, gc.getLogger(),
+                gc.getToolkitSettings()->getExecShutdownGrace()).detach();
+
+    /* Server executes jobs submitted through its socket until it fails or is stopped */
+    if(gc.getRttCliOptions()->isServeMode()) {
+        try {
+            auto jobServer = JobServer::getInstance(gc);
+            {
+                std::lock_guard<std::mutex> l (server_mux);
+                server = jobServer.get();
+            }
+            jobServer->run();
+            std::lock_guard<std::mutex> l (server_mux);
+            server = nullptr;
+        } catch(std::exception & ex) {
+            std::lock_guard<std::mutex> l (server_mux);
+            server = nullptr;
+            gc.getLogger()->error(ex.what());
+            return -1;
+        }
+        return 0;
+    }
+
+    /* Planned run creates the tests, nothing is executed or stored */
+    if(gc.getRttCliOptions()->isPlanMode()) {
+        try {
+            gc.initBatteriesConfiguration(gc.getRttCliOptions()->getInputCfgPath());
+            auto jobs = BatteryJob::createJobs(gc, nullptr);
+            std::string plan = BatteryJob::planJobs(jobs, gc.getLogger());
+            std::string planPath = gc.getRttCliOptions()->getPlanOutputPath();
+            if(planPath == "-") {
+                std::cout << plan;
+            } else {
+                Utils::saveStringToFile(planPath, plan);
+                gc.getLogger()->info("Toolkit: execution plan was written to " + planPath);
+            }
+        } catch(std::exception & ex) {
+            gc.getLogger()->error(ex.what());
+            return -1;
+        }
+        return 0;
+    }
 
     try {
-        /* Initializing storage */
-        auto storage = storage::IStorage::getInstance(gc);
-        storage->init();
+        /* Initializing storage, single storage is used for all batteries and files.
+         * Workers of sharded run don't store, coordinator stores results of all tests. */
+        std::unique_ptr<storage::IStorage> storage;
+        if(!gc.getRttCliOptions()->isShardMode() || gc.getRttCliOptions()->isShardCoordinator())
+            storage = storage::IStorage::getInstance(gc);
+        Logger * logger = gc.getLogger();
+        auto rttCliOptions = gc.getRttCliOptions();
+
+        /* Each chosen battery is executed on each input file */
+        auto jobs = BatteryJob::createJobs(gc, storage.get());
 
         try {
+            /* Generator is executed before the batteries are created,
+             * its output then replaces the input file. */
+            if(rttCliOptions->isGeneratorMode())
+                gc.getSharedInput()->addGeneratorOutput(rttCliOptions->getInputDataPath(),
+                                                        rttCliOptions->getGeneratorCommand());
+
             /* Initialization of battery configuration in container -
              * should something go wrong, the error is logged in storage */
-            gc.initBatteriesConfiguration(gc.getRttCliOptions()->getInputCfgPath());
-            /* Initialization of battery */
-            auto battery = batteries::IBattery::getInstance(gc);
-            /* Executing analysis */
-            battery->runTests();
-            /* Obtaining and storing results */
-            const auto & results = battery->getTestResults();;
-            storage->writeResults(Utils::getRawPtrs(results));
-            /* And we are done. */
+            gc.initBatteriesConfiguration(rttCliOptions->getInputCfgPath());
+
+            /* Executing analysis, tests of all batteries and files run in single pool.
+             * Results are stored as soon as the battery is finished. */
+            BatteryJob::executeJobs(jobs, logger);
 
         } catch(std::exception & ex) {
             /* Something happened during battery initialization/execution */
-            gc.getLogger()->error(ex.what());
+            logger->error(ex.what());
         }
 
-        /* Store warnings and errors into storage */
-        storage->addBatteryWarnings(gc.getLogger()->getWarningMessages());
-        storage->addBatteryErrors(gc.getLogger()->getErrorMessages());
-        /* Call to close storage is important -
-         * changes are commited, files saved, etc... */
-        storage->close();
+        /* Storing jobs that weren't executed */
+        BatteryJob::storeJobs(jobs, logger);
+
+        /* Stopped run can be resumed */
+        if(batteries::TestRunner::isStopped()) {
+            writeCheckpoint(gc, argc, argv, jobs);
+            return -1;
+        }
+        /* And we are done. */
 
     } catch(std::exception & ex) {
         /* Storage creation failed. */
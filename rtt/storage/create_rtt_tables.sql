@@ -32,6 +32,7 @@ CREATE TABLE IF NOT EXISTS batteries (
     passed_tests        BIGINT UNSIGNED NOT NULL,
     total_tests         BIGINT UNSIGNED NOT NULL,
     alpha               DOUBLE NOT NULL,
+    partial             BOOLEAN NOT NULL DEFAULT FALSE,
     experiment_id       BIGINT UNSIGNED NOT NULL,
     FOREIGN KEY (experiment_id) REFERENCES experiments(id) ON DELETE CASCADE ON UPDATE CASCADE
 ) ENGINE = INNODB;
@@ -63,6 +64,12 @@ CREATE TABLE IF NOT EXISTS tests (
 CREATE TABLE IF NOT EXISTS variants (
     id                  BIGINT UNSIGNED PRIMARY KEY NOT NULL AUTO_INCREMENT,
     variant_index       INT UNSIGNED NOT NULL,
+    wall_time           DOUBLE DEFAULT NULL,
+    user_time           DOUBLE DEFAULT NULL,
+    system_time         DOUBLE DEFAULT NULL,
+    max_rss_kib         BIGINT DEFAULT NULL,
+    read_bytes          BIGINT UNSIGNED DEFAULT NULL,
+    written_bytes       BIGINT UNSIGNED DEFAULT NULL,
     test_id             BIGINT UNSIGNED NOT NULL,
     FOREIGN KEY (test_id) REFERENCES tests(id) ON DELETE CASCADE ON UPDATE CASCADE
 ) ENGINE = INNODB;
@@ -126,3 +133,16 @@ CREATE TABLE IF NOT EXISTS p_values (
     subtest_id          BIGINT UNSIGNED NOT NULL,
     FOREIGN KEY (subtest_id) REFERENCES subtests(id) ON DELETE CASCADE ON UPDATE CASCADE
 ) ENGINE = INNODB;
+
+-- Resource usage columns of variants can be added to existing database by:
+-- ALTER TABLE variants
+--     ADD COLUMN wall_time DOUBLE DEFAULT NULL AFTER variant_index,
+--     ADD COLUMN user_time DOUBLE DEFAULT NULL AFTER wall_time,
+--     ADD COLUMN system_time DOUBLE DEFAULT NULL AFTER user_time,
+--     ADD COLUMN max_rss_kib BIGINT DEFAULT NULL AFTER system_time,
+--     ADD COLUMN read_bytes BIGINT UNSIGNED DEFAULT NULL AFTER max_rss_kib,
+--     ADD COLUMN written_bytes BIGINT UNSIGNED DEFAULT NULL AFTER read_bytes;
+
+-- Marking of partial results of batteries can be added to existing database by:
+-- ALTER TABLE batteries
+--     ADD COLUMN partial BOOLEAN NOT NULL DEFAULT FALSE AFTER alpha;
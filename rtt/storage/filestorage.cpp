@@ -16,26 +16,27 @@ std::unique_ptr<FileStorage> FileStorage::getInstance(const GlobalContainer & co
     s->rttCliOptions   = container.getRttCliOptions();
     s->toolkitSettings = container.getToolkitSettings();
     s->creationTime    = container.getCreationTime();
-    s->battery         = s->rttCliOptions->getBatteryArg();
-    s->inFilePath      = s->rttCliOptions->getInputDataPath();
 
     /* Getting file name for main output file */
     s->mainOutFilePath = s->toolkitSettings->getRsFileOutFile();
 
-    /* Creating file name for test report file */
-    auto binFileName = Utils::getLastItemInPath(s->inFilePath);
-    std::replace(binFileName.begin(), binFileName.end(), '.', '_');
-    auto datetime = Utils::formatRawTime(s->creationTime , "%Y%m%d%H%M%S");
-    s->outFilePath = s->toolkitSettings->getRsFileBatteryDir(s->battery);
-    s->outFilePath.append(datetime + "-" + binFileName + "-report.txt");
-
     return s;
 }
 
-void FileStorage::init() {
+void FileStorage::init(const BatteryArg & battery, const std::string & inputDataPath) {
     if(initialized)
         raiseBugException("storage was already initialized");
 
+    this->battery = battery;
+    inFilePath    = inputDataPath;
+
+    /* Creating file name for test report file */
+    auto binFileName = Utils::getLastItemInPath(inFilePath);
+    std::replace(binFileName.begin(), binFileName.end(), '.', '_');
+    auto datetime = Utils::formatRawTime(creationTime , "%Y%m%d%H%M%S");
+    outFilePath = toolkitSettings->getRsFileBatteryDir(battery);
+    outFilePath.append(datetime + "-" + binFileName + "-report.txt");
+
     initialized = true;
     makeReportHeader();
 }
@@ -60,6 +61,8 @@ void FileStorage::writeResults(const std::vector<batteries::ITestResult *> & tes
                 addVariant();
 
             setUserSettings(varRes.getUserSettings());
+            setResourceUsage(varRes.getBatteryOutput().getWallTime(),
+                             varRes.getBatteryOutput().getResourceUsage());
             setWarningMessages(varRes.getBatteryOutput().getWarnings());
             setErrorMessages(varRes.getBatteryOutput().getErrors());
             setStdErrMessages(Utils::split(varRes.getBatteryOutput().getStdErr(), '\n'));
@@ -110,9 +113,11 @@ void FileStorage::close() {
     passedTestsCount = 0;
     totalTestsCount = 0;
     passedTestProp = "";
+    partialResults = false;
     indent = 0;
     currSubtest = 0;
     currVariant = 0;
+    initialized = false;
 }
 
 void FileStorage::addBatteryError(const std::string & error) {
@@ -157,6 +162,10 @@ void FileStorage::addBatteryWarnings(const std::vector<std::string> & warnings)
     report.str(reportStr);
 }
 
+void FileStorage::setPartialResults() {
+    partialResults = true;
+}
+
 /*
                      __                       __
                     |  \                     |  \
@@ -238,6 +247,29 @@ void FileStorage::setUserSettings(
     report << std::endl;
 }
 
+void FileStorage::setResourceUsage(double wallTime,
+                                   const batteries::ResourceUsage & usage) {
+    /* Outputs loaded from result cache have no resource usage */
+    if(!usage.measured)
+        return;
+
+    report << doIndent() << "Resource usage: " << std::endl;
+    ++indent;
+    std::string spaces = doIndent();
+    std::stringstream tmp;
+    tmp << std::setprecision(3) << std::fixed;
+    tmp << spaces << "Wall time: " << wallTime << " s" << std::endl;
+    tmp << spaces << "CPU time: " << usage.userTime << " s user, "
+        << usage.systemTime << " s system" << std::endl;
+    tmp << spaces << "Max RSS: " << usage.maxRss << " KiB" << std::endl;
+    tmp << spaces << "I/O: " << usage.readBytes << " B read, "
+        << usage.writtenBytes << " B written" << std::endl;
+    report << tmp.str();
+    --indent;
+    report << doIndent() << "************" << std::endl;
+    report << std::endl;
+}
+
 void FileStorage::setTestParameters(
         const std::vector<std::pair<std::string, std::string>> & options) {
     if(options.empty())
@@ -328,6 +360,8 @@ void FileStorage::addPValues(const std::vector<double> & pvals , int precision)
 void FileStorage::finalizeReport() {
     /* Add passed tests proportion at the end of report */
     passedTestProp = { Utils::itostr(passedTestsCount) + "/" + Utils::itostr(totalTestsCount) };
+    if(partialResults)
+        passedTestProp.append(" (partial)");
     std::string reportStr = report.str();
     size_t pos = reportStr.find(STRING_PASSED_PROP);
     reportStr.insert(pos + STRING_PASSED_PROP.length(), passedTestProp);
@@ -22,7 +22,7 @@ class FileStorage : public IStorage {
 public:
     static std::unique_ptr<FileStorage> getInstance(const GlobalContainer & container);
 
-    void init();
+    void init(const BatteryArg & battery, const std::string & inputDataPath);
 
     void writeResults(const std::vector<batteries::ITestResult *> & testResults);
 
@@ -36,6 +36,8 @@ public:
 
     void addBatteryWarnings(const std::vector<std::string> & warnings);
 
+    void setPartialResults();
+
 private:
     /*
     =================
@@ -71,6 +73,7 @@ private:
     int passedTestsCount = 0;
     int totalTestsCount = 0;
     std::string passedTestProp;
+    bool partialResults = false;
     int indent = 0;
     int currSubtest = 0;
     int currVariant = 0;
@@ -101,6 +104,8 @@ private:
     void setUserSettings(
             const std::vector<std::pair<std::string, std::string>> & options);
 
+    void setResourceUsage(double wallTime, const batteries::ResourceUsage & usage);
+
     void setTestParameters(
             const std::vector<std::pair<std::string, std::string> > & options);
 
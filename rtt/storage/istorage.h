@@ -26,10 +26,14 @@ public:
     virtual ~IStorage() {}
 
     /**
-     * @brief init Initializes the object. This must be done before writing any results.
-     * If done multiple times on the same object, peviously written results may be discarded.
+     * @brief init Initializes the object for results of given battery. This must be done
+     * before writing any results. After close, the object can be initialized again,
+     * so results of multiple batteries can be stored with single storage object.
+     * @param battery Battery whose results will be written
+     * @param inputDataPath Path to the file that was analysed by the battery
      */
-    virtual void init() = 0;
+    virtual void init(const clinterface::BatteryArg & battery,
+                      const std::string & inputDataPath) = 0;
 
     /**
      * @brief writeResults Will write results into the storage.
@@ -66,6 +70,12 @@ public:
      * @param warnings
      */
     virtual void addBatteryWarnings(const std::vector<std::string> & warnings) = 0;
+
+    /**
+     * @brief setPartialResults Marks results of the battery as partial,
+     * e.g. when remaining tests were cancelled after too many failures.
+     */
+    virtual void setPartialResults() = 0;
 };
 
 } // namespace storage
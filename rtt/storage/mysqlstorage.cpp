@@ -4,20 +4,33 @@ namespace rtt {
 namespace storage {
 
 const std::string MySQLStorage::objectInfo = "MySQL Storage";
+std::vector<std::unique_ptr<sql::Connection>> MySQLStorage::idleConnections;
+bool MySQLStorage::keepIdleConnections = false;
+std::mutex MySQLStorage::idleConnections_mux;
 
 std::unique_ptr<MySQLStorage> MySQLStorage::getInstance(const GlobalContainer & container) {
     std::unique_ptr<MySQLStorage> s (new MySQLStorage());
     s->rttCliOptions    = container.getRttCliOptions();
     s->toolkitSettings  = container.getToolkitSettings();
     s->creationTime     = container.getCreationTime();
-    s->battery          = s->rttCliOptions->getBatteryArg();
 
     try {
+        s->driver = get_driver_instance();
+        {
+            std::lock_guard<std::mutex> l (idleConnections_mux);
+            while(!s->conn && !idleConnections.empty()) {
+                /* Database could have closed the connection meanwhile */
+                if(idleConnections.back()->isValid())
+                    s->conn = std::move(idleConnections.back());
+                idleConnections.pop_back();
+            }
+        }
+        if(s->conn)
+            return s;
+
         std::string dbAddress = s->toolkitSettings->getRsMysqlAddress();
         dbAddress.append(":");
         dbAddress.append(s->toolkitSettings->getRsMysqlPort());
-
-        s->driver = get_driver_instance();
         s->conn   = std::unique_ptr<sql::Connection>(
                         s->driver->connect(dbAddress,
                                            s->toolkitSettings->getRsMysqlUserName(),
@@ -35,10 +48,27 @@ std::unique_ptr<MySQLStorage> MySQLStorage::getInstance(const GlobalContainer &
     return s;
 }
 
-void MySQLStorage::init() {
+MySQLStorage::~MySQLStorage() {
+    /* Connection with uncommitted battery is closed, the battery is rolled back */
+    std::lock_guard<std::mutex> l (idleConnections_mux);
+    if(keepIdleConnections && conn && dbBatteryId == 0)
+        idleConnections.push_back(std::move(conn));
+}
+
+void MySQLStorage::keepConnections(bool keep) {
+    std::lock_guard<std::mutex> l (idleConnections_mux);
+    keepIdleConnections = keep;
+    if(!keep)
+        idleConnections.clear();
+}
+
+/* Database doesn't store path of the input data, experiment identifies it */
+void MySQLStorage::init(const BatteryArg & battery, const std::string &) {
     if(dbBatteryId > 0)
         raiseBugException("storage was already initialized");
 
+    this->battery = battery;
+
     std::unique_ptr<sql::PreparedStatement> insBattStmt(conn->prepareStatement(
         "INSERT INTO batteries(name, passed_tests, total_tests, alpha, experiment_id) "
         "VALUES (?,?,?,?,?)"
@@ -77,6 +107,8 @@ void MySQLStorage::writeResults(const std::vector<batteries::ITestResult *> & te
             setVariantWarnings(varRes.getBatteryOutput().getWarnings());
             setVariantErrors(varRes.getBatteryOutput().getErrors());
             setVariantStdErr(Utils::split(varRes.getBatteryOutput().getStdErr(), '\n'));
+            setVariantResourceUsage(varRes.getBatteryOutput().getWallTime(),
+                                    varRes.getBatteryOutput().getResourceUsage());
 
             const auto & subResults = varRes.getSubResults();
             for(const batteries::result::SubTestResult & subRes : subResults) {
@@ -116,6 +148,7 @@ void MySQLStorage::close() {
     currVariantIdx = 0;
     totalTestCount = 0;
     passedTestCount = 0;
+    partialResults = false;
 
     try {
         /* Final commit, will confirm whole transaction */
@@ -181,6 +214,10 @@ void MySQLStorage::addBatteryWarnings(const std::vector<std::string> & warnings)
     }
 }
 
+void MySQLStorage::setPartialResults() {
+    partialResults = true;
+}
+
 /*
                      __                       __
                     |  \                     |  \
@@ -438,6 +475,36 @@ void MySQLStorage::setVariantErrors(const std::vector<std::string> & errors) {
     }
 }
 
+void MySQLStorage::setVariantResourceUsage(double wallTime,
+                                           const batteries::ResourceUsage & usage) {
+    if(currDbVariantId <= 0)
+        raiseBugException("variant id not set");
+
+    /* Columns stay NULL for outputs loaded from result cache */
+    if(!usage.measured)
+        return;
+
+    try {
+        std::unique_ptr<sql::PreparedStatement> updVariantUsageStmt(conn->prepareStatement(
+            "UPDATE variants SET wall_time=?, user_time=?, system_time=?, "
+            "max_rss_kib=?, read_bytes=?, written_bytes=? WHERE id=?"
+        ));
+        updVariantUsageStmt->setDouble(1, wallTime);
+        updVariantUsageStmt->setDouble(2, usage.userTime);
+        updVariantUsageStmt->setDouble(3, usage.systemTime);
+        updVariantUsageStmt->setInt64(4, usage.maxRss);
+        updVariantUsageStmt->setUInt64(5, usage.readBytes);
+        updVariantUsageStmt->setUInt64(6, usage.writtenBytes);
+        updVariantUsageStmt->setUInt64(7, currDbVariantId);
+        updVariantUsageStmt->execute();
+
+    } catch(sql::SQLException & ex) {
+        if(conn)
+            conn->rollback();
+        throw RTTException(objectInfo, ex.what());
+    }
+}
+
 void MySQLStorage::setVariantStdErr(const std::vector<std::string> & stderr) {
     if(currDbVariantId <= 0)
         raiseBugException("variant id not set");
@@ -516,11 +583,12 @@ void MySQLStorage::finalizeReport() {
 
     try {
         std::unique_ptr<sql::PreparedStatement> updBattPassProp(conn->prepareStatement(
-            "UPDATE batteries SET passed_tests=?, total_tests=? WHERE id=?"
+            "UPDATE batteries SET passed_tests=?, total_tests=?, partial=? WHERE id=?"
         ));
         updBattPassProp->setUInt64(1, passedTestCount);
         updBattPassProp->setUInt64(2, totalTestCount);
-        updBattPassProp->setUInt64(3, dbBatteryId);
+        updBattPassProp->setBoolean(3, partialResults);
+        updBattPassProp->setUInt64(4, dbBatteryId);
         updBattPassProp->execute();
 
     } catch(sql::SQLException & ex) {
@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <cstdint>
+#include <mutex>
+#include <vector>
 #include <cppconn/driver.h>
 #include <cppconn/exception.h>
 #include <cppconn/prepared_statement.h>
@@ -20,7 +22,17 @@ class MySQLStorage : public IStorage {
 public:
     static std::unique_ptr<MySQLStorage> getInstance(const GlobalContainer & container);
 
-    void init();
+    ~MySQLStorage();
+
+    /**
+     * @brief keepConnections When enabled, connections of destroyed storages stay
+     * open and are reused by storages created later, so that the server doesn't
+     * connect to the database for each job. Disabling closes kept connections.
+     * @param keep
+     */
+    static void keepConnections(bool keep);
+
+    void init(const BatteryArg & battery, const std::string & inputDataPath);
 
     void writeResults(const std::vector<batteries::ITestResult *> & testResults);
 
@@ -34,6 +46,8 @@ public:
 
     void addBatteryWarnings(const std::vector<std::string> & warnings);
 
+    void setPartialResults();
+
 private:
     /*
     =================
@@ -41,6 +55,10 @@ private:
     =================
     */
     static const std::string objectInfo;
+    /* Open connections of destroyed storages */
+    static std::vector<std::unique_ptr<sql::Connection>> idleConnections;
+    static bool keepIdleConnections;
+    static std::mutex idleConnections_mux;
     /* Pointers to global objects */
     RTTCliOptions * rttCliOptions;
     ToolkitSettings * toolkitSettings;
@@ -59,6 +77,7 @@ private:
     int currVariantIdx = 0;
     int totalTestCount = 0;
     int passedTestCount = 0;
+    bool partialResults = false;
 
     /*
     ===============
@@ -92,6 +111,8 @@ private:
 
     void setVariantStdErr(const std::vector<std::string> & stderr);
 
+    void setVariantResourceUsage(double wallTime, const batteries::ResourceUsage & usage);
+
     void addStatisticResult(
             const std::string & statName ,
             double value, bool passed);
@@ -1,5 +1,9 @@
 #include "toolkitsettings.h"
 
+#include "rtt/batteries/sharedinput-batt.h"
+#include "rtt/batteries/testrunner-batt.h"
+#include "rtt/batteries/cpupinning-batt.h"
+
 namespace rtt {
 
 const std::string ToolkitSettings::objectInfo = "Toolkit Settings";
@@ -40,12 +44,35 @@ const std::string ToolkitSettings::JSON_BINARIES                     = ToolkitSe
 const std::string ToolkitSettings::JSON_BINARIES_NIST                = ToolkitSettings::JSON_BINARIES + "/nist-sts";
 const std::string ToolkitSettings::JSON_BINARIES_DH                  = ToolkitSettings::JSON_BINARIES + "/dieharder";
 const std::string ToolkitSettings::JSON_BINARIES_TU01                = ToolkitSettings::JSON_BINARIES + "/testu01";
+const std::string ToolkitSettings::JSON_OUTPUT_PATTERNS              = ToolkitSettings::JSON_ROOT + "/output-patterns";
+const std::string ToolkitSettings::JSON_OUTPUT_PATTERNS_NIST         = ToolkitSettings::JSON_OUTPUT_PATTERNS + "/nist-sts";
+const std::string ToolkitSettings::JSON_OUTPUT_PATTERNS_DH           = ToolkitSettings::JSON_OUTPUT_PATTERNS + "/dieharder";
+const std::string ToolkitSettings::JSON_OUTPUT_PATTERNS_TU01         = ToolkitSettings::JSON_OUTPUT_PATTERNS + "/testu01";
+const std::string ToolkitSettings::JSON_OUTPUT_PATTERNS_ERRORS       = "errors";
+const std::string ToolkitSettings::JSON_OUTPUT_PATTERNS_WARNINGS     = "warnings";
 const std::string ToolkitSettings::JSON_MISC                         = ToolkitSettings::JSON_ROOT + "/miscellaneous";
 const std::string ToolkitSettings::JSON_MISC_NIST                    = ToolkitSettings::JSON_MISC + "/nist-sts";
 const std::string ToolkitSettings::JSON_MISC_NIST_MAIN_RES_DIR       = ToolkitSettings::JSON_MISC_NIST + "/main-result-dir";
+const std::string ToolkitSettings::JSON_MISC_NIST_SCRATCH_DIR        = ToolkitSettings::JSON_MISC_NIST + "/scratch-dir";
 const std::string ToolkitSettings::JSON_EXEC                         = ToolkitSettings::JSON_ROOT + "/execution";
 const std::string ToolkitSettings::JSON_EXEC_MAX_PAR_TESTS           = ToolkitSettings::JSON_EXEC + "/max-parallel-tests";
 const std::string ToolkitSettings::JSON_EXEC_TEST_TIMEOUT            = ToolkitSettings::JSON_EXEC + "/test-timeout-seconds";
+const std::string ToolkitSettings::JSON_EXEC_RUNTIME_HISTORY         = ToolkitSettings::JSON_EXEC + "/runtime-history-file";
+const std::string ToolkitSettings::JSON_EXEC_RESULT_CACHE_DIR        = ToolkitSettings::JSON_EXEC + "/result-cache-dir";
+const std::string ToolkitSettings::JSON_EXEC_SHARED_INPUT            = ToolkitSettings::JSON_EXEC + "/shared-input";
+const std::string ToolkitSettings::JSON_EXEC_SHARED_INPUT_MAX_FILES  = ToolkitSettings::JSON_EXEC + "/shared-input-max-files";
+const std::string ToolkitSettings::JSON_EXEC_MEMORY_BUDGET           = ToolkitSettings::JSON_EXEC + "/memory-budget-mb";
+const std::string ToolkitSettings::JSON_EXEC_DEFAULT_PEAK_MEMORY     = ToolkitSettings::JSON_EXEC + "/default-peak-memory-mb";
+const std::string ToolkitSettings::JSON_EXEC_CHILD_MEMORY_LIMIT      = ToolkitSettings::JSON_EXEC + "/child-memory-limit";
+const std::string ToolkitSettings::JSON_EXEC_CGROUP_DIR              = ToolkitSettings::JSON_EXEC + "/cgroup-dir";
+const std::string ToolkitSettings::JSON_EXEC_CPU_PINNING             = ToolkitSettings::JSON_EXEC + "/cpu-pinning";
+const std::string ToolkitSettings::JSON_EXEC_SHUTDOWN_GRACE          = ToolkitSettings::JSON_EXEC + "/shutdown-grace-seconds";
+const std::string ToolkitSettings::JSON_EXEC_TRACE_DIR               = ToolkitSettings::JSON_EXEC + "/trace-dir";
+const std::string ToolkitSettings::JSON_EXEC_ADAPTIVE_TIMEOUT_FACTOR = ToolkitSettings::JSON_EXEC + "/adaptive-timeout-factor";
+const std::string ToolkitSettings::JSON_EXEC_ADAPTIVE_TIMEOUT_MIN    = ToolkitSettings::JSON_EXEC + "/adaptive-timeout-min-seconds";
+const std::string ToolkitSettings::JSON_EXEC_SCRATCH_DIR             = ToolkitSettings::JSON_EXEC + "/scratch-dir";
+const std::string ToolkitSettings::JSON_EXEC_OUTPUT_SPILL            = ToolkitSettings::JSON_EXEC + "/output-spill-kb";
+const std::string ToolkitSettings::JSON_EXEC_GENERATOR_MAX           = ToolkitSettings::JSON_EXEC + "/generator-max-mb";
 
 
 
@@ -133,6 +160,16 @@ ToolkitSettings ToolkitSettings::getInstance(const std::string & cfgFileName) {
     if(!Utils::fileExist(ts.binaryTestU01))
         throw RTTException(ts.objectInfo, Strings::ERR_FILE_OPEN_FAIL + ts.binaryTestU01);
 
+    /*** Patterns of errors and warnings in battery output - not mandatory ***/
+    {
+        json nPatterns;
+        if(nRoot.count(Utils::getLastItemInPath(JSON_OUTPUT_PATTERNS)) == 1)
+            nPatterns = nRoot.at(Utils::getLastItemInPath(JSON_OUTPUT_PATTERNS));
+        ts.outputScannerDieharder   = ts.parseOutputScanner(nPatterns , JSON_OUTPUT_PATTERNS_DH);
+        ts.outputScannerNiststs     = ts.parseOutputScanner(nPatterns , JSON_OUTPUT_PATTERNS_NIST);
+        ts.outputScannerTestU01     = ts.parseOutputScanner(nPatterns , JSON_OUTPUT_PATTERNS_TU01);
+    }
+
     /*** Miscelaneous variables ***/
     if(nRoot.count(Utils::getLastItemInPath(JSON_MISC)) != 1)
         throw RTTException(objectInfo ,
@@ -146,6 +183,10 @@ ToolkitSettings ToolkitSettings::getInstance(const std::string & cfgFileName) {
         {
             json nMiscNist              = nMisc.at(Utils::getLastItemInPath(JSON_MISC_NIST));
             ts.miscNiststsMainResDir    = ts.parseDirectoryPath(nMiscNist , JSON_MISC_NIST_MAIN_RES_DIR);
+            ts.miscNiststsScratchDir    = ts.parseDirectoryPath(nMiscNist , JSON_MISC_NIST_SCRATCH_DIR, false);
+            /* Working directories are kept in memory when possible */
+            if(ts.miscNiststsScratchDir.empty())
+                ts.miscNiststsScratchDir = Utils::isDirectory("/dev/shm") ? "/dev/shm/" : "/tmp/";
         }
     }
 
@@ -158,6 +199,94 @@ ToolkitSettings ToolkitSettings::getInstance(const std::string & cfgFileName) {
         json nExec = nRoot.at(Utils::getLastItemInPath(JSON_EXEC));
         ts.execMaximumThreads = ts.parseIntegerValue(nExec , JSON_EXEC_MAX_PAR_TESTS);
         ts.execTestTimeout = ts.parseIntegerValue(nExec, JSON_EXEC_TEST_TIMEOUT);
+        ts.execRuntimeHistoryFile = ts.parseStringValue(nExec, JSON_EXEC_RUNTIME_HISTORY, false);
+        ts.execResultCacheDir     = ts.parseDirectoryPath(nExec, JSON_EXEC_RESULT_CACHE_DIR, false);
+        ts.execSharedInput        = ts.parseStringValue(nExec, JSON_EXEC_SHARED_INPUT, false);
+        if(ts.execSharedInput.empty())
+            ts.execSharedInput = batteries::SharedInput::MODE_NONE;
+        if(ts.execSharedInput != batteries::SharedInput::MODE_NONE &&
+           ts.execSharedInput != batteries::SharedInput::MODE_PREWARM &&
+           ts.execSharedInput != batteries::SharedInput::MODE_MEMFD)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("unknown shared input mode",
+                                                         JSON_EXEC_SHARED_INPUT));
+        ts.execSharedInputMaxFiles = ts.parseIntegerValue(nExec, JSON_EXEC_SHARED_INPUT_MAX_FILES, false);
+        if(ts.execSharedInputMaxFiles < 0)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("negative number of shared input files",
+                                                         JSON_EXEC_SHARED_INPUT_MAX_FILES));
+        if(ts.execSharedInputMaxFiles == 0)
+            ts.execSharedInputMaxFiles = batteries::SharedInput::DEFAULT_MAX_FILES;
+        ts.execMemoryBudget       = ts.parseIntegerValue(nExec, JSON_EXEC_MEMORY_BUDGET, false);
+        if(ts.execMemoryBudget < 0)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("negative memory budget",
+                                                         JSON_EXEC_MEMORY_BUDGET));
+        ts.execDefaultPeakMemory  = ts.parseIntegerValue(nExec, JSON_EXEC_DEFAULT_PEAK_MEMORY, false);
+        if(ts.execDefaultPeakMemory < 0)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("negative default peak memory",
+                                                         JSON_EXEC_DEFAULT_PEAK_MEMORY));
+        ts.execChildMemoryLimit   = ts.parseStringValue(nExec, JSON_EXEC_CHILD_MEMORY_LIMIT, false);
+        if(ts.execChildMemoryLimit.empty())
+            ts.execChildMemoryLimit = batteries::TestRunner::MEMORY_LIMIT_NONE;
+        if(ts.execChildMemoryLimit != batteries::TestRunner::MEMORY_LIMIT_NONE &&
+           ts.execChildMemoryLimit != batteries::TestRunner::MEMORY_LIMIT_RLIMIT &&
+           ts.execChildMemoryLimit != batteries::TestRunner::MEMORY_LIMIT_CGROUP)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("unknown child memory limit",
+                                                         JSON_EXEC_CHILD_MEMORY_LIMIT));
+        ts.execCgroupDir          = ts.parseDirectoryPath(nExec, JSON_EXEC_CGROUP_DIR, false);
+        /* Processes are confined to the memory budget */
+        if(ts.execChildMemoryLimit != batteries::TestRunner::MEMORY_LIMIT_NONE &&
+           ts.execMemoryBudget == 0)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("child memory limit requires memory budget",
+                                                         JSON_EXEC_CHILD_MEMORY_LIMIT));
+        if(ts.execChildMemoryLimit == batteries::TestRunner::MEMORY_LIMIT_CGROUP &&
+           ts.execCgroupDir.empty())
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("cgroup memory limit requires cgroup directory",
+                                                         JSON_EXEC_CGROUP_DIR));
+        ts.execCpuPinning         = ts.parseStringValue(nExec, JSON_EXEC_CPU_PINNING, false);
+        if(ts.execCpuPinning.empty())
+            ts.execCpuPinning = batteries::CpuPinning::POLICY_NONE;
+        if(!batteries::CpuPinning::isValidPolicy(ts.execCpuPinning))
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("unknown CPU pinning policy",
+                                                         JSON_EXEC_CPU_PINNING));
+        ts.execShutdownGrace      = ts.parseIntegerValue(nExec, JSON_EXEC_SHUTDOWN_GRACE, false);
+        if(ts.execShutdownGrace < 0)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("negative shutdown grace period",
+                                                         JSON_EXEC_SHUTDOWN_GRACE));
+        ts.execTraceDir           = ts.parseDirectoryPath(nExec, JSON_EXEC_TRACE_DIR, false);
+        ts.execAdaptiveTimeoutFactor  = ts.parseIntegerValue(nExec, JSON_EXEC_ADAPTIVE_TIMEOUT_FACTOR, false);
+        if(ts.execAdaptiveTimeoutFactor < 0)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("negative adaptive timeout factor",
+                                                         JSON_EXEC_ADAPTIVE_TIMEOUT_FACTOR));
+        ts.execAdaptiveTimeoutMinimum = ts.parseIntegerValue(nExec, JSON_EXEC_ADAPTIVE_TIMEOUT_MIN, false);
+        if(ts.execAdaptiveTimeoutMinimum < 0)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("negative adaptive timeout minimum",
+                                                         JSON_EXEC_ADAPTIVE_TIMEOUT_MIN));
+        /* Spilled data are meant to leave the memory, so tmpfs is not preferred */
+        ts.execScratchDir         = ts.parseDirectoryPath(nExec, JSON_EXEC_SCRATCH_DIR, false);
+        if(ts.execScratchDir.empty())
+            ts.execScratchDir = "/tmp/";
+        ts.execOutputSpill        = ts.parseIntegerValue(nExec, JSON_EXEC_OUTPUT_SPILL, false);
+        if(ts.execOutputSpill < 0)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("negative output spill size",
+                                                         JSON_EXEC_OUTPUT_SPILL));
+        if(ts.execOutputSpill == 0)
+            ts.execOutputSpill = batteries::BatteryOutput::DEFAULT_SPILL_KIB;
+        ts.execGeneratorMax       = ts.parseIntegerValue(nExec, JSON_EXEC_GENERATOR_MAX, false);
+        if(ts.execGeneratorMax < 0)
+            throw RTTException(objectInfo ,
+                               ts.getParsingErrorMessage("negative maximum generator output",
+                                                         JSON_EXEC_GENERATOR_MAX));
     }
 
     return ts;
@@ -183,10 +312,32 @@ std::string ToolkitSettings::getBinaryBattery(const BatteryArg &battery) const {
     return getBatteryVariable(VariableType::binary , battery);
 }
 
+std::shared_ptr<const batteries::OutputScanner> ToolkitSettings::getOutputScanner(
+        const BatteryArg & battery) const {
+    switch(battery.getBatteryId()) {
+    case Constants::BatteryID::NIST_STS:
+        return outputScannerNiststs;
+    case Constants::BatteryID::DIEHARDER:
+        return outputScannerDieharder;
+    case Constants::BatteryID::TU01_SMALLCRUSH:
+    case Constants::BatteryID::TU01_CRUSH:
+    case Constants::BatteryID::TU01_BIGCRUSH:
+    case Constants::BatteryID::TU01_RABBIT:
+    case Constants::BatteryID::TU01_ALPHABIT:
+    case Constants::BatteryID::TU01_BLOCK_ALPHABIT:
+        return outputScannerTestU01;
+    default:raiseBugException("invalid battery");
+    }
+}
+
 std::string ToolkitSettings::getMiscNiststsMainResDir() const {
     return miscNiststsMainResDir;
 }
 
+std::string ToolkitSettings::getMiscNiststsScratchDir() const {
+    return miscNiststsScratchDir;
+}
+
 int ToolkitSettings::getExecMaximumThreads() const {
     return execMaximumThreads;
 }
@@ -207,6 +358,70 @@ int ToolkitSettings::getExecTestTimeout() const {
     return execTestTimeout;
 }
 
+std::string ToolkitSettings::getExecRuntimeHistoryFile() const {
+    return execRuntimeHistoryFile;
+}
+
+std::string ToolkitSettings::getExecResultCacheDir() const {
+    return execResultCacheDir;
+}
+
+std::string ToolkitSettings::getExecSharedInput() const {
+    return execSharedInput;
+}
+
+int ToolkitSettings::getExecSharedInputMaxFiles() const {
+    return execSharedInputMaxFiles;
+}
+
+int ToolkitSettings::getExecShutdownGrace() const {
+    return execShutdownGrace;
+}
+
+std::string ToolkitSettings::getExecTraceDir() const {
+    return execTraceDir;
+}
+
+int ToolkitSettings::getExecAdaptiveTimeoutFactor() const {
+    return execAdaptiveTimeoutFactor;
+}
+
+int ToolkitSettings::getExecAdaptiveTimeoutMinimum() const {
+    return execAdaptiveTimeoutMinimum;
+}
+
+std::string ToolkitSettings::getExecScratchDir() const {
+    return execScratchDir;
+}
+
+int ToolkitSettings::getExecOutputSpill() const {
+    return execOutputSpill;
+}
+
+int ToolkitSettings::getExecGeneratorMax() const {
+    return execGeneratorMax;
+}
+
+int ToolkitSettings::getExecMemoryBudget() const {
+    return execMemoryBudget;
+}
+
+int ToolkitSettings::getExecDefaultPeakMemory() const {
+    return execDefaultPeakMemory;
+}
+
+std::string ToolkitSettings::getExecChildMemoryLimit() const {
+    return execChildMemoryLimit;
+}
+
+std::string ToolkitSettings::getExecCgroupDir() const {
+    return execCgroupDir;
+}
+
+std::string ToolkitSettings::getExecCpuPinning() const {
+    return execCpuPinning;
+}
+
 std::string ToolkitSettings::getRsMysqlUserName() const {
     return getTagFromCredentials(JSON_RS_MYSQL_DB_CRED_FILE_NAME);
 }
@@ -364,6 +579,39 @@ int ToolkitSettings::parseIntegerValue(const json & parenttag,
     }
 }
 
+std::vector<std::string> ToolkitSettings::parseStringArray(const json & parenttag,
+                                                           const std::string & childTagPath) const {
+    try {
+        auto childTagName = Utils::getLastItemInPath(childTagPath);
+        if(parenttag.count(childTagName) != 1)
+            return {};
+
+        return parenttag.at(childTagName).get<std::vector<std::string>>();
+    } catch (std::domain_error ex) {
+        throw RTTException(objectInfo,
+                           getParsingErrorMessage(ex.what(), childTagPath));
+    }
+}
+
+std::shared_ptr<const batteries::OutputScanner> ToolkitSettings::parseOutputScanner(
+        const json & parenttag, const std::string & childTagPath) const {
+    /* Scanner without additional patterns is shared */
+    auto childTagName = Utils::getLastItemInPath(childTagPath);
+    if(!parenttag.is_object() || parenttag.count(childTagName) != 1)
+        return batteries::OutputScanner::getDefault();
+
+    json nBattery = parenttag.at(childTagName);
+    if(!nBattery.is_object())
+        throw RTTException(objectInfo, getParsingErrorMessage("tag must be object", childTagPath));
+    auto errors = parseStringArray(nBattery, childTagPath + "/" + JSON_OUTPUT_PATTERNS_ERRORS);
+    auto warnings = parseStringArray(nBattery, childTagPath + "/" + JSON_OUTPUT_PATTERNS_WARNINGS);
+    try {
+        return batteries::OutputScanner::getInstance(errors, warnings);
+    } catch (RTTException & ex) {
+        throw RTTException(objectInfo, getParsingErrorMessage(ex.what(), childTagPath));
+    }
+}
+
 std::string ToolkitSettings::getTagFromCredentials(const std::string & tagPath) const {
     if(rsMysqlCredentialsFile.empty())
         throw RTTException(objectInfo, getParsingErrorMessage(
@@ -5,6 +5,7 @@
 #include "rtt/bugexception.h"
 #include "rtt/rttexception.h"
 #include "rtt/clinterface/batteryarg.h"
+#include "rtt/batteries/outputscanner-batt.h"
 
 #include "libs/moderncppjson/json.hpp"
 
@@ -55,12 +56,28 @@ public:
      */
     std::string getBinaryBattery(const BatteryArg & battery) const;
 
+    /**
+     * @brief getOutputScanner
+     * @param battery
+     * @return Scanner of errors and warnings in the output of a given battery,
+     * it detects patterns set for the battery besides "error" and "warning"
+     */
+    std::shared_ptr<const batteries::OutputScanner> getOutputScanner(
+            const BatteryArg & battery) const;
+
     /**
      * @brief getMiscNiststsMainResDir
      * @return Path to NIST STS main result directory
      */
     std::string getMiscNiststsMainResDir() const;
 
+    /**
+     * @brief getMiscNiststsScratchDir
+     * @return Path to directory in which private working
+     * directories of NIST STS processes are created
+     */
+    std::string getMiscNiststsScratchDir() const;
+
     /**
      * @brief getRsMysqlAddress
      * @return IPv4 address of MySQL database (MysqlStorage)
@@ -103,6 +120,118 @@ public:
      */
     int getExecMaximumThreads() const;
 
+    /**
+     * @brief getExecRuntimeHistoryFile
+     * @return Path to file with runtime history of the tests, empty if not set
+     */
+    std::string getExecRuntimeHistoryFile() const;
+
+    /**
+     * @brief getExecResultCacheDir
+     * @return Path to directory with cached outputs of executed
+     * variants, empty if caching is disabled. Cached outputs replace execution
+     * of the same variants on the same data in all later runs, they don't expire
+     * and size of the directory is not limited.
+     */
+    std::string getExecResultCacheDir() const;
+
+    /**
+     * @brief getExecSharedInput
+     * @return Mode of sharing of input data between battery processes,
+     * one of the SharedInput modes
+     */
+    std::string getExecSharedInput() const;
+
+    /**
+     * @brief getExecSharedInputMaxFiles
+     * @return Maximum number of input files kept in memory at once in memfd mode
+     */
+    int getExecSharedInputMaxFiles() const;
+
+    /**
+     * @brief getExecMemoryBudget
+     * @return Memory in MiB that can be used by all parallel running
+     * tests together, 0 if not limited
+     */
+    int getExecMemoryBudget() const;
+
+    /**
+     * @brief getExecDefaultPeakMemory
+     * @return Peak memory in MiB assumed for tests without history,
+     * 0 if they are assumed to need none
+     */
+    int getExecDefaultPeakMemory() const;
+
+    /**
+     * @brief getExecChildMemoryLimit
+     * @return How the memory of single test process is confined,
+     * one of the TestRunner memory limit modes
+     */
+    std::string getExecChildMemoryLimit() const;
+
+    /**
+     * @brief getExecCgroupDir
+     * @return Path to cgroup v2 directory delegated to the toolkit, test
+     * processes are placed into its subgroups. Empty if not set.
+     */
+    std::string getExecCgroupDir() const;
+
+    /**
+     * @brief getExecCpuPinning
+     * @return Policy of binding test processes to CPUs, one of
+     * the CpuPinning policies or list of CPUs
+     */
+    std::string getExecCpuPinning() const;
+
+    /**
+     * @brief getExecShutdownGrace
+     * @return Seconds given to running test processes to finish after
+     * the toolkit received termination signal, 0 if they are killed at once
+     */
+    int getExecShutdownGrace() const;
+
+    /**
+     * @brief getExecTraceDir
+     * @return Path to directory where timeline of each execution of tests
+     * is written in Chrome trace event format, empty if not traced
+     */
+    std::string getExecTraceDir() const;
+
+    /**
+     * @brief getExecAdaptiveTimeoutFactor
+     * @return Multiple of measured runtime after which a test without configured
+     * timeout is killed, 0 if the test timeout is used for all such tests. Tests
+     * never measured with the same settings and input size get the test timeout.
+     */
+    int getExecAdaptiveTimeoutFactor() const;
+
+    /**
+     * @brief getExecAdaptiveTimeoutMinimum
+     * @return Shortest adaptive timeout in seconds
+     */
+    int getExecAdaptiveTimeoutMinimum() const;
+
+    /**
+     * @brief getExecScratchDir
+     * @return Path to directory for temporary files of the execution,
+     * e.g. spilled standard output of tests. Files are unlinked at creation.
+     */
+    std::string getExecScratchDir() const;
+
+    /**
+     * @brief getExecOutputSpill
+     * @return Size in KiB of standard output of single test kept in memory,
+     * larger output is moved into file in the scratch directory
+     */
+    int getExecOutputSpill() const;
+
+    /**
+     * @brief getExecGeneratorMax
+     * @return Maximum size in MiB of output of generator command,
+     * 0 if not limited
+     */
+    int getExecGeneratorMax() const;
+
 private:
     /* JSON tag names constants */
     static const std::string JSON_ROOT;
@@ -141,12 +270,35 @@ private:
     static const std::string JSON_BINARIES_NIST;
     static const std::string JSON_BINARIES_DH;
     static const std::string JSON_BINARIES_TU01;
+    static const std::string JSON_OUTPUT_PATTERNS;
+    static const std::string JSON_OUTPUT_PATTERNS_NIST;
+    static const std::string JSON_OUTPUT_PATTERNS_DH;
+    static const std::string JSON_OUTPUT_PATTERNS_TU01;
+    static const std::string JSON_OUTPUT_PATTERNS_ERRORS;
+    static const std::string JSON_OUTPUT_PATTERNS_WARNINGS;
     static const std::string JSON_MISC;
     static const std::string JSON_MISC_NIST;
     static const std::string JSON_MISC_NIST_MAIN_RES_DIR;
+    static const std::string JSON_MISC_NIST_SCRATCH_DIR;
     static const std::string JSON_EXEC;
     static const std::string JSON_EXEC_MAX_PAR_TESTS;
     static const std::string JSON_EXEC_TEST_TIMEOUT;
+    static const std::string JSON_EXEC_RUNTIME_HISTORY;
+    static const std::string JSON_EXEC_RESULT_CACHE_DIR;
+    static const std::string JSON_EXEC_SHARED_INPUT;
+    static const std::string JSON_EXEC_SHARED_INPUT_MAX_FILES;
+    static const std::string JSON_EXEC_MEMORY_BUDGET;
+    static const std::string JSON_EXEC_DEFAULT_PEAK_MEMORY;
+    static const std::string JSON_EXEC_CHILD_MEMORY_LIMIT;
+    static const std::string JSON_EXEC_CGROUP_DIR;
+    static const std::string JSON_EXEC_CPU_PINNING;
+    static const std::string JSON_EXEC_SHUTDOWN_GRACE;
+    static const std::string JSON_EXEC_TRACE_DIR;
+    static const std::string JSON_EXEC_ADAPTIVE_TIMEOUT_FACTOR;
+    static const std::string JSON_EXEC_ADAPTIVE_TIMEOUT_MIN;
+    static const std::string JSON_EXEC_SCRATCH_DIR;
+    static const std::string JSON_EXEC_OUTPUT_SPILL;
+    static const std::string JSON_EXEC_GENERATOR_MAX;
 
     /* Variable types for getters. Should a new variable be added,
      * add it here too. */
@@ -190,10 +342,31 @@ private:
     std::string binaryNiststs;
     std::string binaryTestU01;
 
+    std::shared_ptr<const batteries::OutputScanner> outputScannerDieharder;
+    std::shared_ptr<const batteries::OutputScanner> outputScannerNiststs;
+    std::shared_ptr<const batteries::OutputScanner> outputScannerTestU01;
+
     std::string miscNiststsMainResDir;
+    std::string miscNiststsScratchDir;
 
     int execMaximumThreads;
     int execTestTimeout;
+    std::string execRuntimeHistoryFile;
+    std::string execResultCacheDir;
+    std::string execSharedInput;
+    int execSharedInputMaxFiles;
+    int execMemoryBudget;
+    int execDefaultPeakMemory;
+    std::string execChildMemoryLimit;
+    std::string execCgroupDir;
+    std::string execCpuPinning;
+    int execShutdownGrace;
+    std::string execTraceDir;
+    int execAdaptiveTimeoutFactor;
+    int execAdaptiveTimeoutMinimum;
+    std::string execScratchDir;
+    int execOutputSpill;
+    int execGeneratorMax;
 
     /* Private methods */
     ToolkitSettings() {}
@@ -213,6 +386,12 @@ private:
                           const std::string & childTagName,
                           bool mandatory = true) const;
 
+    std::vector<std::string> parseStringArray(const json & parentNode,
+                                              const std::string & childTagName) const;
+
+    std::shared_ptr<const batteries::OutputScanner> parseOutputScanner(
+            const json & parentNode, const std::string & childTagName) const;
+
     std::string getTagFromCredentials(const std::string & tagPath) const;
 
     std::string returnIfNonEmpty(const std::string & value,
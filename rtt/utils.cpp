@@ -1,7 +1,69 @@
 #include "rtt/utils.h"
 
+#include <cmath>
+
 namespace rtt {
 
+namespace {
+
+/* Two independent 64-bit lanes over 8-byte words, finalized with
+ * avalanche mix. Used for content addressing, not for security. */
+class ContentHash {
+public:
+    void update(const char * data, size_t length) {
+        totalLength += length;
+        while(length > 0) {
+            size_t n = std::min(length, sizeof(uint64_t) - pendingLength);
+            memcpy(pending + pendingLength, data, n);
+            pendingLength += n;
+            data += n;
+            length -= n;
+            if(pendingLength == sizeof(uint64_t)) {
+                uint64_t word;
+                memcpy(&word, pending, sizeof(word));
+                addWord(word);
+                pendingLength = 0;
+            }
+        }
+    }
+
+    std::string digest() {
+        uint64_t word = 0;
+        memcpy(&word, pending, pendingLength);
+        addWord(word ^ (static_cast<uint64_t>(pendingLength) << 56));
+        std::stringstream rval;
+        rval << std::hex << std::setfill('0')
+             << std::setw(16) << mix(lane1 ^ totalLength)
+             << std::setw(16) << mix(lane2 + totalLength);
+        return rval.str();
+    }
+
+private:
+    uint64_t lane1 = 0xcbf29ce484222325ULL;
+    uint64_t lane2 = 0x9e3779b97f4a7c15ULL;
+    uint64_t totalLength = 0;
+    char pending[sizeof(uint64_t)];
+    size_t pendingLength = 0;
+
+    void addWord(uint64_t word) {
+        lane1 = (lane1 ^ word) * 0x100000001b3ULL;
+        lane1 ^= lane1 >> 29;
+        lane2 += word * 0xc2b2ae3d27d4eb4fULL;
+        lane2 = ((lane2 << 31) | (lane2 >> 33)) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+} // namespace
+
 std::string Utils::itostr(int i , int width) {
     std::stringstream ss;
     ss.width(width);
@@ -43,18 +105,70 @@ float Utils::strtof(const std::string & str) {
 }
 
 double Utils::strtod(const std::string & str) {
-    static const std::regex RE_FLOAT { "^-?[0-9]+?(:?\\.[0-9]+?)?$" };
-    if(!std::regex_match(str.begin() , str.end() , RE_FLOAT)) {
-        throw std::runtime_error("can't convert string \"" + str + "\" into double: " +
-                                 "string contain invalid characters");
+    return strtod(str.data(), str.data() + str.size());
+}
+
+double Utils::strtod(const char * begin, const char * end) {
+    /* Powers of ten that are exact in double */
+    static const double POWERS_OF_TEN[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const std::uint64_t MAX_EXACT_MANTISSA = std::uint64_t(1) << 53;
+
+    const char * it = begin;
+    bool negative = it != end && *it == '-';
+    if(negative)
+        ++it;
+
+    /* Digits are accumulated while the mantissa is exact in double */
+    std::uint64_t mantissa = 0;
+    size_t fractionDigits = 0;
+    bool exact = true;
+    bool point = false;
+    const char * digits = it;
+    for( ; it != end ; ++it) {
+        if(*it == '.' && !point && it != digits && it + 1 != end) {
+            point = true;
+            continue;
+        }
+        if(*it < '0' || *it > '9')
+            break;
+        if(mantissa > (MAX_EXACT_MANTISSA - 9) / 10) {
+            exact = false;
+            continue;
+        }
+        mantissa = mantissa * 10 + (*it - '0');
+        if(point)
+            ++fractionDigits;
     }
-    try {
-        float result = std::stod(str);
-        return result;
-    } catch (std::out_of_range) {
-        /* invalid_argument won't be thrown, regex prevents that */
-        throw std::runtime_error("can't convert string \"" + str + "\" into double: " +
+    if(it != end || it == digits)
+        throw std::runtime_error("can't convert string \"" + std::string(begin, end) +
+                                 "\" into double: string contain invalid characters");
+
+    /* Quotient of two exact numbers is correctly rounded,
+     * other numbers are converted by C library */
+    double result = 0;
+    if(exact && fractionDigits < sizeof(POWERS_OF_TEN) / sizeof(POWERS_OF_TEN[0])) {
+        result = static_cast<double>(mantissa) / POWERS_OF_TEN[fractionDigits];
+        return negative ? -result : result;
+    }
+    std::string number (begin, end);
+    result = std::strtod(number.c_str(), nullptr);
+    if(std::isinf(result))
+        throw std::runtime_error("can't convert string \"" + number + "\" into double: " +
                                  "value represented by string is too big");
+    return result;
+}
+
+void Utils::strtodLines(const char * begin, const char * end,
+                        std::vector<double> & values) {
+    values.reserve(values.size() + std::count(begin, end, '\n') + 1);
+    while(begin != end) {
+        const char * lineEnd = std::find(begin, end, '\n');
+        if(lineEnd != begin)
+            values.push_back(strtod(begin, lineEnd));
+        begin = lineEnd == end ? end : lineEnd + 1;
     }
 }
 
@@ -114,6 +228,12 @@ std::string Utils::formatRawTime(const time_t & rawtime ,
     return buffer;
 }
 
+std::string Utils::formatSeconds(double seconds) {
+    std::stringstream rval;
+    rval << std::fixed << std::setprecision(1) << seconds << " s";
+    return rval.str();
+}
+
 std::vector<std::string> Utils::split(const std::string & toSplit , char separator) {
     std::vector<std::string> result;
     std::string temp;
@@ -190,6 +310,60 @@ bool Utils::fileExist(const std::string & name) {
     return file.good();
 }
 
+uint64_t Utils::getFileSize(const std::string & name) {
+    struct stat st;
+    if(stat(name.c_str(), &st) != 0)
+        throw std::runtime_error("can't access file: " + name);
+    return st.st_size;
+}
+
+bool Utils::isDirectory(const std::string & name) {
+    struct stat st;
+    return stat(name.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+std::vector<std::string> Utils::listDirFiles(const std::string & n) {
+    std::string name = n;
+    if(name.back() != '/')
+        name.append("/");
+
+    DIR * d = opendir(name.c_str());
+    if(!d)
+        throw std::runtime_error("can't open directory: " + name);
+
+    std::vector<std::string> rval;
+    struct dirent * p;
+    struct stat st;
+    while((p = readdir(d))) {
+        if(p->d_name[0] == '.')
+            continue;
+
+        std::string filename = name + p->d_name;
+        if(stat(filename.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            rval.push_back(filename);
+    }
+    closedir(d);
+
+    std::sort(rval.begin(), rval.end());
+    return rval;
+}
+
+void Utils::removeDirectory(const std::string & n) {
+    auto removeItem = [](const char * path, const struct stat *, int, struct FTW *) {
+        return remove(path);
+    };
+    /* Depth first, so directories are empty when they are removed */
+    nftw(n.c_str(), removeItem, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+std::string Utils::getAbsolutePath(const std::string & path) {
+    char resolved[PATH_MAX];
+    if(realpath(path.c_str(), resolved) == NULL)
+        return path;
+
+    return resolved;
+}
+
 void Utils::rmDirFiles(const std::string & n) {
     std::string name = n;
     if(name.back() != '/')
@@ -238,6 +412,29 @@ std::string Utils::intToHex(int num, uint width) {
     return rval.str();
 }
 
+std::string Utils::hashString(const std::string & str) {
+    ContentHash hash;
+    hash.update(str.data(), str.length());
+    return hash.digest();
+}
+
+std::string Utils::hashFile(const std::string & path) {
+    std::ifstream file(path , std::ios::in | std::ios::binary);
+    if(!file.is_open())
+        throw std::runtime_error("can't open input file: " + path);
+
+    ContentHash hash;
+    std::vector<char> buffer(1 << 20);
+    while(file) {
+        file.read(buffer.data(), buffer.size());
+        hash.update(buffer.data(), file.gcount());
+    }
+    if(file.bad())
+        throw std::runtime_error("can't read input file: " + path);
+
+    return hash.digest();
+}
+
 std::string Utils::readFileToString(const std::string & path) {
     std::ifstream file(path , std::ios::in);
     if(!file.is_open())
@@ -264,4 +461,12 @@ void Utils::appendStringToFile(const std::string & path, const std::string & sou
     file.close();
 }
 
+void Utils::appendDataToFile(const std::string & path, const char * data, size_t length) {
+    std::ofstream file(path , std::ios::out | std::ios::app | std::ios::binary);
+    if(!file.is_open())
+        throw std::runtime_error("can't open output file: " + path);
+    file.write(data, length);
+    file.close();
+}
+
 } // namespace rtt
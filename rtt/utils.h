@@ -11,11 +11,15 @@
 #include <regex>
 #include <iostream>
 #include <dirent.h>
+#include <ftw.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <algorithm>
 #include <iomanip>
+#include <cstring>
+#include <cstdint>
 
 /* File with global methods declared */
 
@@ -53,8 +57,34 @@ public:
       */
     static float strtof(const std::string & str);
 
+    /** Converts decimal number "-?[0-9]+(.[0-9]+)?" to double
+      * at full precision, validation and conversion is done in
+      * single pass.
+      * @brief strtod           String to double
+      * @param str              string to convert
+      * @return                 converted double
+      * @throws runtime_error   argument is not valid
+      *                         number or number is too big
+      */
     static double strtod(const std::string & str);
 
+    /** Same as strtod(const std::string &), number is given by range
+      * @param begin            start of the number
+      * @param end              end of the number
+      */
+    static double strtod(const char * begin, const char * end);
+
+    /** Converts numbers on separate lines of the buffer, empty
+      * lines are skipped.
+      * @brief strtodLines      Batch version of strtod
+      * @param begin            start of the buffer
+      * @param end              end of the buffer
+      * @param values           converted numbers are appended to it
+      * @throws runtime_error   some line is not valid number
+      */
+    static void strtodLines(const char * begin, const char * end,
+                            std::vector<double> & values);
+
     /** Opens file, reads it into string, closes file, returns string
       * @param path                path to file
       * @return                    content of the file
@@ -72,6 +102,14 @@ public:
 
     static void appendStringToFile(const std::string & path , const std::string & source);
 
+    /** Appends data to the end of the file, file is created if it doesn't exist.
+      * @param path              path to file
+      * @param data              data to be appended
+      * @param length            length of the data in bytes
+      * @throws runtime_error    when file can't be opened
+      */
+    static void appendDataToFile(const std::string & path, const char * data, size_t length);
+
     /** Returns string after last separator in path.
       * If no separator is found, whole path is returned.
       * ../../example returns example
@@ -103,6 +141,13 @@ public:
     static std::string formatRawTime(const time_t & rawtime,
                                      const std::string & format);
 
+    /**
+     * @brief formatSeconds Formats duration for logging
+     * @param seconds
+     * @return Duration with precision to tenths of second, e.g. "12.3 s"
+     */
+    static std::string formatSeconds(double seconds);
+
     /** Splits string into shorter strings, separated by separator
       * @param                 toSplit string to be splitted
       * @return                vector of strings
@@ -135,6 +180,59 @@ public:
      */
     static bool fileExist(const std::string & name);
 
+    /**
+     * @brief getFileSize Returns size of a file, throws if the file can't be accessed
+     * @param name Path to the file
+     * @return Size in bytes
+     */
+    static uint64_t getFileSize(const std::string & name);
+
+    /**
+     * @brief isDirectory Checks whether the path points to a directory
+     * @param name
+     * @return
+     */
+    static bool isDirectory(const std::string & name);
+
+    /**
+     * @brief listDirFiles Lists regular files inside the directory, hidden files
+     * and subdirectories are skipped. Throws if the directory can't be opened.
+     * @param n Path to the directory
+     * @return Paths of the files, sorted by name
+     */
+    static std::vector<std::string> listDirFiles(const std::string & n);
+
+    /**
+     * @brief removeDirectory Removes the directory together with its whole content.
+     * Symbolic links are removed, not followed.
+     * @param n Path to the directory
+     */
+    static void removeDirectory(const std::string & n);
+
+    /**
+     * @brief getAbsolutePath
+     * @param path
+     * @return Absolute canonical form of the path, the path
+     * itself if it can't be resolved
+     */
+    static std::string getAbsolutePath(const std::string & path);
+
+    /**
+     * @brief hashString Computes 128-bit content hash of the string. Hash is
+     * fast and suitable for identifying content, it is not cryptographic.
+     * @param str
+     * @return Hash as 32 hexadecimal characters
+     */
+    static std::string hashString(const std::string & str);
+
+    /**
+     * @brief hashFile Computes 128-bit content hash of the file, same as
+     * hashString of its content. Throws if the file can't be read.
+     * @param path
+     * @return Hash as 32 hexadecimal characters
+     */
+    static std::string hashFile(const std::string & path);
+
     /**
      * @brief rmDirFiles Removes all files inside the directory n
      * @param n Path to the directory
@@ -189,5 +287,11 @@ public:
     }
 };
 
+/* Strings are taken whole, including whitespace */
+template<>
+inline std::string Utils::lexical_cast<std::string>(const std::string & str) {
+    return str;
+}
+
 } // namespace rtt
 #endif // RTT_UTILS_H
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Stands in for dieharder and TestU01 binaries, prints recorded output
+# of the requested test from the fixtures directory. Dieharder is told
+# apart by its -d option, TestU01 by -m.
+fixtures="$(dirname "$0")/fixtures"
+battery=""
+test=""
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -d) battery=dieharder; test="$2"; shift ;;
+        -m) battery="testu01-$2"; shift ;;
+        -t) test="$2"; shift ;;
+    esac
+    shift
+done
+exec cat "$fixtures/$battery-$test.txt"
@@ -0,0 +1,91 @@
+#!/bin/bash
+# Runs the toolkit on recorded outputs of dieharder and TestU01 from fixtures
+# and compares the reports with the expected ones. Lines that differ between
+# runs (date, resource usage) are left out of the comparison.
+# Usage: run-tests.sh <toolkit binary> [--update]
+
+set -u
+
+toolkit="$(realpath "$1")"
+update="${2:-}"
+here="$(cd "$(dirname "$0")" && pwd)"
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/rtt-settings.json" <<SETTINGS
+{
+    "toolkit-settings": {
+        "logger": {
+            "dir-prefix": "results/logs",
+            "run-log-dir": "run-logs",
+            "dieharder-dir": "dieharder",
+            "nist-sts-dir": "niststs",
+            "tu01-smallcrush-dir": "testu01/smallcrush",
+            "tu01-crush-dir": "testu01/crush",
+            "tu01-bigcrush-dir": "testu01/bigcrush",
+            "tu01-rabbit-dir": "testu01/rabbit",
+            "tu01-alphabit-dir": "testu01/alphabit",
+            "tu01-blockalphabit-dir": "testu01/blockalphabit"
+        },
+        "result-storage": {
+            "file": {
+                "main-file": "results/testbed-table.txt",
+                "dir-prefix": "results/reports",
+                "dieharder-dir": "dieharder",
+                "nist-sts-dir": "niststs",
+                "tu01-smallcrush-dir": "testu01/smallcrush",
+                "tu01-crush-dir": "testu01/crush",
+                "tu01-bigcrush-dir": "testu01/bigcrush",
+                "tu01-rabbit-dir": "testu01/rabbit",
+                "tu01-alphabit-dir": "testu01/alphabit",
+                "tu01-blockalphabit-dir": "testu01/blockalphabit"
+            }
+        },
+        "binaries": {
+            "nist-sts": "$here/fake-battery.sh",
+            "dieharder": "$here/fake-battery.sh",
+            "testu01": "$here/fake-battery.sh"
+        },
+        "miscellaneous": {
+            "nist-sts": {
+                "main-result-dir": "experiments/AlgorithmTesting/"
+            }
+        },
+        "execution": {
+            "max-parallel-tests": 2,
+            "test-timeout-seconds": 30
+        }
+    }
+}
+SETTINGS
+head -c 4096 /dev/zero > "$work/input.bin"
+
+failed=0
+run_case() {
+    local battery="$1" config="$2" expected="$here/expected/$3"
+    rm -rf "$work/results"
+    if ! (cd "$work" && "$toolkit" -b "$battery" -c "$here/$config" -f input.bin \
+              > "$work/run.log" 2>&1); then
+        echo "FAIL $battery: toolkit failed, log follows"
+        cat "$work/run.log"
+        failed=1
+        return
+    fi
+    local report
+    report="$(find "$work/results/reports" -name '*-report.txt' | head -n 1)"
+    grep -v -E '^Date:|Wall time:|CPU time:|Max RSS:|I/O:' "$report" > "$work/report.txt"
+    if [ "$update" = "--update" ]; then
+        cp "$work/report.txt" "$expected"
+        echo "UPDATED $battery"
+    elif diff -u "$expected" "$work/report.txt"; then
+        echo "PASS $battery"
+    else
+        echo "FAIL $battery"
+        failed=1
+    fi
+}
+
+run_case dieharder       dieharder.json           dieharder-report.txt
+run_case tu01_smallcrush testu01-smallcrush.json  testu01-smallcrush-report.txt
+
+exit $failed
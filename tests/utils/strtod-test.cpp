@@ -0,0 +1,145 @@
+/* Compares Utils::strtod with std::stod on random numbers of the accepted
+ * grammar and on their mutations, then measures conversion of p-values.
+ * Exits with 1 when some input is converted differently. */
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "rtt/utils.h"
+
+using rtt::Utils;
+
+static const std::regex RE_NUMBER { "-?[0-9]+(\\.[0-9]+)?" };
+
+/* Implementation replaced by the single pass conversion, kept for the benchmark */
+static float regexStrtod(const std::string & str) {
+    static const std::regex RE_FLOAT { "^-?[0-9]+?(:?\\.[0-9]+?)?$" };
+    if(!std::regex_match(str.begin() , str.end() , RE_FLOAT))
+        throw std::runtime_error("invalid number");
+    return std::stod(str);
+}
+
+static std::string randomNumber(std::mt19937_64 & rng) {
+    std::uniform_int_distribution<int> digit('0', '9');
+    std::uniform_int_distribution<int> length(1, 30);
+    std::string number;
+    if(rng() % 4 == 0)
+        number += '-';
+    for(int i = length(rng) ; i > 0 ; --i)
+        number += static_cast<char>(digit(rng));
+    if(rng() % 4 != 0) {
+        number += '.';
+        for(int i = length(rng) ; i > 0 ; --i)
+            number += static_cast<char>(digit(rng));
+    }
+    return number;
+}
+
+static void mutate(std::mt19937_64 & rng, std::string & number) {
+    static const char CHARACTERS[] = "0123456789.-+eE x\n";
+    char c = CHARACTERS[rng() % (sizeof(CHARACTERS) - 1)];
+    size_t position = rng() % (number.size() + 1);
+    switch(rng() % 3) {
+    case 0:
+        number.insert(position, 1, c);
+        break;
+    case 1:
+        if(position < number.size())
+            number.erase(position, 1);
+        break;
+    default:
+        if(position < number.size())
+            number[position] = c;
+    }
+}
+
+static bool compare(const std::string & input) {
+    bool valid = std::regex_match(input, RE_NUMBER);
+    double value = 0;
+    bool converted = true;
+    try {
+        value = Utils::strtod(input);
+    } catch(std::runtime_error &) {
+        converted = false;
+    }
+    if(valid != converted) {
+        std::cout << "FAIL \"" << input << "\": " << (valid ? "rejected" : "accepted")
+                  << std::endl;
+        return false;
+    }
+    double expected = valid ? std::stod(input) : 0;
+    if(valid && std::memcmp(&value, &expected, sizeof(value)) != 0) {
+        std::cout << "FAIL \"" << input << "\": " << std::hexfloat << value
+                  << " instead of " << expected << std::defaultfloat << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template<typename F>
+static double measureMilliseconds(F function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    std::mt19937_64 rng (2017);
+    const int FUZZ_COUNT = 200000;
+    int failed = 0;
+    for(const char * fixed : { "0", "-0", "1", "0.5", "1.0", "0.00000001", "0.99999999",
+                               "9007199254740993", "0.1234567890123456789012345",
+                               "", "-", ".5", "1.", "1..2", "1:.5", "1e-3", "+1", " 1" }) {
+        if(!compare(fixed))
+            ++failed;
+    }
+    for(int i = 0 ; i < FUZZ_COUNT ; ++i) {
+        std::string input = randomNumber(rng);
+        for(int mutations = rng() % 3 ; mutations > 0 ; --mutations)
+            mutate(rng, input);
+        if(!compare(input))
+            ++failed;
+    }
+    std::cout << (failed ? "FAIL" : "PASS") << " strtod: " << FUZZ_COUNT
+              << " random inputs, " << failed << " differ from std::stod" << std::endl;
+
+    /* Dieharder p-values, one per line */
+    const int BENCH_COUNT = 1000000;
+    std::string buffer;
+    std::vector<std::string> lines;
+    char line[16];
+    for(int i = 0 ; i < BENCH_COUNT ; ++i) {
+        snprintf(line, sizeof(line), "0.%08d", static_cast<int>(rng() % 100000000));
+        lines.push_back(line);
+        buffer += line;
+        buffer += '\n';
+    }
+    double sum = 0;
+    double regexTime = measureMilliseconds([&]() {
+        for(const std::string & l : lines)
+            sum += regexStrtod(l);
+    });
+    double stodTime = measureMilliseconds([&]() {
+        for(const std::string & l : lines)
+            sum += std::stod(l);
+    });
+    double strtodTime = measureMilliseconds([&]() {
+        for(const std::string & l : lines)
+            sum += Utils::strtod(l);
+    });
+    std::vector<double> values;
+    double linesTime = measureMilliseconds([&]() {
+        Utils::strtodLines(buffer.data(), buffer.data() + buffer.size(), values);
+    });
+    std::cout << "BENCH " << BENCH_COUNT << " p-values: regex and std::stod "
+              << regexTime << " ms, std::stod " << stodTime << " ms, Utils::strtod "
+              << strtodTime << " ms, Utils::strtodLines " << linesTime << " ms"
+              << " (checksum " << sum + values.size() << ")" << std::endl;
+    return failed ? 1 : 0;
+}